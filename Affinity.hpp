@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace TSC {
+namespace Affinity {
+// Placement of benchmark threads relative to each other. Producer i is
+// paired with consumer i, so that each pair shares the resource named by
+// the layout.
+enum class Layout { None, SameCpu, Siblings, SameL3, CrossSocket };
+
+struct Cpu {
+  int id;
+  int core;
+  int package;
+  // The smallest CPU sharing the last level cache, identifying the L3.
+  int llc;
+};
+
+struct Placement {
+  // Empty vectors mean the scheduler is left in charge.
+  std::vector<int> producers;
+  std::vector<int> consumers;
+};
+
+inline const char *name(Layout layout) {
+  switch (layout) {
+    case Layout::None:
+      return "none";
+    case Layout::SameCpu:
+      return "same-cpu";
+    case Layout::Siblings:
+      return "siblings";
+    case Layout::SameL3:
+      return "same-l3";
+    case Layout::CrossSocket:
+      return "x-socket";
+  }
+  return "unknown";
+}
+
+// Parses the kernel CPU list format, for instance "0-3,8,10-11".
+inline std::vector<int> parseList(const std::string &text) {
+  std::vector<int> cpus;
+  std::stringstream stream{text};
+  std::string range;
+
+  while (std::getline(stream, range, ',')) {
+    auto dash = range.find('-');
+    try {
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first
+                                           : std::stoi(range.substr(dash + 1));
+      for (int cpu{first}; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (const std::exception &e) {
+      break;
+    }
+  }
+  return cpus;
+}
+
+inline std::string readLine(const std::string &path) {
+  std::ifstream in{path};
+  std::string line;
+
+  std::getline(in, line);
+  return line;
+}
+
+// The allowed function returns whether the process may run on the CPU,
+// which cgroup and cpuset limits restrict below the online CPUs. Every CPU
+// is allowed when the mask cannot be read.
+inline bool allowed(int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0 || cpu < 0 ||
+      cpu >= CPU_SETSIZE) {
+    return true;
+  }
+  return CPU_ISSET(cpu, &set) != 0;
+#else
+  (void)cpu;
+  return true;
+#endif
+}
+
+// The topology function describes the online CPUs the process may run on
+// from sysfs. Missing files degrade to one core per CPU on a single socket
+// and a shared L3.
+inline std::vector<Cpu> topology() {
+  const std::string root{"/sys/devices/system/cpu/"};
+  std::vector<Cpu> cpus;
+
+  for (int id : parseList(readLine(root + "online"))) {
+    if (!allowed(id)) {
+      continue;
+    }
+    std::string dir = root + "cpu" + std::to_string(id) + "/";
+    std::vector<int> siblings =
+        parseList(readLine(dir + "topology/thread_siblings_list"));
+    std::vector<int> llc =
+        parseList(readLine(dir + "cache/index3/shared_cpu_list"));
+    std::string package = readLine(dir + "topology/physical_package_id");
+
+    cpus.push_back(Cpu{id, siblings.empty() ? id : siblings.front(),
+                       package.empty() ? 0 : std::stoi(package),
+                       llc.empty() ? 0 : llc.front()});
+  }
+  return cpus;
+}
+
+// The place function assigns a CPU to every producer and consumer for the
+// given layout. It returns false when the machine cannot provide the
+// layout, for instance siblings without SMT or a single socket.
+inline bool place(Layout layout, size_t producers, size_t consumers,
+                  Placement &placement) {
+  std::vector<Cpu> cpus = topology();
+  std::vector<int> first, second;
+  placement = Placement{};
+
+  if (layout == Layout::None) {
+    return true;
+  }
+
+  if (layout == Layout::SameCpu) {
+    // Both ends of a pair time share one logical CPU.
+    for (const auto &cpu : cpus) {
+      first.push_back(cpu.id);
+      second.push_back(cpu.id);
+    }
+  } else if (layout == Layout::Siblings) {
+    // Pairs of hyperthreads of the same core.
+    std::map<int, std::vector<int>> cores;
+    for (const auto &cpu : cpus) {
+      cores[cpu.package * 65536 + cpu.core].push_back(cpu.id);
+    }
+    for (const auto &core : cores) {
+      if (core.second.size() >= 2u) {
+        first.push_back(core.second[0]);
+        second.push_back(core.second[1]);
+      }
+    }
+  } else if (layout == Layout::SameL3) {
+    // Distinct physical cores behind the first last level cache.
+    std::set<int> seen;
+    std::vector<int> cores;
+    for (const auto &cpu : cpus) {
+      if (cpu.llc == cpus.front().llc &&
+          seen.insert(cpu.package * 65536 + cpu.core).second) {
+        cores.push_back(cpu.id);
+      }
+    }
+    for (size_t i{}; i + 1u < cores.size(); i += 2u) {
+      first.push_back(cores[i]);
+      second.push_back(cores[i + 1u]);
+    }
+  } else if (layout == Layout::CrossSocket) {
+    // Producers on the first package, consumers on another one.
+    std::set<int> seen;
+    for (const auto &cpu : cpus) {
+      if (!seen.insert(cpu.package * 65536 + cpu.core).second) {
+        continue;
+      }
+      if (cpu.package == cpus.front().package) {
+        first.push_back(cpu.id);
+      } else {
+        second.push_back(cpu.id);
+      }
+    }
+    size_t pairs = std::min(first.size(), second.size());
+    first.resize(pairs);
+    second.resize(pairs);
+  }
+
+  if (first.empty()) {
+    return false;
+  }
+  for (size_t i{}; i < producers; ++i) {
+    placement.producers.push_back(first[i % first.size()]);
+  }
+  for (size_t i{}; i < consumers; ++i) {
+    placement.consumers.push_back(second[i % second.size()]);
+  }
+  return true;
+}
+
+// Pins the calling thread to a single CPU, returning false on failure.
+inline bool pinCurrentThread(int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpu;
+  return false;
+#endif
+}
+}  // namespace Affinity
+}  // namespace TSC
@@ -0,0 +1,138 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{4u};
+constexpr size_t NB_WAITERS{10000u};
+constexpr size_t NB_ITEMS{8u};
+
+bool isShutdown(std::exception_ptr error) {
+  try {
+    std::rethrow_exception(error);
+  } catch (const TSC::ShutdownException &e) {
+    return true;
+  } catch (...) {
+    return false;
+  }
+}
+
+void futures() {
+  TSC::ThreadSafeContainer<int> mtq{2u};
+  int item;
+
+  auto removal = mtq.asyncRemove();
+  assert(!removal.ready());
+  auto first = mtq.asyncAdd(1);
+  // The item went straight to the pending removal.
+  assert(first.ready() && removal.ready() && mtq.empty());
+  first.get();
+  assert(removal.get() == 1 && !removal.valid());
+
+  mtq.asyncAdd(2).get();
+  mtq.asyncAdd(3).get();
+  auto fourth = mtq.asyncAdd(4);
+  auto fifth = mtq.asyncAdd(5);
+  assert(!fourth.ready() && !fifth.ready());
+  bool removed = mtq.tryRemove(item);
+  assert(removed && item == 2);
+  assert(fourth.ready() && !fifth.ready());
+  assert(mtq.asyncRemove().get() == 3);
+  assert(fifth.waitFor(std::chrono::seconds{1}));
+  assert(mtq.asyncRemove().get() == 4);
+  assert(mtq.asyncRemove().get() == 5);
+
+  TSC::Future<int> broken;
+  {
+    TSC::Promise<int> promise;
+    broken = promise.getFuture();
+  }
+  try {
+    broken.get();
+    assert(false);
+  } catch (const std::future_error &e) {
+    assert(e.code() == std::future_errc::broken_promise);
+  }
+}
+
+// Pending requests fail on shutdown, and pending removals fail on close
+// once the queue is drained.
+void failures() {
+  TSC::ThreadSafeContainer<int> mtq{1u};
+  std::exception_ptr failure;
+  int received{};
+
+  mtq.asyncRemove([&failure, &received](std::exception_ptr error, int item) {
+    failure = error;
+    received = item;
+  });
+  auto removal = mtq.asyncRemove();
+  mtq.asyncAdd(1).get();
+  mtq.close();
+  assert(!failure && received == 1);
+  try {
+    removal.get();
+    assert(false);
+  } catch (const TSC::ShutdownException &e) {
+  }
+
+  TSC::ThreadSafeContainer<int> other{1u};
+  other.asyncAdd(1).get();
+  auto pending = other.asyncAdd(2);
+  other.asyncAdd(3, [&failure](std::exception_ptr error) { failure = error; });
+  other.shutdown();
+  assert(isShutdown(failure));
+  try {
+    pending.get();
+    assert(false);
+  } catch (const TSC::ShutdownException &e) {
+  }
+}
+
+// Thousands of logical waiters are served by a handful of threads.
+void manyWaiters() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  std::atomic<size_t> received{0u};
+  std::atomic<long> sum{0};
+  std::vector<std::thread> writers;
+
+  for (size_t n{}; n < NB_WAITERS; ++n) {
+    mtq.asyncRemove([&received, &sum](std::exception_ptr error, int item) {
+      assert(!error);
+      (void)error;
+      sum += item;
+      ++received;
+    });
+  }
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      for (size_t n{1}; n <= NB_WAITERS / NB_WRITER_THREADS; ++n) {
+        mtq.waitAdd(static_cast<int>(n));
+      }
+    });
+  }
+  for (auto &t : writers) {
+    t.join();
+  }
+
+  assert(received.load() == NB_WAITERS && mtq.empty());
+  size_t perWriter{NB_WAITERS / NB_WRITER_THREADS};
+  assert(sum.load() == static_cast<long>(NB_WRITER_THREADS * perWriter *
+                                         (perWriter + 1u) / 2u));
+}
+
+int main() {
+  futures();
+  failures();
+  manyWaiters();
+
+  std::cout << "async passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BudgetedContainer.hpp"
+#include "RandomGenerator.hpp"
+
+constexpr size_t NB_WRITER_THREADS{4u};
+constexpr size_t NB_QUEUES{2u};
+constexpr size_t NB_PAYLOADS{5000u};
+constexpr size_t NB_ITEMS{64u};
+constexpr size_t BUDGET{4096u};
+constexpr int MAX_PAYLOAD{512};
+
+struct StringSize {
+  size_t operator()(const std::string &item) const { return item.size(); }
+};
+
+using Queue = TSC::BudgetedContainer<std::string, StringSize>;
+
+void waitUntilBlocked(const TSC::MemoryBudget &budget) {
+  while (budget.waiting() == 0u) {
+    std::this_thread::yield();
+  }
+}
+
+// The budget is exhausted across queues, whatever their own capacity.
+void sharedBudget() {
+  TSC::MemoryBudget budget{100u};
+  Queue first{NB_ITEMS, budget}, second{NB_ITEMS, budget};
+  std::string item;
+
+  bool added = first.tryAdd(std::string(60u, 'a'));
+  assert(added);
+  added = second.tryAdd(std::string(50u, 'b'));
+  assert(!added && second.empty());
+  added = second.tryAdd(std::string(40u, 'b'));
+  assert(added);
+  assert(first.bytes() == 60u && second.bytes() == 40u);
+  assert(budget.used() == 100u);
+
+  bool removed = first.tryRemove(item);
+  assert(removed && item.size() == 60u);
+  assert(first.bytes() == 0u && budget.used() == 40u);
+
+  try {
+    first.tryAdd(std::string(101u, 'c'));
+    assert(false);
+  } catch (const std::length_error &e) {
+  }
+
+  second.shutdown();
+  second.clear();
+  assert(second.bytes() == 0u && budget.used() == 0u);
+}
+
+void blocking() {
+  TSC::MemoryBudget budget{100u};
+  Queue first{NB_ITEMS, budget}, second{NB_ITEMS, budget};
+  std::string item;
+
+  first.waitAdd(std::string(100u, 'a'));
+  std::thread writer{[&second] { second.waitAdd(std::string(10u, 'b')); }};
+  waitUntilBlocked(budget);
+  assert(second.empty());
+  first.waitRemove(item);
+  writer.join();
+  assert(second.size() == 1u && budget.used() == 10u);
+
+  // Shutting a queue down wakes its writers waiting for budget.
+  first.waitAdd(std::string(90u, 'a'));
+  std::thread stopped{[&first] {
+    try {
+      first.waitAdd(std::string(20u, 'c'));
+      assert(false);
+    } catch (const TSC::ShutdownException &e) {
+    }
+  }};
+  waitUntilBlocked(budget);
+  first.shutdown();
+  stopped.join();
+  assert(budget.used() == 100u && first.bytes() == 90u);
+}
+
+// A writer waiting for room in a full queue holds no budget, which the
+// other queues can still use.
+void fullQueue() {
+  TSC::MemoryBudget budget{100u};
+  Queue first{1u, budget}, second{NB_ITEMS, budget};
+  std::string item;
+  std::atomic<bool> added{false};
+
+  first.waitAdd(std::string(40u, 'a'));
+  std::thread writer{[&first, &added] {
+    first.waitAdd(std::string(50u, 'b'));
+    added = true;
+  }};
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  assert(!added && budget.used() == 40u);
+  bool pushed = second.tryAdd(std::string(60u, 'c'));
+  assert(pushed && budget.used() == 100u);
+
+  second.waitRemove(item);
+  first.waitRemove(item);
+  writer.join();
+  assert(added && item.size() == 40u);
+  assert(first.bytes() == 50u && budget.used() == 50u);
+}
+
+void concurrent() {
+  TSC::MemoryBudget budget{BUDGET};
+  std::vector<Queue *> queues;
+  std::vector<std::thread> writers, readers;
+  std::atomic<size_t> received{0u};
+
+  for (size_t q{}; q < NB_QUEUES; ++q) {
+    queues.push_back(new Queue{NB_ITEMS, budget});
+  }
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&queues, w] {
+      Queue &queue = *queues[w % NB_QUEUES];
+      for (size_t n{}; n < NB_PAYLOADS; ++n) {
+        queue.waitAdd(std::string(
+            static_cast<size_t>(RND::pick(1, MAX_PAYLOAD)), 'x'));
+      }
+    });
+  }
+  for (size_t q{}; q < NB_QUEUES; ++q) {
+    readers.emplace_back([&queues, &budget, &received, q] {
+      std::string item;
+      for (;;) {
+        try {
+          queues[q]->waitRemove(item);
+        } catch (const TSC::ShutdownException &e) {
+          break;
+        }
+        assert(budget.used() <= BUDGET);
+        ++received;
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  while (received.load() < NB_WRITER_THREADS * NB_PAYLOADS) {
+    std::this_thread::yield();
+  }
+  for (auto queue : queues) {
+    queue->shutdown();
+  }
+  for (auto &t : readers) {
+    t.join();
+  }
+  for (auto queue : queues) {
+    assert(queue->bytes() == 0u);
+    delete queue;
+  }
+  assert(budget.used() == 0u);
+}
+
+int main() {
+  sharedBudget();
+  blocking();
+  fullQueue();
+  concurrent();
+
+  std::cout << "memory budget passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "MemoryBudget.hpp"
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// The BudgetedContainer is a bounded FIFO queue whose items are also
+// charged against a MemoryBudget shared with other containers, the size of
+// each item being given by the SizeOf function. When the budget is
+// exhausted tryAdd fails and waitAdd blocks, whatever the room left in the
+// queue itself. Items are charged before being added and released once
+// removed or cleared, so the budget caps the bytes held by every queue.
+template <typename T, typename SizeOf>
+class BudgetedContainer {
+ public:
+  using size_type = std::size_t;
+
+ private:
+  // An Entry is an item as kept in the queue, along with the bytes it has
+  // charged, which are released when the entry is destroyed.
+  class Entry {
+   private:
+    BudgetedContainer *owner;
+    size_type bytes;
+
+   public:
+    T value;
+
+    Entry() : owner{nullptr}, bytes{0u}, value{} {}
+
+    explicit Entry(const T &item) : owner{nullptr}, bytes{0u}, value{item} {}
+
+    Entry(Entry &&src) noexcept;
+
+    Entry &operator=(Entry &&rhs) noexcept;
+
+    ~Entry() { discharge(); }
+
+    void charge(BudgetedContainer *container, size_type size);
+
+    void discharge();
+  };
+
+  MemoryBudget &budget;
+  SizeOf sizeOf;
+  std::atomic<size_type> usedBytes{0u};
+  std::atomic<bool> inUse{true};
+  ThreadSafeContainer<Entry> queue;
+
+ public:
+  BudgetedContainer(size_type capacity, MemoryBudget &shared,
+                    SizeOf sizeFunction = SizeOf{});
+
+  virtual ~BudgetedContainer();
+
+  BudgetedContainer(const BudgetedContainer &src) = delete;
+
+  BudgetedContainer &operator=(const BudgetedContainer &rhs) = delete;
+
+  bool tryAdd(const T &item);
+
+  void waitAdd(const T &item);
+
+  bool tryRemove(T &item);
+
+  void waitRemove(T &item);
+
+  void shutdown();
+
+  void clear();
+
+  size_type size() const;
+
+  bool empty() const;
+
+  bool full() const;
+
+  // Bytes charged by the items of this queue.
+  size_type bytes() const;
+};
+}  // namespace TSC
+
+#include "BudgetedContainerPrivate.hpp"
@@ -0,0 +1,158 @@
+#pragma once
+
+namespace TSC {
+template <typename T, typename SizeOf>
+BudgetedContainer<T, SizeOf>::Entry::Entry(Entry &&src) noexcept
+    : owner{src.owner}, bytes{src.bytes}, value{std::move(src.value)} {
+  src.owner = nullptr;
+}
+
+template <typename T, typename SizeOf>
+typename BudgetedContainer<T, SizeOf>::Entry &
+BudgetedContainer<T, SizeOf>::Entry::operator=(Entry &&rhs) noexcept {
+  if (this != &rhs) {
+    discharge();
+    owner = rhs.owner;
+    bytes = rhs.bytes;
+    value = std::move(rhs.value);
+    rhs.owner = nullptr;
+  }
+  return *this;
+}
+
+// The charge method records bytes already charged to the budget.
+template <typename T, typename SizeOf>
+void BudgetedContainer<T, SizeOf>::Entry::charge(BudgetedContainer *container,
+                                                 size_type size) {
+  owner = container;
+  bytes = size;
+  owner->usedBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+template <typename T, typename SizeOf>
+void BudgetedContainer<T, SizeOf>::Entry::discharge() {
+  if (owner != nullptr) {
+    owner->usedBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    owner->budget.release(bytes);
+    owner = nullptr;
+  }
+}
+
+template <typename T, typename SizeOf>
+BudgetedContainer<T, SizeOf>::BudgetedContainer(size_type capacity,
+                                                MemoryBudget &shared,
+                                                SizeOf sizeFunction)
+    : budget{shared}, sizeOf{sizeFunction}, queue{capacity} {}
+
+template <typename T, typename SizeOf>
+BudgetedContainer<T, SizeOf>::~BudgetedContainer() {
+  shutdown();
+  clear();
+}
+
+// The tryAdd method returns true if tryAdd succeeds and false if either
+// the budget or the queue is full.
+template <typename T, typename SizeOf>
+bool BudgetedContainer<T, SizeOf>::tryAdd(const T &item) {
+  Entry entry{item};
+  size_type bytes = sizeOf(item);
+
+  if (!inUse.load()) {
+    throw ShutdownException("shutdown");
+  }
+  if (!budget.tryCharge(bytes)) {
+    return false;
+  }
+  entry.charge(this, bytes);
+
+  auto slot = queue.tryReserveAdd();
+  if (!slot) {
+    return false;
+  }
+  slot.emplace(std::move(entry));
+  queue.commitAdd(slot);
+  return true;
+}
+
+// The waitAdd method only keeps its charge while the queue has room: a
+// producer finding the queue full gives the bytes back and waits for room,
+// so that a full queue cannot starve the others sharing the budget.
+template <typename T, typename SizeOf>
+void BudgetedContainer<T, SizeOf>::waitAdd(const T &item) {
+  Entry entry{item};
+  size_type bytes = sizeOf(item);
+
+  for (;;) {
+    if (!budget.charge(bytes, [this] { return !inUse.load(); })) {
+      throw ShutdownException("shutdown");
+    }
+    entry.charge(this, bytes);
+
+    auto slot = queue.tryReserveAdd();
+    if (slot) {
+      slot.emplace(std::move(entry));
+      queue.commitAdd(slot);
+      return;
+    }
+    entry.discharge();
+    queue.waitNotFull();
+  }
+}
+
+template <typename T, typename SizeOf>
+bool BudgetedContainer<T, SizeOf>::tryRemove(T &item) {
+  Entry entry;
+
+  if (!queue.tryRemove(entry)) {
+    return false;
+  }
+  item = std::move(entry.value);
+  return true;
+}
+
+template <typename T, typename SizeOf>
+void BudgetedContainer<T, SizeOf>::waitRemove(T &item) {
+  Entry entry;
+
+  queue.waitRemove(entry);
+  item = std::move(entry.value);
+}
+
+// The shutdown method also wakes the threads of this queue waiting for
+// budget, along with those of other queues which check again.
+template <typename T, typename SizeOf>
+void BudgetedContainer<T, SizeOf>::shutdown() {
+  inUse.store(false);
+  queue.shutdown();
+  budget.wake();
+}
+
+// The clear method releases the bytes of the cleared items. This method
+// will do nothing when called while the queue is still in use.
+template <typename T, typename SizeOf>
+void BudgetedContainer<T, SizeOf>::clear() {
+  queue.clear();
+}
+
+template <typename T, typename SizeOf>
+typename BudgetedContainer<T, SizeOf>::size_type
+BudgetedContainer<T, SizeOf>::size() const {
+  return queue.size();
+}
+
+template <typename T, typename SizeOf>
+bool BudgetedContainer<T, SizeOf>::empty() const {
+  return queue.empty();
+}
+
+template <typename T, typename SizeOf>
+bool BudgetedContainer<T, SizeOf>::full() const {
+  return queue.full();
+}
+
+template <typename T, typename SizeOf>
+typename BudgetedContainer<T, SizeOf>::size_type
+BudgetedContainer<T, SizeOf>::bytes() const {
+  return usedBytes.load(std::memory_order_relaxed);
+}
+}  // namespace TSC
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{3u};
+constexpr size_t NB_READER_THREADS{2u};
+constexpr size_t NB_BATCHES{2000u};
+constexpr size_t BATCH{37u};
+constexpr size_t NB_ITEMS{100u};
+
+struct Pod16 {
+  std::uint64_t low;
+  std::uint64_t high;
+};
+
+static_assert(TSC::IsTriviallyRelocatable<int>::value, "");
+static_assert(TSC::IsTriviallyRelocatable<std::unique_ptr<int>>::value, "");
+static_assert(!TSC::IsTriviallyRelocatable<std::string>::value, "");
+
+// Runs wrapping around the end of the ring are split in two segments.
+void wraparound() {
+  TSC::ThreadSafeContainer<int> mtq{10u};
+  std::vector<int> in{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
+  std::vector<int> out(15u, -1);
+
+  assert(mtq.tryAddBulk(in.data(), 7u) == 7u);
+  assert(mtq.tryRemoveBulk(out.data(), 5u) == 5u);
+  assert(mtq.tryAddBulk(in.data() + 7u, 8u) == 8u);
+  assert(mtq.full() && mtq.tryAddBulk(in.data(), 1u) == 0u);
+  assert(mtq.tryRemoveBulk(out.data() + 5u, 20u) == 10u);
+  assert(out == in);
+}
+
+// Bulk transfers keep the order set by reservations, and removals skip
+// cancelled reservations.
+void reservations() {
+  TSC::ThreadSafeContainer<int> mtq{8u};
+  std::vector<int> in{2, 3, 4}, out(8u, 0);
+
+  auto first = mtq.reserveAdd();
+  auto cancelled = mtq.reserveAdd();
+  mtq.tryAddBulk(in.data(), in.size());
+  assert(mtq.empty());
+  *first.get() = 1;
+  mtq.commitAdd(first);
+  assert(mtq.size() == 1u);
+  {
+    auto dropped = std::move(cancelled);
+  }
+  assert(mtq.tryRemoveBulk(out.data(), 8u) == 4u);
+  assert(out[0] == 1 && out[1] == 2 && out[2] == 3 && out[3] == 4);
+}
+
+void relocatable() {
+  TSC::ThreadSafeContainer<std::unique_ptr<int>> mtq{4u};
+  std::vector<std::unique_ptr<int>> in, out(6u);
+
+  for (int n{}; n < 6; ++n) {
+    in.emplace_back(new int{n});
+  }
+  auto moved = std::make_move_iterator(in.begin());
+  assert(mtq.tryAddBulk(moved, 3u) == 3u);
+  assert(mtq.tryRemoveBulk(out.data(), 2u) == 2u);
+  assert(mtq.tryAddBulk(moved + 3, 3u) == 3u);
+  assert(mtq.tryRemoveBulk(out.data() + 2u, 6u) == 4u);
+  for (int n{}; n < 6; ++n) {
+    assert(!in[n] && *out[n] == n);
+  }
+
+  // Destination items are released before being overwritten.
+  mtq.waitAdd(std::unique_ptr<int>{new int{6}});
+  assert(mtq.tryRemoveBulk(out.data(), 1u) == 1u && *out[0] == 6);
+
+  TSC::ThreadSafeContainer<std::string> strings{4u};
+  std::vector<std::string> words{"a", "b", "c"}, read(3u);
+  strings.tryAddBulk(words.data(), words.size());
+  assert(strings.tryRemoveBulk(read.data(), 3u) == 3u && read == words);
+}
+
+// Every kernel copies every length at every source and destination
+// alignment, streaming stores included.
+void copyKernels() {
+  const size_t length{TSC::Simd::STREAM_THRESHOLD + 300u};
+  std::vector<unsigned char> source(length + 64u), target(length + 64u);
+
+  for (size_t i{}; i < source.size(); ++i) {
+    source[i] = static_cast<unsigned char>(i * 7u + 1u);
+  }
+  // The widest supported kernel is used until another one is selected.
+  assert(TSC::Simd::current(TSC::Simd::best()));
+  for (auto kernel : {TSC::Simd::Kernel::Scalar, TSC::Simd::Kernel::Sse2,
+                      TSC::Simd::Kernel::Avx2}) {
+    if (!TSC::Simd::select(kernel)) {
+      continue;
+    }
+    for (size_t bytes : {size_t{0u}, size_t{63u}, size_t{64u}, size_t{200u},
+                         size_t{4099u}, length}) {
+      for (size_t from{}; from < 4u; ++from) {
+        for (size_t to{}; to < 4u; ++to) {
+          std::fill(target.begin(), target.end(), 0u);
+          TSC::Simd::copy(target.data() + to * 9u,
+                          source.data() + from * 5u, bytes);
+          assert(std::equal(source.begin() + from * 5u,
+                            source.begin() + from * 5u + bytes,
+                            target.begin() + to * 9u));
+          assert(to == 0u || target[to * 9u - 1u] == 0u);
+          assert(target[to * 9u + bytes] == 0u);
+        }
+      }
+    }
+
+    // 16-byte items wrapping around the end of the ring.
+    TSC::ThreadSafeContainer<Pod16> mtq{NB_ITEMS};
+    std::vector<Pod16> in(NB_ITEMS), out(NB_ITEMS);
+    for (size_t n{}; n < NB_ITEMS; ++n) {
+      in[n] = Pod16{n, ~std::uint64_t{n}};
+    }
+    assert(mtq.tryAddBulk(in.data(), 60u) == 60u);
+    assert(mtq.tryRemoveBulk(out.data(), 50u) == 50u);
+    assert(mtq.tryAddBulk(in.data() + 60u, 40u) == 40u);
+    assert(mtq.tryRemoveBulk(out.data() + 50u, NB_ITEMS) == 50u);
+    for (size_t n{}; n < NB_ITEMS; ++n) {
+      assert(out[n].low == n && out[n].high == ~std::uint64_t{n});
+    }
+  }
+  TSC::Simd::select(TSC::Simd::defaultKernel());
+}
+
+void concurrent() {
+  TSC::ThreadSafeContainer<size_t> mtq{NB_ITEMS};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> sums(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      std::vector<size_t> batch(BATCH);
+      for (size_t n{}; n < NB_BATCHES; ++n) {
+        for (size_t i{}; i < BATCH; ++i) {
+          batch[i] = n * BATCH + i;
+        }
+        mtq.waitAddBulk(batch.data(), BATCH);
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &sums, r] {
+      std::vector<size_t> batch(BATCH);
+      try {
+        for (;;) {
+          size_t count = mtq.waitRemoveBulk(batch.data(), BATCH);
+          for (size_t i{}; i < count; ++i) {
+            sums[r] += batch[i];
+          }
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  size_t total{}, items{NB_BATCHES * BATCH};
+  for (auto sum : sums) {
+    total += sum;
+  }
+  assert(total == NB_WRITER_THREADS * items * (items - 1u) / 2u);
+}
+
+int main() {
+  wraparound();
+  reservations();
+  relocatable();
+  copyKernels();
+  concurrent();
+
+  std::cout << "bulk transfer passed" << std::endl;
+
+  return 0;
+}
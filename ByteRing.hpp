@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+namespace detail {
+// Records are stored contiguously as a 32-bit length followed by the
+// payload, padded to a multiple of 4 bytes. A record never wraps around:
+// when it does not fit before the end of the buffer, a padding marker
+// fills the end and the record starts over at the beginning. Positions
+// are byte counters that only grow, the buffer size being a power of two.
+class ByteRingLayout {
+ private:
+  static constexpr std::uint32_t PADDING{0xffffffffu};
+  static constexpr std::size_t HEADER{sizeof(std::uint32_t)};
+
+  std::unique_ptr<char[]> buffer;
+  std::size_t bytes;
+
+  static std::size_t roundUp(std::size_t size) {
+    return (size + HEADER - 1u) & ~(HEADER - 1u);
+  }
+
+ public:
+  explicit ByteRingLayout(std::size_t capacity);
+
+  std::size_t capacity() const { return bytes; }
+
+  // Largest payload a record may hold.
+  std::size_t maxRecord() const { return bytes - HEADER; }
+
+  // The restart method returns where an empty ring takes a record of the
+  // given size: the tail, or the next turn of the buffer when the record
+  // does not fit before its end. The head then moves along with the tail,
+  // so no padding is needed, and a record of maxRecord always fits.
+  std::uint64_t restart(std::uint64_t tail, std::size_t size) const;
+
+  // The write method returns the new tail, or the old one when there is
+  // not enough room between the tail and the head.
+  std::uint64_t write(std::uint64_t head, std::uint64_t tail, const void *data,
+                      std::size_t size);
+
+  // The read method passes the record at head to the callback and returns
+  // the position following it. The buffer must not be empty.
+  template <typename Callback>
+  std::uint64_t read(std::uint64_t head, Callback &&callback) const;
+};
+}  // namespace detail
+
+// The ByteRing is a bounded queue of variable length byte records for
+// multiple producers and multiple consumers, guarded by a mutex like
+// ThreadSafeContainer. Records are copied in once and handed to the read
+// callbacks in place, so callbacks run under the lock and should be short.
+// Batched reads hand several records over within one critical section.
+class ByteRing {
+ private:
+  mutable std::mutex mtx;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+  detail::ByteRingLayout layout;
+  std::uint64_t head;
+  std::uint64_t tail;
+  std::size_t records;
+  bool inUse;
+
+  std::uint64_t append(const void *data, std::size_t size);
+
+  template <typename Callback>
+  std::size_t readLocked(Callback &callback, std::size_t maxRecords);
+
+ public:
+  explicit ByteRing(std::size_t capacity);
+
+  ByteRing(const ByteRing &src) = delete;
+
+  ByteRing &operator=(const ByteRing &rhs) = delete;
+
+  bool tryWrite(const void *data, std::size_t size);
+
+  void waitWrite(const void *data, std::size_t size);
+
+  template <typename Callback>
+  bool tryRead(Callback &&callback);
+
+  template <typename Callback>
+  void waitRead(Callback &&callback);
+
+  template <typename Callback>
+  std::size_t tryReadBatch(Callback &&callback, std::size_t maxRecords);
+
+  template <typename Callback>
+  std::size_t waitReadBatch(Callback &&callback, std::size_t maxRecords);
+
+  void shutdown();
+
+  std::size_t size() const;
+
+  std::size_t bytes() const;
+
+  bool empty() const;
+};
+
+// The SpscByteRing is the lock-free flavour for exactly one producer
+// thread and one consumer thread. Each side owns its position and only
+// reads the other one, and never blocks.
+class SpscByteRing {
+ private:
+  detail::ByteRingLayout layout;
+  alignas(64) std::atomic<std::uint64_t> head;
+  alignas(64) std::atomic<std::uint64_t> tail;
+
+ public:
+  explicit SpscByteRing(std::size_t capacity);
+
+  SpscByteRing(const SpscByteRing &src) = delete;
+
+  SpscByteRing &operator=(const SpscByteRing &rhs) = delete;
+
+  bool tryWrite(const void *data, std::size_t size);
+
+  template <typename Callback>
+  bool tryRead(Callback &&callback);
+
+  template <typename Callback>
+  std::size_t tryReadBatch(Callback &&callback, std::size_t maxRecords);
+
+  bool empty() const;
+};
+}  // namespace TSC
+
+#include "ByteRingPrivate.hpp"
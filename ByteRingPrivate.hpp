@@ -0,0 +1,296 @@
+#pragma once
+
+namespace TSC {
+namespace detail {
+inline ByteRingLayout::ByteRingLayout(std::size_t capacity) : bytes{8u} {
+  if (capacity > (std::size_t{1u} << 31)) {
+    throw std::length_error("byte ring capacity too large");
+  }
+  while (bytes < capacity) {
+    bytes *= 2u;
+  }
+  buffer.reset(new char[bytes]);
+}
+
+inline std::uint64_t ByteRingLayout::restart(std::uint64_t tail,
+                                             std::size_t size) const {
+  std::size_t offset = static_cast<std::size_t>(tail) & (bytes - 1u);
+
+  if (size > maxRecord() || roundUp(HEADER + size) <= bytes - offset) {
+    return tail;
+  }
+  return tail + (bytes - offset);
+}
+
+inline std::uint64_t ByteRingLayout::write(std::uint64_t head,
+                                           std::uint64_t tail,
+                                           const void *data,
+                                           std::size_t size) {
+  if (size > maxRecord()) {
+    throw std::length_error("record larger than the byte ring");
+  }
+
+  std::size_t needed = roundUp(HEADER + size);
+  std::size_t offset = static_cast<std::size_t>(tail) & (bytes - 1u);
+  std::size_t padding = needed > bytes - offset ? bytes - offset : 0u;
+
+  if (static_cast<std::size_t>(tail - head) + padding + needed > bytes) {
+    return tail;
+  }
+
+  if (padding != 0u) {
+    std::uint32_t marker{PADDING};
+    std::memcpy(buffer.get() + offset, &marker, HEADER);
+    offset = 0u;
+  }
+  auto length = static_cast<std::uint32_t>(size);
+  std::memcpy(buffer.get() + offset, &length, HEADER);
+  if (size != 0u) {
+    std::memcpy(buffer.get() + offset + HEADER, data, size);
+  }
+  return tail + padding + needed;
+}
+
+template <typename Callback>
+std::uint64_t ByteRingLayout::read(std::uint64_t head,
+                                   Callback &&callback) const {
+  std::size_t offset = static_cast<std::size_t>(head) & (bytes - 1u);
+  std::uint32_t length;
+
+  std::memcpy(&length, buffer.get() + offset, HEADER);
+  if (length == PADDING) {
+    head += bytes - offset;
+    offset = 0u;
+    std::memcpy(&length, buffer.get(), HEADER);
+  }
+  callback(static_cast<const char *>(buffer.get() + offset + HEADER),
+           static_cast<std::size_t>(length));
+  return head + roundUp(HEADER + length);
+}
+}  // namespace detail
+
+inline ByteRing::ByteRing(std::size_t capacity)
+    : layout{capacity}, head{0u}, tail{0u}, records{0u}, inUse{true} {}
+
+// The append method realigns an empty ring before writing, so that any
+// record up to maxRecord fits once the readers caught up.
+inline std::uint64_t ByteRing::append(const void *data, std::size_t size) {
+  if (records == 0u) {
+    head = tail = layout.restart(tail, size);
+  }
+  return layout.write(head, tail, data, size);
+}
+
+// The tryWrite method returns true if tryWrite succeeds
+// and false if the record does not fit.
+inline bool ByteRing::tryWrite(const void *data, std::size_t size) {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  if (!inUse) {
+    throw ShutdownException("shutdown");
+  }
+
+  std::uint64_t next = append(data, size);
+  if (next == tail) {
+    return false;
+  }
+  tail = next;
+  // We signal to potential readers in case
+  // the queue was previously empty.
+  if (++records == 1u) {
+    notEmpty.notify_all();
+  }
+  return true;
+}
+
+inline void ByteRing::waitWrite(const void *data, std::size_t size) {
+  std::unique_lock<std::mutex> lock{mtx};
+  std::uint64_t next{tail};
+
+  // Waits until the record fits. Records of different sizes are
+  // waited for, so every read wakes the writers up.
+  notFull.wait(lock, [&] {
+    return !inUse || (next = append(data, size)) != tail;
+  });
+
+  if (!inUse) {
+    throw ShutdownException("shutdown");
+  }
+
+  tail = next;
+  if (++records == 1u) {
+    notEmpty.notify_all();
+  }
+}
+
+template <typename Callback>
+std::size_t ByteRing::readLocked(Callback &callback, std::size_t maxRecords) {
+  // We signal to potential writers as the room they wait for may now be
+  // available, even when a callback throws after earlier records.
+  struct Notify {
+    std::condition_variable &notFull;
+    std::size_t count;
+
+    ~Notify() {
+      if (count > 0u) {
+        notFull.notify_all();
+      }
+    }
+  } notify{notFull, 0u};
+
+  while (notify.count < maxRecords && records > 0u) {
+    head = layout.read(head, callback);
+    --records;
+    ++notify.count;
+  }
+  return notify.count;
+}
+
+// The tryRead method passes the oldest record to the callback and returns
+// true, or returns false if the ring is empty.
+template <typename Callback>
+bool ByteRing::tryRead(Callback &&callback) {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  if (!inUse) {
+    throw ShutdownException("shutdown");
+  }
+
+  return readLocked(callback, 1u) == 1u;
+}
+
+template <typename Callback>
+void ByteRing::waitRead(Callback &&callback) {
+  std::unique_lock<std::mutex> lock{mtx};
+
+  notEmpty.wait(lock, [this] { return !((records == 0u) && inUse); });
+
+  if (!inUse) {
+    throw ShutdownException("shutdown");
+  }
+
+  readLocked(callback, 1u);
+}
+
+// The tryReadBatch method passes up to maxRecords records to the
+// callback within one critical section, and returns their number.
+template <typename Callback>
+std::size_t ByteRing::tryReadBatch(Callback &&callback,
+                                   std::size_t maxRecords) {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  if (!inUse) {
+    throw ShutdownException("shutdown");
+  }
+
+  return readLocked(callback, maxRecords);
+}
+
+// The waitReadBatch method blocks until at least one record is available.
+template <typename Callback>
+std::size_t ByteRing::waitReadBatch(Callback &&callback,
+                                    std::size_t maxRecords) {
+  std::unique_lock<std::mutex> lock{mtx};
+
+  notEmpty.wait(lock, [this] { return !((records == 0u) && inUse); });
+
+  if (!inUse) {
+    throw ShutdownException("shutdown");
+  }
+
+  return readLocked(callback, maxRecords);
+}
+
+inline void ByteRing::shutdown() {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  inUse = false;
+  notEmpty.notify_all();
+  notFull.notify_all();
+}
+
+// Number of records held in the ring.
+inline std::size_t ByteRing::size() const {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  return records;
+}
+
+// Number of bytes held in the ring, including headers and padding.
+inline std::size_t ByteRing::bytes() const {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  return static_cast<std::size_t>(tail - head);
+}
+
+inline bool ByteRing::empty() const {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  return records == 0u;
+}
+
+inline SpscByteRing::SpscByteRing(std::size_t capacity)
+    : layout{capacity}, head{0u}, tail{0u} {}
+
+// The tryWrite method must only be called by the producer thread.
+// An empty ring is realigned by the producer moving the head along with
+// the tail, as the consumer leaves the head alone until the tail moves.
+inline bool SpscByteRing::tryWrite(const void *data, std::size_t size) {
+  std::uint64_t current = tail.load(std::memory_order_relaxed);
+  std::uint64_t first = head.load(std::memory_order_acquire);
+
+  if (first == current) {
+    first = layout.restart(current, size);
+    if (first != current) {
+      head.store(first, std::memory_order_relaxed);
+      current = first;
+    }
+  }
+  std::uint64_t next = layout.write(first, current, data, size);
+  if (next == current) {
+    return false;
+  }
+  tail.store(next, std::memory_order_release);
+  return true;
+}
+
+// The tryRead method must only be called by the consumer thread.
+template <typename Callback>
+bool SpscByteRing::tryRead(Callback &&callback) {
+  return tryReadBatch(std::forward<Callback>(callback), 1u) == 1u;
+}
+
+// The tryReadBatch method publishes the consumed room once per batch. The
+// head is read after the tail, and may then be ahead of it while the
+// producer realigns the empty ring.
+template <typename Callback>
+std::size_t SpscByteRing::tryReadBatch(Callback &&callback,
+                                       std::size_t maxRecords) {
+  std::uint64_t end = tail.load(std::memory_order_acquire);
+  std::uint64_t current = head.load(std::memory_order_relaxed);
+  std::size_t count{};
+
+  try {
+    while (count < maxRecords && current < end) {
+      current = layout.read(current, callback);
+      ++count;
+    }
+  } catch (...) {
+    // The records handed over before the failure are consumed.
+    if (count > 0u) {
+      head.store(current, std::memory_order_release);
+    }
+    throw;
+  }
+  if (count > 0u) {
+    head.store(current, std::memory_order_release);
+  }
+  return count;
+}
+
+inline bool SpscByteRing::empty() const {
+  std::uint64_t end = tail.load(std::memory_order_acquire);
+
+  return head.load(std::memory_order_acquire) >= end;
+}
+}  // namespace TSC
@@ -0,0 +1,231 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ByteRing.hpp"
+#include "RandomGenerator.hpp"
+
+constexpr size_t NB_WRITER_THREADS{3u};
+constexpr size_t NB_READER_THREADS{2u};
+constexpr size_t NB_RECORDS{20000u};
+constexpr size_t CAPACITY{1024u};
+constexpr size_t BATCH{16u};
+constexpr int MAX_RECORD{100};
+
+// Records are filled with their length modulo 256, so that
+// readers can check them.
+std::vector<char> makeRecord(size_t size) {
+  return std::vector<char>(size, static_cast<char>(size & 0xffu));
+}
+
+bool validRecord(const char *data, size_t size) {
+  for (size_t i{}; i < size; ++i) {
+    if (data[i] != static_cast<char>(size & 0xffu)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void wraparound() {
+  TSC::ByteRing ring{64u};
+  std::string read;
+  auto reader = [&read](const char *data, size_t size) {
+    read.assign(data, size);
+  };
+
+  // 20 byte payloads take 24 bytes, so the third record of each round
+  // does not fit before the end and is preceded by padding.
+  for (int round{}; round < 10; ++round) {
+    std::string first(20u, static_cast<char>('a' + round));
+    std::string second(20u, static_cast<char>('A' + round));
+    bool written = ring.tryWrite(first.data(), first.size());
+    assert(written);
+    written = ring.tryWrite(second.data(), second.size());
+    assert(written);
+    bool readOne = ring.tryRead(reader);
+    assert(readOne && read == first);
+    readOne = ring.tryRead(reader);
+    assert(readOne && read == second);
+  }
+  assert(ring.empty() && ring.bytes() == 0u);
+
+  bool written = ring.tryWrite("", 0u);
+  assert(written);
+  bool readOne = ring.tryRead(reader);
+  assert(readOne && read.empty());
+
+  try {
+    std::vector<char> huge(64u);
+    ring.tryWrite(huge.data(), huge.size());
+    assert(false);
+  } catch (const std::length_error &e) {
+  }
+}
+
+// Once drained, the ring realigns so that a record up to maxRecord fits
+// whatever the position odd-sized records left it at.
+void nearMaximumRecords() {
+  TSC::ByteRing ring{CAPACITY};
+  TSC::SpscByteRing spsc{CAPACITY};
+  size_t read{};
+  auto reader = [&read](const char *data, size_t size) {
+    assert(validRecord(data, size));
+    (void)data;
+    read = size;
+  };
+
+  for (size_t odd : {600u, 37u, 1u, 999u, 513u}) {
+    for (size_t size : {odd, CAPACITY - 4u, CAPACITY - 100u}) {
+      auto record = makeRecord(size);
+      bool written = ring.tryWrite(record.data(), record.size());
+      assert(written);
+      bool readOne = ring.tryRead(reader);
+      assert(readOne && read == size);
+      written = spsc.tryWrite(record.data(), record.size());
+      assert(written);
+      readOne = spsc.tryRead(reader);
+      assert(readOne && read == size && spsc.empty());
+    }
+  }
+  assert(ring.empty() && ring.bytes() == 0u);
+
+  // A throwing callback still wakes up the writers waiting for room.
+  auto large = makeRecord(400u);
+  bool written = ring.tryWrite(large.data(), large.size()) &&
+                 ring.tryWrite(large.data(), large.size());
+  assert(written && !ring.tryWrite(large.data(), large.size()));
+  std::thread writer{[&ring, &large] {
+    ring.waitWrite(large.data(), large.size());
+  }};
+  size_t calls{};
+  try {
+    ring.tryReadBatch(
+        [&calls](const char *, size_t) {
+          if (++calls == 2u) {
+            throw std::runtime_error("callback");
+          }
+        },
+        BATCH);
+  } catch (const std::runtime_error &e) {
+  }
+  writer.join();
+  assert(calls == 2u && ring.size() == 2u);
+}
+
+void batches() {
+  TSC::ByteRing ring{CAPACITY};
+  size_t count{}, written{};
+
+  while (ring.tryWrite(&written, sizeof(written))) {
+    ++written;
+  }
+  assert(ring.size() == written);
+  size_t read = ring.tryReadBatch(
+      [&count](const char *data, size_t size) {
+        size_t value;
+        assert(size == sizeof(value));
+        std::memcpy(&value, data, size);
+        assert(value == count);
+        ++count;
+      },
+      BATCH);
+  assert(read == BATCH && count == BATCH);
+  assert(ring.size() == written - BATCH);
+}
+
+void multipleProducersConsumers() {
+  TSC::ByteRing ring{CAPACITY};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> counts(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&ring] {
+      for (size_t n{}; n < NB_RECORDS; ++n) {
+        auto record = makeRecord(static_cast<size_t>(RND::pick(0, MAX_RECORD)));
+        ring.waitWrite(record.data(), record.size());
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&ring, &counts, r] {
+      try {
+        for (;;) {
+          counts[r] += ring.waitReadBatch(
+              [](const char *data, size_t size) {
+                assert(validRecord(data, size));
+                (void)data;
+                (void)size;
+              },
+              BATCH);
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  while (!ring.empty()) {
+    std::this_thread::yield();
+  }
+  ring.shutdown();
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  size_t total{};
+  for (auto count : counts) {
+    total += count;
+  }
+  assert(total == NB_WRITER_THREADS * NB_RECORDS);
+}
+
+void singleProducerConsumer() {
+  TSC::SpscByteRing ring{CAPACITY};
+  std::thread writer{[&ring] {
+    for (size_t n{}; n < NB_RECORDS; ++n) {
+      std::vector<char> record(sizeof(n) + n % MAX_RECORD, 'x');
+      std::memcpy(record.data(), &n, sizeof(n));
+      while (!ring.tryWrite(record.data(), record.size())) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+
+  size_t expected{};
+  while (expected < NB_RECORDS) {
+    size_t read = ring.tryReadBatch(
+        [&expected](const char *data, size_t size) {
+          size_t value;
+          std::memcpy(&value, data, sizeof(value));
+          assert(value == expected);
+          assert(size == sizeof(value) + value % MAX_RECORD);
+          (void)size;
+          ++expected;
+        },
+        BATCH);
+    if (read == 0u) {
+      std::this_thread::yield();
+    }
+  }
+  writer.join();
+  assert(ring.empty());
+}
+
+int main() {
+  wraparound();
+  nearMaximumRecords();
+  batches();
+  multipleProducersConsumers();
+  singleProducerConsumer();
+
+  std::cout << "byte ring passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+
+constexpr size_t NB_READER_THREADS{4u};
+constexpr size_t NB_ITEMS{2u};
+
+void callbacks() {
+  TSC::StopSource source;
+  TSC::StopToken token = source.get_token();
+  int calls{};
+
+  assert(token.stop_possible() && !token.stop_requested());
+  assert(!TSC::StopToken{}.stop_possible());
+  {
+    TSC::StopCallback<std::function<void()>> dropped{token, [&] { ++calls; }};
+  }
+  TSC::StopCallback<std::function<void()>> kept{token, [&] { calls += 10; }};
+  assert(source.request_stop());
+  assert(!source.request_stop());
+  assert(token.stop_requested() && calls == 10);
+
+  // Callbacks registered after the stop run at once.
+  TSC::StopCallback<std::function<void()>> late{token, [&] { ++calls; }};
+  assert(calls == 11);
+}
+
+// Only the waiter whose stop is requested leaves, and the container
+// remains in use for the others.
+void targeted() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  std::vector<TSC::StopSource> sources(NB_READER_THREADS);
+  std::vector<std::thread> readers;
+  std::atomic<size_t> cancelled{0u}, received{0u};
+
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&, r] {
+      int item;
+      try {
+        for (;;) {
+          if (!mtq.waitRemove(item, sources[r].get_token())) {
+            ++cancelled;
+            return;
+          }
+          ++received;
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  sources[0].request_stop();
+  readers[0].join();
+  assert(cancelled == 1u);
+  mtq.waitAdd(1);
+  mtq.waitAdd(2);
+  while (received != 2u) {
+    std::this_thread::yield();
+  }
+
+  mtq.shutdown();
+  for (size_t r{1}; r < NB_READER_THREADS; ++r) {
+    readers[r].join();
+  }
+  assert(cancelled == 1u);
+}
+
+void adders() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  TSC::StopSource source;
+  int item;
+
+  // Items available are removed whatever the token.
+  source.request_stop();
+  mtq.waitAdd(1);
+  assert(mtq.waitRemove(item, source.get_token()) && item == 1);
+  assert(!mtq.waitRemove(item, source.get_token()));
+  assert(mtq.waitAdd(2, source.get_token()));
+  assert(mtq.waitAdd(3, source.get_token()));
+  assert(!mtq.waitAdd(4, source.get_token()));
+
+  TSC::StopSource writer;
+  std::thread blocked{[&mtq, &writer] {
+    bool added = mtq.waitAdd(5, writer.get_token());
+    assert(!added);
+    (void)added;
+  }};
+  writer.request_stop();
+  blocked.join();
+  assert(mtq.size() == 2u);
+
+  mtq.shutdown();
+  bool failed{false};
+  try {
+    mtq.waitRemove(item, TSC::StopSource{}.get_token());
+  } catch (const TSC::ShutdownException &e) {
+    failed = true;
+  }
+  assert(failed);
+}
+
+#ifdef __cpp_lib_jthread
+// Workers of std::jthread leave when their own stop is requested.
+void jthreads() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  std::atomic<int> sum{0};
+  std::jthread worker{[&](std::stop_token token) {
+    int item;
+    while (mtq.waitRemove(item, token)) {
+      sum += item;
+    }
+  }};
+
+  mtq.waitAdd(1);
+  mtq.waitAdd(2);
+  while (sum != 3) {
+    std::this_thread::yield();
+  }
+  worker.request_stop();
+  worker.join();
+}
+#endif
+
+int main() {
+  callbacks();
+  targeted();
+  adders();
+#ifdef __cpp_lib_jthread
+  jthreads();
+#endif
+
+  std::cout << "cancel passed" << std::endl;
+
+  return 0;
+}
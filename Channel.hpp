@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+enum class ChannelStatus { Success, Full, Empty, Disconnected };
+
+template <typename T>
+class Sender;
+
+template <typename T>
+class Receiver;
+
+template <typename T>
+std::pair<Sender<T>, Receiver<T>> makeChannel(std::size_t capacity);
+
+namespace detail {
+// The ChannelCore is the container shared by the handles of a channel. The
+// sender and receiver counts are guarded by the container mutex, so that
+// handles never need a lock of their own. When the last sender goes away,
+// the container is closed and receivers drain the remaining items. When
+// the last receiver goes away, the container is shut down and senders are
+// disconnected. The last handle deletes the core.
+template <typename T>
+class ChannelCore : public ThreadSafeContainer<T> {
+ private:
+  std::size_t senders;
+  std::size_t receivers;
+  std::size_t handles;
+
+ public:
+  explicit ChannelCore(std::size_t capacity)
+      : ThreadSafeContainer<T>{capacity},
+        senders{1u},
+        receivers{1u},
+        handles{2u} {}
+
+  void attach(bool sender) {
+    std::lock_guard<std::mutex> lock{this->mtx};
+
+    ++(sender ? senders : receivers);
+    ++handles;
+  }
+
+  // The detach method returns true when no handle is left. The close and
+  // shutdown methods, which take the mutex themselves, are called once the
+  // counts are updated, and a handle only stops counting afterwards so
+  // that the core outlives them.
+  bool detach(bool sender) {
+    bool last{};
+    {
+      std::lock_guard<std::mutex> lock{this->mtx};
+      last = sender ? --senders == 0u : --receivers == 0u;
+    }
+    if (last && sender) {
+      this->close();
+    } else if (last) {
+      this->shutdown();
+    }
+
+    std::lock_guard<std::mutex> lock{this->mtx};
+    return --handles == 0u;
+  }
+};
+
+template <typename T>
+void release(ChannelCore<T> *&core, bool sender) {
+  if (core != nullptr && core->detach(sender)) {
+    delete core;
+  }
+  core = nullptr;
+}
+}  // namespace detail
+
+// The Sender handle adds items to a channel. Copying a Sender registers
+// another producer, and the channel closes once every Sender is gone.
+template <typename T>
+class Sender {
+ private:
+  detail::ChannelCore<T> *core;
+
+  explicit Sender(detail::ChannelCore<T> *shared) : core{shared} {}
+
+  friend std::pair<Sender<T>, Receiver<T>> makeChannel<T>(std::size_t);
+
+ public:
+  Sender(const Sender &src) : core{src.core} {
+    if (core != nullptr) {
+      core->attach(true);
+    }
+  }
+
+  Sender(Sender &&src) noexcept : core{src.core} { src.core = nullptr; }
+
+  Sender &operator=(Sender rhs) noexcept {
+    std::swap(core, rhs.core);
+    return *this;
+  }
+
+  ~Sender() { detail::release(core, true); }
+
+  // The send method blocks while the channel is full, and returns
+  // false if every receiver is gone or the handle was moved from.
+  bool send(const T &item) {
+    if (core == nullptr) {
+      return false;
+    }
+    try {
+      core->waitAdd(item);
+      return true;
+    } catch (const ShutdownException &e) {
+      return false;
+    }
+  }
+
+  ChannelStatus trySend(const T &item) {
+    if (core == nullptr) {
+      return ChannelStatus::Disconnected;
+    }
+    try {
+      return core->tryAdd(item) ? ChannelStatus::Success : ChannelStatus::Full;
+    } catch (const ShutdownException &e) {
+      return ChannelStatus::Disconnected;
+    }
+  }
+};
+
+// The Receiver handle removes items from a channel. Copying a Receiver
+// registers another consumer, and senders are disconnected once every
+// Receiver is gone.
+template <typename T>
+class Receiver {
+ private:
+  detail::ChannelCore<T> *core;
+
+  explicit Receiver(detail::ChannelCore<T> *shared) : core{shared} {}
+
+  friend std::pair<Sender<T>, Receiver<T>> makeChannel<T>(std::size_t);
+
+ public:
+  Receiver(const Receiver &src) : core{src.core} {
+    if (core != nullptr) {
+      core->attach(false);
+    }
+  }
+
+  Receiver(Receiver &&src) noexcept : core{src.core} { src.core = nullptr; }
+
+  Receiver &operator=(Receiver rhs) noexcept {
+    std::swap(core, rhs.core);
+    return *this;
+  }
+
+  ~Receiver() { detail::release(core, false); }
+
+  // The recv method blocks while the channel is empty, and returns
+  // false once every sender is gone and the channel is drained, or if the
+  // handle was moved from.
+  bool recv(T &item) {
+    if (core == nullptr) {
+      return false;
+    }
+    try {
+      core->waitRemove(item);
+      return true;
+    } catch (const ShutdownException &e) {
+      return false;
+    }
+  }
+
+  ChannelStatus tryRecv(T &item) {
+    if (core == nullptr) {
+      return ChannelStatus::Disconnected;
+    }
+    try {
+      return core->tryRemove(item) ? ChannelStatus::Success
+                                   : ChannelStatus::Empty;
+    } catch (const ShutdownException &e) {
+      return ChannelStatus::Disconnected;
+    }
+  }
+};
+
+// The makeChannel function creates a bounded channel with a single
+// Sender and a single Receiver, which may then be copied at will.
+template <typename T>
+std::pair<Sender<T>, Receiver<T>> makeChannel(std::size_t capacity) {
+  auto *core = new detail::ChannelCore<T>{capacity};
+
+  return std::make_pair(Sender<T>{core}, Receiver<T>{core});
+}
+}  // namespace TSC
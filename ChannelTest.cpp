@@ -0,0 +1,133 @@
+#include <cassert>
+#include <exception>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Channel.hpp"
+
+constexpr size_t NB_SENDER_THREADS{4u};
+constexpr size_t NB_RECEIVER_THREADS{3u};
+constexpr size_t NB_MESSAGES{5000u};
+constexpr size_t NB_ITEMS{8u};
+
+// Every message sent before the last sender leaves is received, and the
+// receivers stop by themselves once the channel is drained.
+void drainThenClose() {
+  auto channel = TSC::makeChannel<int>(NB_ITEMS);
+  std::vector<std::thread> senders, receivers;
+  std::vector<long> sums(NB_RECEIVER_THREADS, 0);
+
+  for (size_t i{}; i < NB_SENDER_THREADS; ++i) {
+    senders.emplace_back(
+        [](TSC::Sender<int> tx) {
+          for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+            bool sent = tx.send(static_cast<int>(n));
+            assert(sent);
+            (void)sent;
+          }
+        },
+        channel.first);
+  }
+  for (size_t i{}; i < NB_RECEIVER_THREADS; ++i) {
+    receivers.emplace_back(
+        [&sums, i](TSC::Receiver<int> rx) {
+          int item{};
+          while (rx.recv(item)) {
+            sums[i] += item;
+          }
+        },
+        channel.second);
+  }
+  // Only the handles owned by the threads remain.
+  {
+    auto dropped = std::move(channel);
+  }
+
+  for (auto &t : senders) {
+    t.join();
+  }
+  for (auto &t : receivers) {
+    t.join();
+  }
+
+  long total{};
+  for (long sum : sums) {
+    total += sum;
+  }
+  assert(total == static_cast<long>(NB_SENDER_THREADS * NB_MESSAGES *
+                                    (NB_MESSAGES + 1u) / 2u));
+}
+
+void statuses() {
+  auto channel = TSC::makeChannel<int>(1u);
+  TSC::Sender<int> tx = channel.first;
+  int item;
+
+  assert(channel.second.tryRecv(item) == TSC::ChannelStatus::Empty);
+  assert(tx.trySend(1) == TSC::ChannelStatus::Success);
+  assert(tx.trySend(2) == TSC::ChannelStatus::Full);
+
+  // The channel stays open while a copy of the sender is alive.
+  channel.first = std::move(tx);
+  {
+    TSC::Sender<int> last = std::move(channel.first);
+  }
+  assert(channel.second.tryRecv(item) == TSC::ChannelStatus::Success);
+  assert(item == 1);
+  assert(channel.second.tryRecv(item) == TSC::ChannelStatus::Disconnected);
+  assert(!channel.second.recv(item));
+}
+
+void receiversGone() {
+  auto channel = TSC::makeChannel<int>(NB_ITEMS);
+  TSC::Sender<int> tx = std::move(channel.first);
+
+  assert(tx.send(1));
+  {
+    auto rx = std::move(channel.second);
+  }
+  assert(!tx.send(2));
+  assert(tx.trySend(3) == TSC::ChannelStatus::Disconnected);
+}
+
+// Detaching the last sender closes the container, which fails its
+// asynchronous waiters as well.
+void asyncWaiters() {
+  auto *core = new TSC::detail::ChannelCore<int>{NB_ITEMS};
+  bool failed{false};
+
+  core->asyncRemove([&failed](std::exception_ptr error, int) {
+    failed = error != nullptr;
+  });
+  assert(!core->detach(true) && failed);
+  assert(core->detach(false));
+  delete core;
+}
+
+// A moved-from handle behaves as a disconnected one.
+void movedFrom() {
+  auto channel = TSC::makeChannel<int>(NB_ITEMS);
+  TSC::Sender<int> tx = std::move(channel.first);
+  TSC::Receiver<int> rx = std::move(channel.second);
+  int item;
+
+  assert(!channel.first.send(1));
+  assert(channel.first.trySend(1) == TSC::ChannelStatus::Disconnected);
+  assert(!channel.second.recv(item));
+  assert(channel.second.tryRecv(item) == TSC::ChannelStatus::Disconnected);
+  assert(tx.send(2) && rx.recv(item) && item == 2);
+}
+
+int main() {
+  drainThenClose();
+  statuses();
+  receiversGone();
+  asyncWaiters();
+  movedFrom();
+
+  std::cout << "channel passed" << std::endl;
+
+  return 0;
+}
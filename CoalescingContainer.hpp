@@ -0,0 +1,103 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// The default merge policy keeps the most recent update.
+struct ReplacePending {
+  template <typename T>
+  void operator()(T &pending, const T &incoming) const {
+    pending = incoming;
+  }
+};
+
+// The CoalescingContainer is a bounded FIFO queue for idempotent update
+// streams. Each item has a key given by the KeyOf extractor, and adding an
+// item whose key is already pending merges it into the pending item in place
+// instead of occupying another slot, so the pending item keeps its queue
+// position. Items live in a preallocated ring, and an open addressing index
+// with linear probing maps keys to ring slots under the container lock, so
+// every operation remains O(1).
+template <typename T, typename KeyOf, typename Merge = ReplacePending>
+class CoalescingContainer {
+ public:
+  using size_type = std::size_t;
+  using key_type = typename std::decay<typename std::result_of<KeyOf(
+      const T &)>::type>::type;
+
+ private:
+  static constexpr size_type EMPTY{~size_type{0u}};
+
+  struct Entry {
+    size_type hash;
+    size_type slot;
+  };
+
+  mutable std::mutex mtx;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+  size_type maxSize;
+  std::vector<T> ring;
+  size_type head;
+  size_type count;
+  std::vector<Entry> index;
+  size_type mask;
+  size_type merged;
+  KeyOf keyOf;
+  Merge merge;
+  std::hash<key_type> hasher;
+  bool inUse;
+
+  size_type find(const key_type &key, size_type hash) const;
+
+  void erase(size_type position);
+
+  bool push(const T &item);
+
+  void pop(T &item);
+
+ public:
+  explicit CoalescingContainer(size_type capacity, KeyOf extractor = KeyOf{},
+                               Merge merger = Merge{});
+
+  virtual ~CoalescingContainer();
+
+  CoalescingContainer(const CoalescingContainer &src) = delete;
+
+  CoalescingContainer &operator=(const CoalescingContainer &rhs) = delete;
+
+  CoalescingContainer(CoalescingContainer &&src) = delete;
+
+  CoalescingContainer &operator=(CoalescingContainer &&rhs) = delete;
+
+  bool tryAdd(const T &item);
+
+  void waitAdd(const T &item);
+
+  bool tryRemove(T &item);
+
+  void waitRemove(T &item);
+
+  void shutdown();
+
+  void clear();
+
+  size_type size() const;
+
+  bool empty() const;
+
+  bool full() const;
+
+  // Number of added items merged into a pending item.
+  size_type coalesced() const;
+};
+}  // namespace TSC
+
+#include "CoalescingContainerPrivate.hpp"
@@ -0,0 +1,241 @@
+#pragma once
+
+namespace TSC {
+template <typename T, typename KeyOf, typename Merge>
+constexpr typename CoalescingContainer<T, KeyOf, Merge>::size_type
+    CoalescingContainer<T, KeyOf, Merge>::EMPTY;
+
+template <typename T, typename KeyOf, typename Merge>
+CoalescingContainer<T, KeyOf, Merge>::CoalescingContainer(size_type capacity,
+                                                          KeyOf extractor,
+                                                          Merge merger)
+    : maxSize{capacity},
+      ring(capacity),
+      head{0u},
+      count{0u},
+      merged{0u},
+      keyOf{extractor},
+      merge{merger},
+      inUse{true} {
+  // The index is kept at most half full so that probe sequences stay short.
+  size_type buckets{2u};
+  while (buckets < 2u * capacity) {
+    buckets *= 2u;
+  }
+  index.assign(buckets, Entry{0u, EMPTY});
+  mask = buckets - 1u;
+}
+
+template <typename T, typename KeyOf, typename Merge>
+CoalescingContainer<T, KeyOf, Merge>::~CoalescingContainer() {
+  shutdown();
+  clear();
+}
+
+// The find method returns the index position holding the key,
+// or the empty position ending its probe sequence.
+template <typename T, typename KeyOf, typename Merge>
+typename CoalescingContainer<T, KeyOf, Merge>::size_type
+CoalescingContainer<T, KeyOf, Merge>::find(const key_type &key,
+                                           size_type hash) const {
+  size_type position = hash & mask;
+
+  while (index[position].slot != EMPTY &&
+         !(index[position].hash == hash &&
+           keyOf(ring[index[position].slot]) == key)) {
+    position = (position + 1u) & mask;
+  }
+  return position;
+}
+
+// The erase method uses backward shift deletion, moving back the
+// following entries of the cluster instead of leaving tombstones.
+template <typename T, typename KeyOf, typename Merge>
+void CoalescingContainer<T, KeyOf, Merge>::erase(size_type position) {
+  size_type next = position;
+
+  for (;;) {
+    next = (next + 1u) & mask;
+    if (index[next].slot == EMPTY) {
+      break;
+    }
+    // An entry may only move back if its home bucket does not lie
+    // cyclically within (position, next].
+    size_type home = index[next].hash & mask;
+    if (((next - home) & mask) >= ((next - position) & mask)) {
+      index[position] = index[next];
+      position = next;
+    }
+  }
+  index[position].slot = EMPTY;
+}
+
+// The push method merges the item into the pending item with the same
+// key if any, and otherwise appends it when there is room left. It
+// returns false when the item could not be placed.
+template <typename T, typename KeyOf, typename Merge>
+bool CoalescingContainer<T, KeyOf, Merge>::push(const T &item) {
+  const key_type &key = keyOf(item);
+  size_type hash = hasher(key);
+  size_type position = find(key, hash);
+
+  if (index[position].slot != EMPTY) {
+    merge(ring[index[position].slot], item);
+    ++merged;
+    return true;
+  }
+
+  if (count == maxSize) {
+    return false;
+  }
+
+  size_type slot = (head + count) % maxSize;
+  ring[slot] = item;
+  index[position] = Entry{hash, slot};
+  ++count;
+  // We signal to potential readers in case
+  // the queue was previously empty.
+  if (count == 1) {
+    notEmpty.notify_all();
+  }
+  return true;
+}
+
+template <typename T, typename KeyOf, typename Merge>
+void CoalescingContainer<T, KeyOf, Merge>::pop(T &item) {
+  size_type hash = hasher(keyOf(ring[head]));
+  size_type position = hash & mask;
+
+  while (index[position].slot != head) {
+    position = (position + 1u) & mask;
+  }
+  erase(position);
+
+  item = std::move(ring[head]);
+  head = (head + 1u) % maxSize;
+  --count;
+  // We signal to potential writers in case
+  // the queue was previously full.
+  if (count == (maxSize - 1)) {
+    notFull.notify_all();
+  }
+}
+
+// The tryAdd method returns true if the item was queued or merged into a
+// pending item, and false if the queue is full.
+template <typename T, typename KeyOf, typename Merge>
+bool CoalescingContainer<T, KeyOf, Merge>::tryAdd(const T &item) {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  if (!inUse) {
+    throw ShutdownException("shutdown");
+  }
+
+  return push(item);
+}
+
+// The waitAdd method only blocks when the queue is full and the key of
+// the item is not pending.
+template <typename T, typename KeyOf, typename Merge>
+void CoalescingContainer<T, KeyOf, Merge>::waitAdd(const T &item) {
+  std::unique_lock<std::mutex> lock{mtx};
+
+  notFull.wait(lock, [this, &item] { return !inUse || push(item); });
+
+  if (!inUse) {
+    // Even if the queue is not in use, we need to
+    // signal to potential writers blocked on
+    // a full queue.
+    notFull.notify_all();
+    throw ShutdownException("shutdown");
+  }
+}
+
+template <typename T, typename KeyOf, typename Merge>
+bool CoalescingContainer<T, KeyOf, Merge>::tryRemove(T &item) {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  if (!inUse) {
+    throw ShutdownException("shutdown");
+  }
+
+  if (count == 0u) {
+    return false;
+  }
+  pop(item);
+  return true;
+}
+
+template <typename T, typename KeyOf, typename Merge>
+void CoalescingContainer<T, KeyOf, Merge>::waitRemove(T &item) {
+  std::unique_lock<std::mutex> lock{mtx};
+
+  notEmpty.wait(lock, [this] { return !((count == 0u) && inUse); });
+
+  if (!inUse) {
+    // Even if the queue is not in use, we need to
+    // signal to potential readers blocked on
+    // an empty queue.
+    notEmpty.notify_all();
+    throw ShutdownException("shutdown");
+  }
+
+  pop(item);
+}
+
+template <typename T, typename KeyOf, typename Merge>
+void CoalescingContainer<T, KeyOf, Merge>::shutdown() {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  inUse = false;
+  notEmpty.notify_all();
+  notFull.notify_all();
+}
+
+// The clear method removes any pending elements once the
+// queue has been shut down.
+template <typename T, typename KeyOf, typename Merge>
+void CoalescingContainer<T, KeyOf, Merge>::clear() {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  if (!inUse) {
+    for (; count > 0u; --count) {
+      ring[head] = T{};
+      head = (head + 1u) % maxSize;
+    }
+    index.assign(index.size(), Entry{0u, EMPTY});
+    notEmpty.notify_all();
+    notFull.notify_all();
+  }
+}
+
+template <typename T, typename KeyOf, typename Merge>
+typename CoalescingContainer<T, KeyOf, Merge>::size_type
+CoalescingContainer<T, KeyOf, Merge>::size() const {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  return count;
+}
+
+template <typename T, typename KeyOf, typename Merge>
+bool CoalescingContainer<T, KeyOf, Merge>::empty() const {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  return count == 0u;
+}
+
+template <typename T, typename KeyOf, typename Merge>
+bool CoalescingContainer<T, KeyOf, Merge>::full() const {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  return count == maxSize;
+}
+
+template <typename T, typename KeyOf, typename Merge>
+typename CoalescingContainer<T, KeyOf, Merge>::size_type
+CoalescingContainer<T, KeyOf, Merge>::coalesced() const {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  return merged;
+}
+}  // namespace TSC
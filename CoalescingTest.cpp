@@ -0,0 +1,120 @@
+#include <cassert>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "CoalescingContainer.hpp"
+#include "RandomGenerator.hpp"
+
+constexpr size_t NB_ITEMS{32u};
+constexpr size_t NB_KEYS{64};
+constexpr size_t NB_OPERATIONS{100000u};
+constexpr size_t NB_WRITER_THREADS{4u};
+
+struct Update {
+  int key;
+  int value;
+};
+
+struct KeyOfUpdate {
+  int operator()(const Update &update) const { return update.key; }
+};
+
+struct SumUpdates {
+  void operator()(Update &pending, const Update &incoming) const {
+    pending.value += incoming.value;
+  }
+};
+
+void coalescing() {
+  TSC::CoalescingContainer<Update, KeyOfUpdate> mtq{2u};
+  Update item;
+
+  assert(mtq.tryAdd(Update{1, 10}));
+  assert(mtq.tryAdd(Update{2, 20}));
+  assert(mtq.full());
+  // A pending key is merged in place even when the queue is full.
+  assert(mtq.tryAdd(Update{1, 11}));
+  assert(!mtq.tryAdd(Update{3, 30}));
+  assert(mtq.size() == 2u);
+  assert(mtq.coalesced() == 1u);
+
+  assert(mtq.tryRemove(item) && item.key == 1 && item.value == 11);
+  assert(mtq.tryAdd(Update{1, 12}));
+  assert(mtq.tryRemove(item) && item.key == 2 && item.value == 20);
+  assert(mtq.tryRemove(item) && item.key == 1 && item.value == 12);
+  assert(!mtq.tryRemove(item));
+}
+
+// Compares the container against a simple model under random operations,
+// exercising the backward shift deletion of the index.
+void model() {
+  TSC::CoalescingContainer<Update, KeyOfUpdate, SumUpdates> mtq{NB_ITEMS};
+  std::deque<int> order;
+  std::map<int, int> pending;
+  Update item;
+
+  for (size_t i{}; i < NB_OPERATIONS; ++i) {
+    if (RND::pick(0, 1) == 0) {
+      int key = RND::pick(0, NB_KEYS - 1);
+      bool present = pending.count(key) != 0u;
+      bool added = mtq.tryAdd(Update{key, 1});
+      assert(added == (present || order.size() < NB_ITEMS));
+      if (added) {
+        if (!present) {
+          order.push_back(key);
+        }
+        ++pending[key];
+      }
+    } else {
+      bool removed = mtq.tryRemove(item);
+      assert(removed == !order.empty());
+      if (removed) {
+        assert(item.key == order.front());
+        assert(item.value == pending[item.key]);
+        pending.erase(item.key);
+        order.pop_front();
+      }
+    }
+    assert(mtq.size() == order.size());
+  }
+}
+
+void concurrent() {
+  TSC::CoalescingContainer<Update, KeyOfUpdate, SumUpdates> mtq{NB_ITEMS};
+  std::vector<std::thread> writers;
+  int total{};
+  Update item;
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      for (size_t i{}; i < NB_OPERATIONS / NB_WRITER_THREADS; ++i) {
+        mtq.waitAdd(Update{RND::pick(0, NB_KEYS - 1), 1});
+      }
+    });
+  }
+  std::thread reader{[&] {
+    while (total != static_cast<int>(NB_OPERATIONS)) {
+      mtq.waitRemove(item);
+      total += item.value;
+    }
+  }};
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  reader.join();
+  assert(mtq.empty());
+}
+
+int main() {
+  coalescing();
+  model();
+  concurrent();
+
+  std::cout << "coalescing container passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include "Lz4.hpp"
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// The CompressingContainer is a bounded FIFO queue of byte payloads meant
+// for large text items such as JSON log lines. Payloads of at least
+// threshold bytes are compressed with LZ4 by the producer thread before
+// being added, and expanded by the consumer thread after being removed, so
+// that neither step runs under the container lock. Payloads that do not
+// shrink are kept as they are. The logical and stored sizes of the queued
+// payloads are tracked with atomic counters.
+class CompressingContainer {
+ public:
+  using size_type = std::size_t;
+
+  static constexpr size_type DEFAULT_THRESHOLD{1024u};
+
+ private:
+  struct Usage {
+    std::atomic<size_type> logical{0u};
+    std::atomic<size_type> stored{0u};
+  };
+
+  // A Packet is a payload as kept in the queue. It charges its sizes to the
+  // usage counters for as long as it lives, so that removed, cleared and
+  // dropped payloads are all accounted for.
+  class Packet {
+   private:
+    Usage *usage;
+    std::string data;
+    size_type logical;
+    bool compressed;
+
+    void discharge();
+
+   public:
+    Packet() : usage{nullptr}, logical{0u}, compressed{false} {}
+
+    Packet(Usage &counters, std::string bytes, size_type size,
+           bool isCompressed);
+
+    Packet(Packet &&src) noexcept;
+
+    Packet &operator=(Packet &&rhs) noexcept;
+
+    ~Packet() { discharge(); }
+
+    void unpack(std::string &payload) const;
+  };
+
+  Usage usage;
+  size_type threshold;
+  ThreadSafeContainer<Packet> queue;
+
+  Packet pack(const std::string &payload);
+
+ public:
+  explicit CompressingContainer(size_type capacity,
+                                size_type threshold = DEFAULT_THRESHOLD);
+
+  CompressingContainer(const CompressingContainer &src) = delete;
+
+  CompressingContainer &operator=(const CompressingContainer &rhs) = delete;
+
+  bool tryAdd(const std::string &payload);
+
+  void waitAdd(const std::string &payload);
+
+  bool tryRemove(std::string &payload);
+
+  void waitRemove(std::string &payload);
+
+  void shutdown();
+
+  void close();
+
+  void clear();
+
+  size_type size() const;
+
+  bool empty() const;
+
+  bool full() const;
+
+  // Total size of the queued payloads once expanded.
+  size_type logicalBytes() const;
+
+  // Total size of the queued payloads as held in memory.
+  size_type storedBytes() const;
+};
+}  // namespace TSC
+
+#include "CompressingContainerPrivate.hpp"
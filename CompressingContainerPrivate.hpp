@@ -0,0 +1,136 @@
+#pragma once
+
+namespace TSC {
+inline CompressingContainer::Packet::Packet(Usage &counters, std::string bytes,
+                                            size_type size, bool isCompressed)
+    : usage{&counters},
+      data{std::move(bytes)},
+      logical{size},
+      compressed{isCompressed} {
+  usage->logical.fetch_add(logical, std::memory_order_relaxed);
+  usage->stored.fetch_add(data.size(), std::memory_order_relaxed);
+}
+
+inline CompressingContainer::Packet::Packet(Packet &&src) noexcept
+    : usage{src.usage},
+      data{std::move(src.data)},
+      logical{src.logical},
+      compressed{src.compressed} {
+  src.usage = nullptr;
+}
+
+inline CompressingContainer::Packet &CompressingContainer::Packet::operator=(
+    Packet &&rhs) noexcept {
+  if (this != &rhs) {
+    discharge();
+    usage = rhs.usage;
+    data = std::move(rhs.data);
+    logical = rhs.logical;
+    compressed = rhs.compressed;
+    rhs.usage = nullptr;
+  }
+  return *this;
+}
+
+inline void CompressingContainer::Packet::discharge() {
+  if (usage != nullptr) {
+    usage->logical.fetch_sub(logical, std::memory_order_relaxed);
+    usage->stored.fetch_sub(data.size(), std::memory_order_relaxed);
+    usage = nullptr;
+  }
+}
+
+inline void CompressingContainer::Packet::unpack(std::string &payload) const {
+  if (!compressed) {
+    payload = data;
+    return;
+  }
+  payload.resize(logical);
+  Lz4::decompress(data.data(), data.size(), &payload[0], logical);
+}
+
+// The pack method runs outside the container lock. The compressed block is
+// built in a scratch buffer kept by the thread, then copied into a string of
+// its exact size so that the queue holds no slack.
+inline CompressingContainer::Packet CompressingContainer::pack(
+    const std::string &payload) {
+  if (payload.size() >= threshold) {
+    static thread_local std::string scratch;
+
+    scratch.resize(Lz4::bound(payload.size()));
+    size_type size = Lz4::compress(payload.data(), payload.size(), &scratch[0]);
+    if (size < payload.size()) {
+      return Packet{usage, std::string(scratch.data(), size), payload.size(),
+                    true};
+    }
+  }
+  return Packet{usage, payload, payload.size(), false};
+}
+
+inline CompressingContainer::CompressingContainer(size_type capacity,
+                                                  size_type threshold)
+    : threshold{threshold}, queue{capacity} {}
+
+// The tryAdd method returns true if tryAdd succeeds and false if the queue
+// is full, in which case the payload has been compressed for nothing.
+inline bool CompressingContainer::tryAdd(const std::string &payload) {
+  Packet packet = pack(payload);
+  auto slot = queue.tryReserveAdd();
+
+  if (!slot) {
+    return false;
+  }
+  slot.emplace(std::move(packet));
+  queue.commitAdd(slot);
+  return true;
+}
+
+inline void CompressingContainer::waitAdd(const std::string &payload) {
+  Packet packet = pack(payload);
+  auto slot = queue.reserveAdd();
+
+  slot.emplace(std::move(packet));
+  queue.commitAdd(slot);
+}
+
+inline bool CompressingContainer::tryRemove(std::string &payload) {
+  Packet packet;
+
+  if (!queue.tryRemove(packet)) {
+    return false;
+  }
+  packet.unpack(payload);
+  return true;
+}
+
+inline void CompressingContainer::waitRemove(std::string &payload) {
+  Packet packet;
+
+  queue.waitRemove(packet);
+  packet.unpack(payload);
+}
+
+inline void CompressingContainer::shutdown() { queue.shutdown(); }
+
+inline void CompressingContainer::close() { queue.close(); }
+
+inline void CompressingContainer::clear() { queue.clear(); }
+
+inline CompressingContainer::size_type CompressingContainer::size() const {
+  return queue.size();
+}
+
+inline bool CompressingContainer::empty() const { return queue.empty(); }
+
+inline bool CompressingContainer::full() const { return queue.full(); }
+
+inline CompressingContainer::size_type CompressingContainer::logicalBytes()
+    const {
+  return usage.logical.load(std::memory_order_relaxed);
+}
+
+inline CompressingContainer::size_type CompressingContainer::storedBytes()
+    const {
+  return usage.stored.load(std::memory_order_relaxed);
+}
+}  // namespace TSC
@@ -0,0 +1,143 @@
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CompressingContainer.hpp"
+#include "Lz4.hpp"
+#include "RandomGenerator.hpp"
+
+constexpr size_t NB_WRITER_THREADS{3u};
+constexpr size_t NB_READER_THREADS{2u};
+constexpr size_t NB_PAYLOADS{500u};
+constexpr size_t NB_ITEMS{16u};
+constexpr size_t NB_LINES{64u};
+
+// Builds a batch of JSON log lines, the payloads this mode is meant for.
+std::string makeLogLines(size_t id) {
+  std::string lines;
+
+  for (size_t n{}; n < NB_LINES; ++n) {
+    lines += "{\"timestamp\":\"2024-05-01T12:00:" + std::to_string(n % 60) +
+             "Z\",\"level\":\"info\",\"service\":\"ingest\",\"request\":" +
+             std::to_string(id * NB_LINES + n) +
+             ",\"message\":\"payload accepted\",\"latency_ms\":" +
+             std::to_string(RND::pick(1, 250)) + "}\n";
+  }
+  return lines;
+}
+
+std::string roundTrip(const std::string &input) {
+  std::string block = TSC::Lz4::compress(input.data(), input.size());
+  std::string output(input.size(), '\0');
+
+  TSC::Lz4::decompress(block.data(), block.size(), &output[0], output.size());
+  return output;
+}
+
+void codec() {
+  std::vector<std::string> inputs{"", "a", "abcdefghijklm",
+                                  std::string(100000u, 'z'),
+                                  makeLogLines(0u)};
+  std::string random;
+  for (size_t i{}; i < 70000u; ++i) {
+    random += static_cast<char>(RND::pick(0, 255));
+  }
+  inputs.push_back(random);
+  // Matches farther than the 64 KiB window are not referenced.
+  inputs.push_back(random + random.substr(0u, 1000u) + makeLogLines(1u));
+
+  for (const auto &input : inputs) {
+    assert(roundTrip(input) == input);
+  }
+
+  std::string lines = makeLogLines(2u);
+  std::string block = TSC::Lz4::compress(lines.data(), lines.size());
+  std::string output(lines.size(), '\0');
+  try {
+    TSC::Lz4::decompress(block.data(), block.size() / 2u, &output[0],
+                         output.size());
+    assert(false);
+  } catch (const std::runtime_error &e) {
+  }
+}
+
+void accounting() {
+  TSC::CompressingContainer mtq{NB_ITEMS, 256u};
+  std::string small{"{\"level\":\"debug\"}"}, payload;
+
+  mtq.waitAdd(small);
+  assert(mtq.logicalBytes() == small.size());
+  assert(mtq.storedBytes() == small.size());
+
+  size_t logical{small.size()};
+  for (size_t n{}; n < NB_ITEMS - 1u; ++n) {
+    std::string lines = makeLogLines(n);
+    logical += lines.size();
+    bool added = mtq.tryAdd(lines);
+    assert(added);
+  }
+  assert(mtq.full() && !mtq.tryAdd(small));
+  assert(mtq.logicalBytes() == logical);
+  assert(mtq.storedBytes() * 3u < mtq.logicalBytes());
+
+  mtq.waitRemove(payload);
+  assert(payload == small);
+  mtq.shutdown();
+  mtq.clear();
+  assert(mtq.logicalBytes() == 0u && mtq.storedBytes() == 0u);
+}
+
+void concurrent() {
+  TSC::CompressingContainer mtq{NB_ITEMS};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> counts(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq, w] {
+      for (size_t n{}; n < NB_PAYLOADS; ++n) {
+        mtq.waitAdd(makeLogLines(w * NB_PAYLOADS + n));
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &counts, r] {
+      std::string payload;
+      try {
+        for (;;) {
+          mtq.waitRemove(payload);
+          assert(payload.size() > NB_LINES && payload.back() == '\n');
+          ++counts[r];
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  size_t total{};
+  for (auto count : counts) {
+    total += count;
+  }
+  assert(total == NB_WRITER_THREADS * NB_PAYLOADS);
+  assert(mtq.logicalBytes() == 0u && mtq.storedBytes() == 0u);
+}
+
+int main() {
+  codec();
+  accounting();
+  concurrent();
+
+  std::cout << "compression passed" << std::endl;
+
+  return 0;
+}
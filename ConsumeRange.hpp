@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// The ConsumeRange is a blocking input range over the items removed from
+// a ThreadSafeContainer, returned by its consume method. Items are fetched
+// up to batch items per critical section, and yielded one at a time. The
+// range ends once the container is shut down, or once it is closed and
+// drained. Items yielded by reference may be moved from.
+//
+// The fetched items keep their slots in the container until the next
+// fetch, so that a loop left early by break, return or throw hands the
+// items it did not dereference back to the front of the container.
+// Meanwhile the container reports them neither in its size nor as room.
+//
+// The fetched batch lives on the heap, which lets the range be moved while
+// iterators to it are in use, as C++20 range adaptors do.
+template <typename T, typename Lock>
+class ConsumeRange {
+ private:
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  struct State {
+    ThreadSafeContainer<T, Lock> &queue;
+    std::size_t capacity;
+    std::unique_ptr<Storage[]> storage;
+    std::size_t index{};
+    std::size_t count{};
+    // Whether the item at index was dereferenced.
+    bool seen{false};
+    bool done{false};
+
+    State(ThreadSafeContainer<T, Lock> &queue, std::size_t batch)
+        : queue{queue},
+          capacity{batch > 0u ? batch : 1u},
+          storage{new Storage[capacity]} {}
+
+    ~State();
+
+    T *item(std::size_t position) {
+      return reinterpret_cast<T *>(&storage[position]);
+    }
+
+    void destroy();
+
+    void fetch();
+  };
+
+  std::unique_ptr<State> state;
+
+ public:
+  static constexpr std::size_t DEFAULT_BATCH{32u};
+
+  // The iterator is a single pass input iterator, and the default
+  // constructed iterator marks the end of the range.
+  class iterator {
+   private:
+    State *state{nullptr};
+
+    friend class ConsumeRange<T, Lock>;
+
+    explicit iterator(State *state) : state{state} {}
+
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T *;
+    using reference = T &;
+
+    iterator() = default;
+
+    T &operator*() const {
+      state->seen = true;
+      return *state->item(state->index);
+    }
+
+    T *operator->() const { return &**this; }
+
+    iterator &operator++() {
+      state->seen = false;
+      if (++state->index == state->count) {
+        state->fetch();
+      }
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    friend bool operator==(const iterator &lhs, const iterator &rhs) {
+      return (lhs.state == nullptr || lhs.state->done) ==
+             (rhs.state == nullptr || rhs.state->done);
+    }
+
+    friend bool operator!=(const iterator &lhs, const iterator &rhs) {
+      return !(lhs == rhs);
+    }
+  };
+
+  ConsumeRange(ThreadSafeContainer<T, Lock> &queue, std::size_t batch)
+      : state{new State{queue, batch}} {}
+
+  // The begin method blocks until the first item is available, and must
+  // be called once.
+  iterator begin() {
+    state->fetch();
+    return iterator{state.get()};
+  }
+
+  iterator end() const { return iterator{}; }
+};
+
+template <typename T, typename Lock>
+constexpr std::size_t ConsumeRange<T, Lock>::DEFAULT_BATCH;
+
+// The items from the first one not dereferenced on are handed back. A
+// destructor cannot report an item whose move throws, which is lost.
+template <typename T, typename Lock>
+ConsumeRange<T, Lock>::State::~State() {
+  if (count > 0u) {
+    std::size_t first = std::min(index + (seen ? 1u : 0u), count);
+    try {
+      queue.restore(item(first), count - first, count);
+    } catch (...) {
+    }
+  }
+  destroy();
+}
+
+template <typename T, typename Lock>
+void ConsumeRange<T, Lock>::State::destroy() {
+  for (std::size_t i{}; i < count; ++i) {
+    item(i)->~T();
+  }
+}
+
+template <typename T, typename Lock>
+void ConsumeRange<T, Lock>::State::fetch() {
+  std::size_t yielded = count;
+
+  destroy();
+  index = 0u;
+  count = 0u;
+  seen = false;
+  try {
+    queue.holdBulk(item(0u), capacity, yielded, count);
+  } catch (const ShutdownException &e) {
+    done = true;
+  }
+}
+}  // namespace TSC
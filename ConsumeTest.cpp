@@ -0,0 +1,202 @@
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 202002L
+#include <ranges>
+#endif
+
+#include "ThreadSafeContainer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{3u};
+constexpr size_t NB_READER_THREADS{3u};
+constexpr size_t NB_MESSAGES{5000u};
+constexpr size_t NB_ITEMS{16u};
+
+#if __cplusplus >= 202002L
+static_assert(std::ranges::input_range<TSC::ConsumeRange<int>>);
+#endif
+
+// Items come out in order, across batch boundaries, and the range ends
+// once the closed container is drained.
+void drainThenClose() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  std::vector<int> read;
+
+  for (int n{}; n < 10; ++n) {
+    mtq.waitAdd(n);
+  }
+  mtq.close();
+  for (int item : mtq.consume(3u)) {
+    read.push_back(item);
+  }
+  assert(read.size() == 10u);
+  for (int n{}; n < 10; ++n) {
+    assert(read[n] == n);
+  }
+}
+
+// Consumers blocked for the next batch leave the loop on shutdown.
+void shutdown() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  size_t count{};
+
+  std::thread reader{[&mtq, &count] {
+    for (int &item : mtq.consume()) {
+      (void)item;
+      ++count;
+    }
+  }};
+  mtq.waitAdd(1);
+  while (!mtq.empty()) {
+    std::this_thread::yield();
+  }
+  mtq.shutdown();
+  reader.join();
+  assert(count == 1u);
+}
+
+// Yielded items can be moved from.
+void moveOnly() {
+  TSC::ThreadSafeContainer<std::unique_ptr<int>> mtq{NB_ITEMS};
+  std::vector<std::unique_ptr<int>> read;
+
+  for (int n{}; n < 5; ++n) {
+    mtq.waitAdd(std::unique_ptr<int>{new int{n}});
+  }
+  mtq.close();
+  auto range = mtq.consume(2u);
+  for (auto it = range.begin(); it != range.end(); ++it) {
+    read.push_back(std::move(*it));
+  }
+  for (int n{}; n < 5; ++n) {
+    assert(*read[n] == n);
+  }
+}
+
+// Leaving the loop early hands the items fetched but not dereferenced
+// back to the front of the container, which kept their slots meanwhile.
+void earlyExit() {
+  TSC::ThreadSafeContainer<int> mtq{10u};
+  std::vector<int> read;
+
+  for (int n{}; n < 10; ++n) {
+    mtq.waitAdd(n);
+  }
+  for (int item : mtq.consume(4u)) {
+    read.push_back(item);
+    // The first batch keeps its slots until the second one is fetched.
+    assert(item >= 4 || !mtq.tryAdd(10));
+    if (item == 5) {
+      break;
+    }
+  }
+  assert((read == std::vector<int>{0, 1, 2, 3, 4, 5}));
+  assert(mtq.size() == 4u);
+  assert(mtq.tryAdd(10));
+  int item{};
+  for (int n{6}; n <= 10; ++n) {
+    assert(mtq.tryRemove(item) && item == n);
+  }
+
+  // A throw leaves the loop likewise.
+  for (int n{}; n < 4; ++n) {
+    mtq.waitAdd(n);
+  }
+  try {
+    for (int value : mtq.consume()) {
+      if (value == 1) {
+        throw std::runtime_error("stop");
+      }
+    }
+  } catch (const std::runtime_error &e) {
+  }
+  assert(mtq.size() == 2u && mtq.tryRemove(item) && item == 2);
+  assert(mtq.tryRemove(item) && item == 3);
+
+  // With a slot peeked at the front, the items go back behind the others.
+  for (int n{}; n < 4; ++n) {
+    mtq.waitAdd(n);
+  }
+  auto slot = mtq.peekRemove();
+  for (int value : mtq.consume(2u)) {
+    assert(value == 1);
+    break;
+  }
+  mtq.release(slot);
+  assert(mtq.tryRemove(item) && item == 3);
+  assert(mtq.tryRemove(item) && item == 2 && mtq.empty());
+}
+
+// Items without a default constructor are fetched into raw storage.
+struct Tagged {
+  int value;
+
+  explicit Tagged(int value) : value{value} {}
+};
+
+void noDefault() {
+  TSC::ThreadSafeContainer<Tagged> mtq{NB_ITEMS};
+  int sum{};
+
+  for (int n{1}; n <= 5; ++n) {
+    mtq.waitAdd(Tagged{n});
+  }
+  mtq.close();
+  for (const Tagged &item : mtq.consume()) {
+    sum += item.value;
+  }
+  assert(sum == 15);
+}
+
+void concurrent() {
+  TSC::ThreadSafeContainer<size_t> mtq{NB_ITEMS};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> sums(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+        mtq.waitAdd(n);
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &sums, r] {
+      for (size_t item : mtq.consume(8u)) {
+        sums[r] += item;
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  size_t total{};
+  for (auto sum : sums) {
+    total += sum;
+  }
+  assert(total == NB_WRITER_THREADS * NB_MESSAGES * (NB_MESSAGES + 1u) / 2u);
+}
+
+int main() {
+  drainThenClose();
+  shutdown();
+  moveOnly();
+  earlyExit();
+  noDefault();
+  concurrent();
+
+  std::cout << "consume passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "HazardPointers.hpp"
+#include "Locks.hpp"
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// The FetchAddContainer is a lock-free FIFO queue with the blocking and
+// non-blocking API of ThreadSafeContainer, in the style of the LCRQ of
+// Morrison and Afek, for queues contended by many cores. Producers and
+// consumers claim the cells of a ring with fetch_add on 64-bit tickets,
+// which always succeeds, instead of retrying compare-and-swap loops on a
+// shared head and tail. Each cell holds a sequence word, the ticket it
+// awaits and whether it is empty, being written or full, so that a
+// consumer whose producer is late marks the cell as skipped, and the
+// producer draws another ticket. Compare-and-swap is only used on the
+// cell, between the two threads holding its ticket.
+//
+// An unbounded container links rings into a list. A producer finding its
+// ring full, or losing its cells to consumers too often, closes the ring
+// and appends a new one, while consumers move on to the next ring once
+// the closed one is drained. Drained rings are deleted once no thread
+// announces them in its hazard pointers. A bounded container uses a
+// single ring, which is never closed, and holds at most capacity items.
+//
+// Waiting calls retry the operation after flagging that they may sleep,
+// and producers and consumers only take the mutex the sleepers wait under
+// when they see the flag, which the first of them clears.
+template <typename T>
+class FetchAddContainer {
+ public:
+  using size_type = std::size_t;
+
+  static constexpr size_type UNBOUNDED{std::numeric_limits<size_type>::max()};
+
+  static constexpr size_type DEFAULT_RING_SIZE{1024u};
+
+ private:
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  // The sequence word of a cell is the ticket it awaits times four, plus
+  // its state.
+  static constexpr std::uint64_t EMPTY{0u};
+  static constexpr std::uint64_t WRITING{1u};
+  static constexpr std::uint64_t FULL{2u};
+
+  // The tail of a closed ring has its top bit set.
+  static constexpr std::uint64_t CLOSED{std::uint64_t{1u} << 63};
+
+  // The number of cells a producer may lose to consumers before closing
+  // an unbounded ring.
+  static constexpr unsigned PATIENCE{16u};
+
+  struct CellFields {
+    std::atomic<std::uint64_t> sequence;
+    Storage storage;
+  };
+
+  struct Cell : CellFields {
+    char padding[detail::CACHE_LINE - sizeof(CellFields) % detail::CACHE_LINE];
+  };
+
+  struct Ring {
+    std::atomic<std::uint64_t> head{0u};
+    char headPadding[detail::CACHE_LINE - sizeof(std::atomic<std::uint64_t>)];
+    std::atomic<std::uint64_t> tail{0u};
+    char tailPadding[detail::CACHE_LINE - sizeof(std::atomic<std::uint64_t>)];
+    std::atomic<Ring *> next{nullptr};
+    std::uint64_t mask;
+    std::unique_ptr<Cell[]> cells;
+
+    explicit Ring(size_type size);
+
+    ~Ring();
+
+    size_type size() const;
+  };
+
+  enum class Result : std::uint8_t { Success, Full, Closed, Refused };
+
+  size_type maxSize;
+  size_type ringSize;
+  std::atomic<bool> inUse{true};
+  std::atomic<bool> closed{false};
+
+  alignas(64) std::atomic<Ring *> headRing;
+  alignas(64) std::atomic<Ring *> tailRing;
+  detail::RetiredList<Ring> retired;
+
+  // The wait words hold an epoch times two, plus one while threads may
+  // sleep on it.
+  alignas(64) std::atomic<std::uint64_t> writersWait{0u};
+  std::atomic<std::uint64_t> readersWait{0u};
+  std::mutex sleepMtx;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+
+  static std::uint64_t sequence(std::uint64_t ticket, std::uint64_t state) {
+    return ticket * 4u + state;
+  }
+
+  bool bounded() const { return maxSize != UNBOUNDED; }
+
+  bool refused() const;
+
+  // The claim method writes the item in the cell of the ticket, unless a
+  // consumer skipped the cell first.
+  template <typename U>
+  bool claim(Ring &ring, std::uint64_t ticket, U &&item);
+
+  // The enqueue and dequeue methods draw tickets until they get a cell.
+  template <typename U>
+  Result enqueue(Ring &ring, U &&item);
+
+  bool dequeue(Ring &ring, T *item);
+
+  // The push and pop methods walk the list of rings.
+  template <typename U>
+  bool push(U &&item);
+
+  bool pop(T *item);
+
+  template <typename U>
+  bool tryPush(U &&item);
+
+  template <typename U>
+  void waitPush(U &&item);
+
+  void wake(std::atomic<std::uint64_t> &word,
+            std::condition_variable &condition);
+
+  void sleep(std::atomic<std::uint64_t> &word,
+             std::condition_variable &condition, std::uint64_t seen);
+
+  void wakeAll();
+
+ public:
+  explicit FetchAddContainer(size_type capacity = UNBOUNDED,
+                             size_type ringSize = DEFAULT_RING_SIZE);
+
+  ~FetchAddContainer();
+
+  FetchAddContainer(const FetchAddContainer<T> &src) = delete;
+
+  FetchAddContainer<T> &operator=(const FetchAddContainer<T> &rhs) = delete;
+
+  bool tryAdd(const T &item);
+
+  bool tryAdd(T &&item);
+
+  void waitAdd(const T &item);
+
+  void waitAdd(T &&item);
+
+  bool tryRemove(T &item);
+
+  void waitRemove(T &item);
+
+  void shutdown();
+
+  void close();
+
+  void clear();
+
+  // The size, empty and full methods sum the tickets drawn but not yet
+  // served over the rings. Tickets given up by producers count until the
+  // consumers pass them, so the size is an upper bound, and is only exact
+  // while the queue is not being modified.
+  size_type size() const;
+
+  bool empty() const;
+
+  bool full() const;
+};
+}  // namespace TSC
+
+#include "FetchAddContainerPrivate.hpp"
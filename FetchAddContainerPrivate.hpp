@@ -0,0 +1,469 @@
+#pragma once
+
+namespace TSC {
+template <typename T>
+constexpr typename FetchAddContainer<T>::size_type
+    FetchAddContainer<T>::UNBOUNDED;
+
+template <typename T>
+constexpr typename FetchAddContainer<T>::size_type
+    FetchAddContainer<T>::DEFAULT_RING_SIZE;
+
+// Rings have a power of two number of cells, and cell i first awaits
+// ticket i.
+template <typename T>
+FetchAddContainer<T>::Ring::Ring(size_type size) {
+  std::uint64_t cellCount{1u};
+
+  while (cellCount < size) {
+    cellCount <<= 1;
+  }
+  mask = cellCount - 1u;
+  cells.reset(new Cell[cellCount]);
+  for (std::uint64_t i{}; i < cellCount; ++i) {
+    cells[i].sequence.store(sequence(i, EMPTY), std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+FetchAddContainer<T>::Ring::~Ring() {
+  for (std::uint64_t i{}; i <= mask; ++i) {
+    if ((cells[i].sequence.load(std::memory_order_acquire) & 3u) == FULL) {
+      reinterpret_cast<T *>(&cells[i].storage)->~T();
+    }
+  }
+}
+
+template <typename T>
+typename FetchAddContainer<T>::size_type FetchAddContainer<T>::Ring::size()
+    const {
+  std::uint64_t last = tail.load() & ~CLOSED;
+  std::uint64_t first = head.load();
+
+  if (last <= first) {
+    return 0u;
+  }
+  return static_cast<size_type>(std::min(last - first, mask + 1u));
+}
+
+template <typename T>
+FetchAddContainer<T>::FetchAddContainer(size_type capacity,
+                                        size_type ringSize)
+    : maxSize{capacity},
+      ringSize{capacity != UNBOUNDED ? capacity : ringSize},
+      headRing{new Ring{this->ringSize}},
+      tailRing{headRing.load(std::memory_order_relaxed)} {}
+
+template <typename T>
+FetchAddContainer<T>::~FetchAddContainer() {
+  Ring *ring = headRing.load(std::memory_order_acquire);
+
+  while (ring != nullptr) {
+    Ring *next = ring->next.load(std::memory_order_acquire);
+    delete ring;
+    ring = next;
+  }
+}
+
+template <typename T>
+bool FetchAddContainer<T>::refused() const {
+  return !inUse.load() || closed.load();
+}
+
+// A cell still holding the previous lap is awaited, as the consumer of
+// that lap has already drawn its ticket.
+template <typename T>
+template <typename U>
+bool FetchAddContainer<T>::claim(Ring &ring, std::uint64_t ticket,
+                                 U &&item) {
+  Cell &cell = ring.cells[ticket & ring.mask];
+  std::uint64_t expected = sequence(ticket, EMPTY);
+
+  for (unsigned spins{};; ++spins) {
+    std::uint64_t current = cell.sequence.load(std::memory_order_acquire);
+    if (current > expected) {
+      return false;
+    }
+    if (current < expected) {
+      detail::relax(spins);
+    } else if (cell.sequence.compare_exchange_weak(
+                   current, sequence(ticket, WRITING),
+                   std::memory_order_acquire, std::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  try {
+    new (&cell.storage) T(std::forward<U>(item));
+  } catch (...) {
+    cell.sequence.store(sequence(ticket + ring.mask + 1u, EMPTY),
+                        std::memory_order_release);
+    throw;
+  }
+  cell.sequence.store(sequence(ticket, FULL), std::memory_order_release);
+  return true;
+}
+
+// A producer gives its ticket up when it is a lap ahead of the consumers,
+// or when the container is closed. The flags are checked after drawing
+// the ticket, so that a consumer that finds the closed queue empty either
+// sees the ticket, or the producer sees the flag.
+template <typename T>
+template <typename U>
+typename FetchAddContainer<T>::Result FetchAddContainer<T>::enqueue(
+    Ring &ring, U &&item) {
+  std::uint64_t limit = bounded() ? maxSize : ring.mask + 1u;
+
+  for (unsigned lost{};;) {
+    std::uint64_t tail = ring.tail.load();
+    if ((tail & CLOSED) != 0u) {
+      return Result::Closed;
+    }
+    if (tail >= ring.head.load() + limit) {
+      break;
+    }
+
+    std::uint64_t ticket = ring.tail.fetch_add(1u);
+    if ((ticket & CLOSED) != 0u) {
+      return Result::Closed;
+    }
+    bool full = ticket >= ring.head.load() + limit;
+    if (full || refused()) {
+      std::uint64_t expected = sequence(ticket, EMPTY);
+      ring.cells[ticket & ring.mask].sequence.compare_exchange_strong(
+          expected, sequence(ticket + ring.mask + 1u, EMPTY),
+          std::memory_order_relaxed);
+      if (!full) {
+        return Result::Refused;
+      }
+      break;
+    }
+
+    if (claim(ring, ticket, std::forward<U>(item))) {
+      return Result::Success;
+    }
+    if (!bounded() && ++lost == PATIENCE) {
+      break;
+    }
+  }
+
+  if (bounded()) {
+    return Result::Full;
+  }
+  ring.tail.fetch_or(CLOSED);
+  return Result::Closed;
+}
+
+// A consumer whose cell is still empty skips it for the next lap, while a
+// cell being written, or still holding the previous lap, is awaited, as
+// the thread holding that lap has already drawn its ticket. Without a
+// target, the item is destroyed.
+template <typename T>
+bool FetchAddContainer<T>::dequeue(Ring &ring, T *item) {
+  for (;;) {
+    if (ring.head.load() >= (ring.tail.load() & ~CLOSED)) {
+      return false;
+    }
+
+    std::uint64_t ticket = ring.head.fetch_add(1u);
+    Cell &cell = ring.cells[ticket & ring.mask];
+    std::uint64_t next = sequence(ticket + ring.mask + 1u, EMPTY);
+
+    for (unsigned spins{};; ++spins) {
+      std::uint64_t current = cell.sequence.load(std::memory_order_acquire);
+      if (current == sequence(ticket, FULL)) {
+        T *source = reinterpret_cast<T *>(&cell.storage);
+        try {
+          if (item != nullptr) {
+            *item = std::move(*source);
+          }
+        } catch (...) {
+          source->~T();
+          cell.sequence.store(next, std::memory_order_release);
+          throw;
+        }
+        source->~T();
+        cell.sequence.store(next, std::memory_order_release);
+        return true;
+      }
+      if (current == sequence(ticket, EMPTY)) {
+        if (cell.sequence.compare_exchange_weak(current, next,
+                                                std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (current >= next) {
+        // The producer gave the ticket up.
+        break;
+      } else {
+        detail::relax(spins);
+      }
+    }
+
+    if (ticket + 1u >= (ring.tail.load() & ~CLOSED)) {
+      return false;
+    }
+  }
+}
+
+// A bounded container keeps its only ring, which needs no protection.
+template <typename T>
+template <typename U>
+bool FetchAddContainer<T>::push(U &&item) {
+  if (bounded()) {
+    Result result = enqueue(*tailRing.load(std::memory_order_relaxed),
+                            std::forward<U>(item));
+    if (result == Result::Refused) {
+      throw ShutdownException("shutdown");
+    }
+    return result == Result::Success;
+  }
+
+  detail::HazardGuard guard;
+  for (;;) {
+    Ring *ring = guard.protect(tailRing);
+    Ring *next = ring->next.load();
+    if (next != nullptr) {
+      tailRing.compare_exchange_strong(ring, next);
+      continue;
+    }
+
+    switch (enqueue(*ring, std::forward<U>(item))) {
+      case Result::Success:
+        return true;
+      case Result::Full:
+        return false;
+      case Result::Refused:
+        throw ShutdownException("shutdown");
+      case Result::Closed:
+        break;
+    }
+
+    std::unique_ptr<Ring> fresh{new Ring{ringSize}};
+    Ring *expected{nullptr};
+    if (ring->next.compare_exchange_strong(expected, fresh.get())) {
+      tailRing.compare_exchange_strong(ring, fresh.release());
+    }
+  }
+}
+
+// A ring only gets a successor once closed, so that a closed ring found
+// empty after its successor was seen stays empty, and is unlinked.
+template <typename T>
+bool FetchAddContainer<T>::pop(T *item) {
+  if (bounded()) {
+    return dequeue(*headRing.load(std::memory_order_relaxed), item);
+  }
+
+  detail::HazardGuard guard;
+  for (;;) {
+    Ring *ring = guard.protect(headRing);
+    if (dequeue(*ring, item)) {
+      return true;
+    }
+    Ring *next = ring->next.load();
+    if (next == nullptr) {
+      return false;
+    }
+    if (dequeue(*ring, item)) {
+      return true;
+    }
+
+    Ring *expected{ring};
+    if (headRing.compare_exchange_strong(expected, next)) {
+      expected = ring;
+      tailRing.compare_exchange_strong(expected, next);
+      guard.reset();
+      retired.retire(ring);
+    }
+  }
+}
+
+// Only the first caller after a sleeper set the flag takes the mutex, and
+// moves to the next epoch, which wakes every sleeper up.
+template <typename T>
+void FetchAddContainer<T>::wake(std::atomic<std::uint64_t> &word,
+                                std::condition_variable &condition) {
+  if ((word.load() & 1u) == 0u) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock{sleepMtx};
+  std::uint64_t current = word.load(std::memory_order_relaxed);
+  if ((current & 1u) != 0u) {
+    word.store(current + 1u);
+    condition.notify_all();
+  }
+}
+
+template <typename T>
+void FetchAddContainer<T>::sleep(std::atomic<std::uint64_t> &word,
+                                 std::condition_variable &condition,
+                                 std::uint64_t seen) {
+  std::unique_lock<std::mutex> lock{sleepMtx};
+
+  condition.wait(lock, [&word, seen] { return word.load() / 2u != seen / 2u; });
+}
+
+template <typename T>
+void FetchAddContainer<T>::wakeAll() {
+  std::lock_guard<std::mutex> lock{sleepMtx};
+
+  writersWait.fetch_add(2u);
+  readersWait.fetch_add(2u);
+  notFull.notify_all();
+  notEmpty.notify_all();
+}
+
+// We signal to potential readers in case they sleep. A sleeper sets the
+// flag before retrying, and the producer reads it after drawing its
+// ticket, so that either the producer sees the flag or the retry sees the
+// ticket.
+template <typename T>
+template <typename U>
+bool FetchAddContainer<T>::tryPush(U &&item) {
+  if (refused()) {
+    throw ShutdownException("shutdown");
+  }
+  if (!push(std::forward<U>(item))) {
+    return false;
+  }
+  wake(readersWait, notEmpty);
+  return true;
+}
+
+template <typename T>
+template <typename U>
+void FetchAddContainer<T>::waitPush(U &&item) {
+  for (;;) {
+    if (tryPush(std::forward<U>(item))) {
+      return;
+    }
+    std::uint64_t seen = writersWait.fetch_or(1u);
+    if (tryPush(std::forward<U>(item))) {
+      return;
+    }
+    sleep(writersWait, notFull, seen);
+  }
+}
+
+template <typename T>
+bool FetchAddContainer<T>::tryAdd(const T &item) {
+  return tryPush(item);
+}
+
+// The item is only moved from if tryAdd succeeds.
+template <typename T>
+bool FetchAddContainer<T>::tryAdd(T &&item) {
+  return tryPush(std::move(item));
+}
+
+template <typename T>
+void FetchAddContainer<T>::waitAdd(const T &item) {
+  waitPush(item);
+}
+
+template <typename T>
+void FetchAddContainer<T>::waitAdd(T &&item) {
+  waitPush(std::move(item));
+}
+
+// The closed flag is read before looking for an item, so that a producer
+// adding one concurrently either is seen, or sees the flag.
+template <typename T>
+bool FetchAddContainer<T>::tryRemove(T &item) {
+  if (!inUse.load()) {
+    throw ShutdownException("shutdown");
+  }
+
+  bool wasClosed = closed.load();
+  if (!pop(&item)) {
+    if (wasClosed) {
+      throw ShutdownException("shutdown");
+    }
+    return false;
+  }
+  // We signal to potential writers in case they sleep.
+  wake(writersWait, notFull);
+  return true;
+}
+
+template <typename T>
+void FetchAddContainer<T>::waitRemove(T &item) {
+  for (;;) {
+    if (tryRemove(item)) {
+      return;
+    }
+    std::uint64_t seen = readersWait.fetch_or(1u);
+    if (tryRemove(item)) {
+      return;
+    }
+    sleep(readersWait, notEmpty, seen);
+  }
+}
+
+template <typename T>
+void FetchAddContainer<T>::shutdown() {
+  inUse.store(false);
+  wakeAll();
+}
+
+// After close, additions fail while removals drain the queue.
+template <typename T>
+void FetchAddContainer<T>::close() {
+  closed.store(true);
+  wakeAll();
+}
+
+// The clear method removes any elements present within the queue. This
+// method will do nothing when called while the queue is still in use.
+template <typename T>
+void FetchAddContainer<T>::clear() {
+  if (inUse.load()) {
+    return;
+  }
+  while (pop(nullptr)) {
+  }
+}
+
+// Rings are walked holding hazard pointers on the current and next rings.
+// A ring is only retired once the head ring moved past it, so the walk is
+// safe as long as the head ring has not changed, and starts over otherwise.
+template <typename T>
+typename FetchAddContainer<T>::size_type FetchAddContainer<T>::size() const {
+  if (bounded()) {
+    // Producers giving their tickets up may push the tail past capacity.
+    return std::min(headRing.load(std::memory_order_relaxed)->size(),
+                    maxSize);
+  }
+
+  detail::HazardGuard first, second, third;
+  detail::HazardGuard *held{&second}, *ahead{&third};
+  for (;;) {
+    Ring *head = first.protect(headRing);
+    Ring *ring = head;
+    size_type total{};
+    bool moved{false};
+
+    while (ring != nullptr && !moved) {
+      total += ring->size();
+      Ring *successor = ahead->protect(ring->next);
+      moved = headRing.load() != head;
+      std::swap(held, ahead);
+      ring = successor;
+    }
+    if (!moved) {
+      return total;
+    }
+  }
+}
+
+template <typename T>
+bool FetchAddContainer<T>::empty() const {
+  return size() == 0u;
+}
+
+template <typename T>
+bool FetchAddContainer<T>::full() const {
+  return bounded() && size() >= maxSize;
+}
+}  // namespace TSC
@@ -0,0 +1,195 @@
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "FetchAddContainer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{4u};
+constexpr size_t NB_READER_THREADS{4u};
+constexpr size_t NB_MESSAGES{5000u};
+
+using Queue = TSC::FetchAddContainer<size_t>;
+
+void sequential() {
+  Queue bounded{3u};
+  size_t item;
+
+  assert(bounded.empty() && !bounded.tryRemove(item));
+  assert(bounded.tryAdd(1u) && bounded.tryAdd(2u) && bounded.tryAdd(3u));
+  assert(!bounded.tryAdd(4u) && bounded.full() && bounded.size() == 3u);
+  assert(bounded.tryRemove(item) && item == 1u);
+  assert(bounded.tryAdd(4u) && !bounded.tryAdd(5u));
+  for (size_t expected{2u}; expected <= 4u; ++expected) {
+    bounded.waitRemove(item);
+    assert(item == expected);
+  }
+  assert(bounded.empty());
+
+  // Small rings are closed and replaced many times over.
+  Queue unbounded{Queue::UNBOUNDED, 4u};
+  for (size_t n{}; n < 1000u; ++n) {
+    assert(unbounded.tryAdd(n));
+  }
+  assert(unbounded.size() == 1000u && !unbounded.full());
+  for (size_t n{}; n < 1000u; ++n) {
+    assert(unbounded.tryRemove(item) && item == n);
+  }
+  assert(!unbounded.tryRemove(item) && unbounded.empty());
+
+  TSC::FetchAddContainer<std::unique_ptr<int>> pointers{1u};
+  std::unique_ptr<int> first{new int{1}}, second{new int{2}};
+  assert(pointers.tryAdd(std::move(first)) && !first);
+  assert(!pointers.tryAdd(std::move(second)) && second);
+}
+
+// Items left in the rings are destroyed with them, or by clear after a
+// shutdown.
+void lifetime() {
+  auto tracked = std::make_shared<int>(0);
+  {
+    TSC::FetchAddContainer<std::shared_ptr<int>> mtq{
+        TSC::FetchAddContainer<std::shared_ptr<int>>::UNBOUNDED, 2u};
+    for (int n{}; n < 7; ++n) {
+      mtq.waitAdd(tracked);
+    }
+    assert(tracked.use_count() == 8);
+    mtq.clear();
+    assert(tracked.use_count() == 8);
+    mtq.shutdown();
+    mtq.clear();
+    assert(tracked.use_count() == 1 && mtq.empty());
+  }
+  {
+    TSC::FetchAddContainer<std::shared_ptr<int>> mtq{
+        TSC::FetchAddContainer<std::shared_ptr<int>>::UNBOUNDED, 2u};
+    std::shared_ptr<int> item;
+    for (int n{}; n < 5; ++n) {
+      mtq.waitAdd(tracked);
+    }
+    mtq.waitRemove(item);
+    item.reset();
+    assert(tracked.use_count() == 5);
+  }
+  assert(tracked.use_count() == 1);
+}
+
+void closeAndShutdown() {
+  Queue mtq{1u};
+  size_t item;
+
+  mtq.waitAdd(1u);
+  std::thread writer{[&mtq] {
+    bool failed{false};
+    try {
+      mtq.waitAdd(2u);
+    } catch (const TSC::ShutdownException &e) {
+      failed = true;
+    }
+    assert(failed);
+    (void)failed;
+  }};
+  mtq.close();
+  writer.join();
+  mtq.waitRemove(item);
+  assert(item == 1u);
+  bool failed{false};
+  try {
+    mtq.waitRemove(item);
+  } catch (const TSC::ShutdownException &e) {
+    failed = true;
+  }
+  assert(failed);
+
+  Queue open{};
+  std::thread reader{[&open] {
+    size_t item;
+    bool failed{false};
+    try {
+      open.waitRemove(item);
+    } catch (const TSC::ShutdownException &e) {
+      failed = true;
+    }
+    assert(failed);
+    (void)failed;
+  }};
+  open.shutdown();
+  reader.join();
+}
+
+// Each writer sends increasing numbers tagged with its index, so that the
+// readers check the order of each writer along with the total. A watcher
+// walks the rings with size while they are appended and retired.
+void concurrent(size_t capacity, size_t ringSize) {
+  Queue mtq{capacity, ringSize};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> sums(NB_READER_THREADS, 0u);
+  std::atomic<bool> done{false};
+
+  std::thread watcher{[&mtq, &done, capacity] {
+    while (!done.load()) {
+      size_t size = mtq.size();
+      assert(capacity == Queue::UNBOUNDED || size <= capacity);
+      (void)size;
+      std::this_thread::yield();
+    }
+  }};
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq, w] {
+      for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+        mtq.waitAdd(n * NB_WRITER_THREADS + w);
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &sums, r] {
+      std::vector<size_t> last(NB_WRITER_THREADS, 0u);
+      size_t item;
+      try {
+        for (;;) {
+          mtq.waitRemove(item);
+          size_t writer = item % NB_WRITER_THREADS;
+          assert(item / NB_WRITER_THREADS > last[writer]);
+          last[writer] = item / NB_WRITER_THREADS;
+          sums[r] += item / NB_WRITER_THREADS;
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+  done.store(true);
+  watcher.join();
+
+  size_t total{};
+  for (auto sum : sums) {
+    total += sum;
+  }
+  assert(total == NB_WRITER_THREADS * NB_MESSAGES * (NB_MESSAGES + 1u) / 2u);
+  assert(mtq.empty());
+}
+
+int main() {
+  sequential();
+  lifetime();
+  closeAndShutdown();
+  concurrent(1u, Queue::DEFAULT_RING_SIZE);
+  concurrent(3u, Queue::DEFAULT_RING_SIZE);
+  concurrent(64u, Queue::DEFAULT_RING_SIZE);
+  concurrent(Queue::UNBOUNDED, 8u);
+  concurrent(Queue::UNBOUNDED, Queue::DEFAULT_RING_SIZE);
+
+  std::cout << "fetch add passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "Locks.hpp"
+#include "RingBuffer.hpp"
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// The FlatCombiningContainer is a bounded FIFO queue with the blocking and
+// non-blocking API of ThreadSafeContainer, for heavily contended queues.
+// A thread finding the combiner lock free executes its request at once.
+// Otherwise, instead of waiting for the lock in turn, it publishes the
+// request in a publication record, and the thread that holds the lock
+// executes every pending request against the ring in one pass, while the
+// ring and the records stay in its cache. The publisher spins on its own
+// record until it is served, or until the lock is free for it to combine.
+// Threads claim any free record for the time of one call, so the number
+// of records only bounds the number of requests combined at once. Waiting
+// calls that cannot be served sleep on a condition variable until the
+// queue is no longer empty or full.
+template <typename T>
+class FlatCombiningContainer {
+ public:
+  using size_type = std::size_t;
+
+ private:
+  enum class Op : std::uint8_t { Add, Remove, Shutdown, Close, Clear };
+
+  enum class Status : std::uint8_t {
+    Idle,
+    Pending,
+    Success,
+    Failure,
+    Shutdown,
+    Error
+  };
+
+  struct RecordFields {
+    std::atomic<bool> claimed{false};
+    std::atomic<Status> status{Status::Idle};
+    Op op{Op::Add};
+    const T *copyFrom{nullptr};
+    T *moveFrom{nullptr};
+    T *target{nullptr};
+    std::exception_ptr error;
+  };
+
+  // Records are padded to a cache line rather than aligned, as C++14 has
+  // no allocation function for over-aligned types.
+  struct Record : RecordFields {
+    char padding[detail::CACHE_LINE -
+                 sizeof(RecordFields) % detail::CACHE_LINE];
+  };
+
+  static constexpr size_type DEFAULT_RECORDS{64u};
+  static constexpr int PASSES{3};
+
+  size_type nbRecords;
+  std::unique_ptr<Record[]> records;
+  // The contended atomics are padded apart as well, keeping the container
+  // itself free of over-alignment.
+  char recordsPadding[detail::CACHE_LINE - sizeof(size_type) -
+                      sizeof(std::unique_ptr<Record[]>)];
+  std::atomic<bool> combining{false};
+  char combiningPadding[detail::CACHE_LINE - sizeof(std::atomic<bool>)];
+  std::atomic<size_type> pending{0u};
+  char pendingPadding[detail::CACHE_LINE - sizeof(std::atomic<size_type>)];
+  std::atomic<size_type> count{0u};
+  char countPadding[detail::CACHE_LINE - sizeof(std::atomic<size_type>)];
+  std::atomic<std::uint64_t> epoch{0u};
+  std::atomic<size_type> sleepers{0u};
+
+  // Guarded by the combiner lock.
+  RingBuffer<T> fifo;
+  bool inUse{true};
+  bool closed{false};
+
+  std::mutex sleepMtx;
+  std::condition_variable changed;
+
+  Record &claim();
+
+  bool tryLock();
+
+  // The unlock method releases the combiner lock, then wakes the sleeping
+  // waiters up if needed.
+  void unlock(bool wake);
+
+  // The submit method executes a request, or publishes it in a claimed
+  // record, and returns its outcome once it has been executed.
+  Status submit(Op op, const T *copyFrom, T *moveFrom, T *target);
+
+  // The outcome method releases the record of an executed request and
+  // rethrows its exception.
+  Status outcome(Record &record);
+
+  // The waitFor method submits the request until it succeeds, sleeping
+  // after each failure until the ring changes.
+  void waitFor(Op op, const T *copyFrom, T *moveFrom, T *target);
+
+  // The combine method executes the pending requests of every record, and
+  // returns true if sleeping waiters may have to be woken up.
+  bool combine();
+
+  bool execute(Record &record);
+
+  void push(Record &record, std::true_type);
+
+  void push(Record &record, std::false_type);
+
+  void notifyChange();
+
+ public:
+  explicit FlatCombiningContainer(size_type capacity,
+                                  size_type records = DEFAULT_RECORDS);
+
+  FlatCombiningContainer(const FlatCombiningContainer<T> &src) = delete;
+
+  FlatCombiningContainer<T> &operator=(
+      const FlatCombiningContainer<T> &rhs) = delete;
+
+  bool tryAdd(const T &item);
+
+  bool tryAdd(T &&item);
+
+  void waitAdd(const T &item);
+
+  void waitAdd(T &&item);
+
+  bool tryRemove(T &item);
+
+  void waitRemove(T &item);
+
+  void shutdown();
+
+  void close();
+
+  void clear();
+
+  // The size, empty and full methods read a counter updated by the
+  // combiners, without combining.
+  size_type size() const;
+
+  bool empty() const;
+
+  bool full() const;
+};
+}  // namespace TSC
+
+#include "FlatCombiningContainerPrivate.hpp"
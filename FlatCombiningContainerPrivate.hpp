@@ -0,0 +1,289 @@
+#pragma once
+
+namespace TSC {
+template <typename T>
+constexpr typename FlatCombiningContainer<T>::size_type
+    FlatCombiningContainer<T>::DEFAULT_RECORDS;
+
+template <typename T>
+FlatCombiningContainer<T>::FlatCombiningContainer(size_type capacity,
+                                                  size_type records)
+    : nbRecords{records > 0u ? records : 1u},
+      records{new Record[nbRecords]},
+      fifo{capacity} {}
+
+// Threads start scanning at a record chosen from their id, so that
+// they usually find the record they used last free.
+template <typename T>
+typename FlatCombiningContainer<T>::Record &
+FlatCombiningContainer<T>::claim() {
+  static thread_local size_type hint{
+      std::hash<std::thread::id>{}(std::this_thread::get_id())};
+
+  for (unsigned spins{};; ++spins) {
+    for (size_type i{}; i < nbRecords; ++i) {
+      Record &record = records[(hint + i) % nbRecords];
+      if (!record.claimed.load(std::memory_order_relaxed) &&
+          !record.claimed.exchange(true, std::memory_order_acquire)) {
+        return record;
+      }
+    }
+    detail::relax(spins);
+  }
+}
+
+template <typename T>
+bool FlatCombiningContainer<T>::tryLock() {
+  return !combining.load(std::memory_order_relaxed) &&
+         !combining.exchange(true, std::memory_order_acquire);
+}
+
+template <typename T>
+void FlatCombiningContainer<T>::unlock(bool wake) {
+  count.store(fifo.size(), std::memory_order_relaxed);
+  combining.store(false, std::memory_order_release);
+  if (wake) {
+    notifyChange();
+  }
+}
+
+template <typename T>
+typename FlatCombiningContainer<T>::Status FlatCombiningContainer<T>::submit(
+    Op op, const T *copyFrom, T *moveFrom, T *target) {
+  // Without contention, the request is executed at once by the caller,
+  // who then serves the requests published meanwhile.
+  if (tryLock()) {
+    Record record;
+    record.op = op;
+    record.copyFrom = copyFrom;
+    record.moveFrom = moveFrom;
+    record.target = target;
+    bool wake = execute(record);
+    unlock(combine() || wake);
+    return outcome(record);
+  }
+
+  Record &record = claim();
+  record.op = op;
+  record.copyFrom = copyFrom;
+  record.moveFrom = moveFrom;
+  record.target = target;
+  pending.fetch_add(1u, std::memory_order_relaxed);
+  record.status.store(Status::Pending, std::memory_order_release);
+
+  for (unsigned spins{};; ++spins) {
+    if (record.status.load(std::memory_order_acquire) != Status::Pending) {
+      break;
+    }
+    if (tryLock()) {
+      unlock(combine());
+      spins = 0u;
+    } else {
+      detail::relax(spins);
+    }
+  }
+  return outcome(record);
+}
+
+template <typename T>
+typename FlatCombiningContainer<T>::Status FlatCombiningContainer<T>::outcome(
+    Record &record) {
+  Status status = record.status.load(std::memory_order_acquire);
+  std::exception_ptr error = std::move(record.error);
+
+  record.error = nullptr;
+  record.status.store(Status::Idle, std::memory_order_relaxed);
+  record.claimed.store(false, std::memory_order_release);
+
+  if (status == Status::Error) {
+    std::rethrow_exception(error);
+  }
+  if (status == Status::Shutdown) {
+    throw ShutdownException("shutdown");
+  }
+  return status;
+}
+
+// A combining pass runs over the records a few times, as threads served
+// by the first run often publish their next request right away. Records
+// are only scanned while requests are pending.
+template <typename T>
+bool FlatCombiningContainer<T>::combine() {
+  bool wake{false};
+
+  for (int pass{};
+       pass < PASSES && pending.load(std::memory_order_relaxed) > 0u;
+       ++pass) {
+    for (size_type i{}; i < nbRecords; ++i) {
+      Record &record = records[i];
+      if (record.status.load(std::memory_order_acquire) == Status::Pending) {
+        wake = execute(record) || wake;
+        pending.fetch_sub(1u, std::memory_order_relaxed);
+      }
+    }
+  }
+  return wake;
+}
+
+// The execute method returns true when waiters may have to be woken up,
+// which is when the queue was previously empty or full, as for the
+// condition variables of ThreadSafeContainer, or when its state changed.
+template <typename T>
+bool FlatCombiningContainer<T>::execute(Record &record) {
+  Status status{Status::Success};
+  bool wake{true};
+
+  try {
+    switch (record.op) {
+      case Op::Add:
+        if (!inUse || closed) {
+          status = Status::Shutdown;
+        } else if (fifo.full()) {
+          status = Status::Failure;
+        } else {
+          push(record, std::is_copy_constructible<T>{});
+          wake = fifo.size() == 1u;
+        }
+        break;
+      case Op::Remove:
+        if (!inUse || (closed && fifo.empty())) {
+          status = Status::Shutdown;
+        } else if (fifo.empty()) {
+          status = Status::Failure;
+        } else {
+          wake = fifo.full();
+          fifo.popInto(*record.target);
+        }
+        break;
+      case Op::Shutdown:
+        inUse = false;
+        break;
+      case Op::Close:
+        closed = true;
+        break;
+      case Op::Clear:
+        if (!inUse) {
+          while (!fifo.empty()) {
+            fifo.pop();
+          }
+        }
+        break;
+    }
+  } catch (...) {
+    record.error = std::current_exception();
+    status = Status::Error;
+  }
+  record.status.store(status, std::memory_order_release);
+  return status == Status::Success && wake;
+}
+
+template <typename T>
+void FlatCombiningContainer<T>::push(Record &record, std::true_type) {
+  if (record.moveFrom != nullptr) {
+    fifo.push(std::move(*record.moveFrom));
+  } else {
+    fifo.push(*record.copyFrom);
+  }
+}
+
+// Items that cannot be copied are only ever added by move.
+template <typename T>
+void FlatCombiningContainer<T>::push(Record &record, std::false_type) {
+  fifo.push(std::move(*record.moveFrom));
+}
+
+// The epoch is bumped before the sleepers are read, while sleepers
+// register before reading the epoch, so that either the combiner sees
+// the sleeper or the sleeper sees the new epoch. The notification is
+// sent under the mutex the sleepers check the epoch under.
+template <typename T>
+void FlatCombiningContainer<T>::notifyChange() {
+  epoch.fetch_add(1u, std::memory_order_seq_cst);
+  if (sleepers.load(std::memory_order_seq_cst) > 0u) {
+    std::lock_guard<std::mutex> lock{sleepMtx};
+    changed.notify_all();
+  }
+}
+
+template <typename T>
+void FlatCombiningContainer<T>::waitFor(Op op, const T *copyFrom,
+                                        T *moveFrom, T *target) {
+  for (;;) {
+    std::uint64_t seen = epoch.load(std::memory_order_seq_cst);
+    if (submit(op, copyFrom, moveFrom, target) == Status::Success) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock{sleepMtx};
+    sleepers.fetch_add(1u, std::memory_order_seq_cst);
+    changed.wait(lock, [this, seen] {
+      return epoch.load(std::memory_order_seq_cst) != seen;
+    });
+    sleepers.fetch_sub(1u, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+bool FlatCombiningContainer<T>::tryAdd(const T &item) {
+  return submit(Op::Add, &item, nullptr, nullptr) == Status::Success;
+}
+
+// The item is only moved from if tryAdd succeeds.
+template <typename T>
+bool FlatCombiningContainer<T>::tryAdd(T &&item) {
+  return submit(Op::Add, nullptr, &item, nullptr) == Status::Success;
+}
+
+template <typename T>
+void FlatCombiningContainer<T>::waitAdd(const T &item) {
+  waitFor(Op::Add, &item, nullptr, nullptr);
+}
+
+template <typename T>
+void FlatCombiningContainer<T>::waitAdd(T &&item) {
+  waitFor(Op::Add, nullptr, &item, nullptr);
+}
+
+template <typename T>
+bool FlatCombiningContainer<T>::tryRemove(T &item) {
+  return submit(Op::Remove, nullptr, nullptr, &item) == Status::Success;
+}
+
+template <typename T>
+void FlatCombiningContainer<T>::waitRemove(T &item) {
+  waitFor(Op::Remove, nullptr, nullptr, &item);
+}
+
+template <typename T>
+void FlatCombiningContainer<T>::shutdown() {
+  submit(Op::Shutdown, nullptr, nullptr, nullptr);
+}
+
+// After close, additions fail while removals drain the queue.
+template <typename T>
+void FlatCombiningContainer<T>::close() {
+  submit(Op::Close, nullptr, nullptr, nullptr);
+}
+
+// The clear method removes any elements present within the queue. This
+// method will do nothing when called while the queue is still in use.
+template <typename T>
+void FlatCombiningContainer<T>::clear() {
+  submit(Op::Clear, nullptr, nullptr, nullptr);
+}
+
+template <typename T>
+typename FlatCombiningContainer<T>::size_type
+FlatCombiningContainer<T>::size() const {
+  return count.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+bool FlatCombiningContainer<T>::empty() const {
+  return size() == 0u;
+}
+
+template <typename T>
+bool FlatCombiningContainer<T>::full() const {
+  return size() == fifo.capacity();
+}
+}  // namespace TSC
@@ -0,0 +1,168 @@
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "FlatCombiningContainer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{8u};
+constexpr size_t NB_READER_THREADS{8u};
+constexpr size_t NB_MESSAGES{5000u};
+constexpr size_t NB_ITEMS{16u};
+constexpr size_t NB_RECORDS{4u};
+
+// Plain new must be enough to allocate the container under C++14.
+static_assert(alignof(TSC::FlatCombiningContainer<int>) <=
+                  alignof(std::max_align_t),
+              "the container must not be over-aligned");
+
+struct Fragile {
+  int value{};
+
+  Fragile() = default;
+
+  explicit Fragile(int value) : value{value} {}
+
+  Fragile(const Fragile &src) : value{src.value} {
+    if (value < 0) {
+      throw std::runtime_error("copy failed");
+    }
+  }
+
+  Fragile &operator=(const Fragile &rhs) = default;
+};
+
+void sequential() {
+  TSC::FlatCombiningContainer<int> mtq{2u};
+  int item;
+
+  assert(mtq.empty() && !mtq.tryRemove(item));
+  assert(mtq.tryAdd(1) && mtq.tryAdd(2) && !mtq.tryAdd(3));
+  assert(mtq.full() && mtq.size() == 2u);
+  assert(mtq.tryRemove(item) && item == 1);
+  mtq.waitRemove(item);
+  assert(item == 2 && mtq.empty());
+
+  // The item is only moved from if the addition succeeds.
+  TSC::FlatCombiningContainer<std::unique_ptr<int>> pointers{1u};
+  std::unique_ptr<int> first{new int{1}}, second{new int{2}};
+  assert(pointers.tryAdd(std::move(first)) && !first);
+  assert(!pointers.tryAdd(std::move(second)) && second);
+}
+
+// Exceptions thrown by the items are rethrown to the thread whose request
+// failed, not to the combiner.
+void exceptions() {
+  TSC::FlatCombiningContainer<Fragile> mtq{2u};
+  bool thrown{false};
+
+  try {
+    mtq.tryAdd(Fragile{-1});
+  } catch (const std::runtime_error &e) {
+    thrown = true;
+  }
+  assert(thrown && mtq.empty());
+  assert(mtq.tryAdd(Fragile{1}));
+}
+
+void closeAndShutdown() {
+  TSC::FlatCombiningContainer<int> mtq{NB_ITEMS};
+  int item;
+
+  mtq.waitAdd(1);
+  mtq.close();
+  bool failed{false};
+  try {
+    mtq.tryAdd(2);
+  } catch (const TSC::ShutdownException &e) {
+    failed = true;
+  }
+  assert(failed);
+  mtq.waitRemove(item);
+  assert(item == 1);
+
+  std::thread blocked{[&mtq] {
+    int item;
+    bool failed{false};
+    try {
+      mtq.waitRemove(item);
+    } catch (const TSC::ShutdownException &e) {
+      failed = true;
+    }
+    assert(failed);
+    (void)failed;
+  }};
+  blocked.join();
+
+  TSC::FlatCombiningContainer<int> open{1u};
+  open.waitAdd(1);
+  std::thread writer{[&open] {
+    bool failed{false};
+    try {
+      open.waitAdd(2);
+    } catch (const TSC::ShutdownException &e) {
+      failed = true;
+    }
+    assert(failed);
+    (void)failed;
+  }};
+  open.shutdown();
+  writer.join();
+  open.clear();
+  assert(open.empty());
+}
+
+// More threads than records, blocking on both ends.
+void concurrent() {
+  TSC::FlatCombiningContainer<size_t> mtq{NB_ITEMS, NB_RECORDS};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> sums(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+        mtq.waitAdd(n);
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &sums, r] {
+      size_t item;
+      try {
+        for (;;) {
+          mtq.waitRemove(item);
+          sums[r] += item;
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  size_t total{};
+  for (auto sum : sums) {
+    total += sum;
+  }
+  assert(total == NB_WRITER_THREADS * NB_MESSAGES * (NB_MESSAGES + 1u) / 2u);
+}
+
+int main() {
+  sequential();
+  exceptions();
+  closeAndShutdown();
+  concurrent();
+
+  std::cout << "flat combining passed" << std::endl;
+
+  return 0;
+}
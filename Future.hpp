@@ -0,0 +1,199 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace TSC {
+namespace detail {
+struct Unit {};
+
+// The state shared by a Promise and its Future. The value is constructed in
+// place, void results being stored as an empty Unit.
+template <typename T>
+class FutureState {
+ public:
+  using value_type =
+      typename std::conditional<std::is_void<T>::value, Unit, T>::type;
+
+  std::mutex mtx;
+  std::condition_variable ready;
+  bool done{false};
+  std::exception_ptr error;
+  typename std::aligned_storage<sizeof(value_type),
+                                alignof(value_type)>::type storage;
+
+  FutureState() = default;
+
+  FutureState(const FutureState &src) = delete;
+
+  FutureState &operator=(const FutureState &rhs) = delete;
+
+  ~FutureState() {
+    if (done && !error) {
+      value()->~value_type();
+    }
+  }
+
+  value_type *value() { return reinterpret_cast<value_type *>(&storage); }
+};
+}  // namespace detail
+
+// The Future is a lightweight single-shot counterpart of std::future,
+// returned by the asynchronous operations of the containers. Errors are
+// reported with the standard std::future_error codes.
+template <typename T>
+class Future {
+ private:
+  std::shared_ptr<detail::FutureState<T>> state;
+
+  template <typename U>
+  friend class Promise;
+
+  explicit Future(std::shared_ptr<detail::FutureState<T>> shared)
+      : state{std::move(shared)} {}
+
+  void check() const {
+    if (!state) {
+      throw std::future_error(std::future_errc::no_state);
+    }
+  }
+
+ public:
+  Future() = default;
+
+  bool valid() const { return static_cast<bool>(state); }
+
+  bool ready() const {
+    check();
+    std::lock_guard<std::mutex> lock{state->mtx};
+
+    return state->done;
+  }
+
+  void wait() const {
+    check();
+    std::unique_lock<std::mutex> lock{state->mtx};
+
+    state->ready.wait(lock, [this] { return state->done; });
+  }
+
+  template <typename Rep, typename Period>
+  bool waitFor(const std::chrono::duration<Rep, Period> &timeout) const {
+    check();
+    std::unique_lock<std::mutex> lock{state->mtx};
+
+    return state->ready.wait_for(lock, timeout, [this] { return state->done; });
+  }
+
+  // The get method waits for the result and hands it over, leaving the
+  // future invalid.
+  T get() {
+    wait();
+    std::shared_ptr<detail::FutureState<T>> shared = std::move(state);
+
+    if (shared->error) {
+      std::rethrow_exception(shared->error);
+    }
+    return static_cast<T>(std::move(*shared->value()));
+  }
+};
+
+// The Promise is the producing side of a Future. A promise destroyed
+// without having been satisfied breaks its future.
+template <typename T>
+class Promise {
+ private:
+  std::shared_ptr<detail::FutureState<T>> state;
+  bool retrieved;
+  bool satisfied;
+
+  // The take method returns the state to be satisfied, which
+  // happens at most once.
+  std::shared_ptr<detail::FutureState<T>> take() {
+    if (!state) {
+      throw std::future_error(std::future_errc::no_state);
+    }
+    if (satisfied) {
+      throw std::future_error(std::future_errc::promise_already_satisfied);
+    }
+    satisfied = true;
+    return state;
+  }
+
+  void breakPromise() {
+    if (state && !satisfied) {
+      setException(std::make_exception_ptr(
+          std::future_error(std::future_errc::broken_promise)));
+    }
+  }
+
+ public:
+  Promise()
+      : state{std::make_shared<detail::FutureState<T>>()},
+        retrieved{false},
+        satisfied{false} {}
+
+  // Builds a promise over a given state, which lets the state be allocated
+  // along with other data in a single block.
+  explicit Promise(std::shared_ptr<detail::FutureState<T>> shared)
+      : state{std::move(shared)}, retrieved{false}, satisfied{false} {}
+
+  Promise(Promise &&src) noexcept = default;
+
+  Promise &operator=(Promise &&rhs) noexcept {
+    if (this != &rhs) {
+      breakPromise();
+      state = std::move(rhs.state);
+      retrieved = rhs.retrieved;
+      satisfied = rhs.satisfied;
+    }
+    return *this;
+  }
+
+  ~Promise() { breakPromise(); }
+
+  Future<T> getFuture() {
+    if (!state) {
+      throw std::future_error(std::future_errc::no_state);
+    }
+    if (retrieved) {
+      throw std::future_error(std::future_errc::future_already_retrieved);
+    }
+    retrieved = true;
+    return Future<T>{state};
+  }
+
+  template <typename... Args>
+  void setValue(Args &&... args) {
+    using value_type = typename detail::FutureState<T>::value_type;
+    std::shared_ptr<detail::FutureState<T>> shared = take();
+    {
+      std::lock_guard<std::mutex> lock{shared->mtx};
+      try {
+        new (shared->value()) value_type(std::forward<Args>(args)...);
+      } catch (...) {
+        shared->error = std::current_exception();
+      }
+      shared->done = true;
+    }
+    shared->ready.notify_all();
+  }
+
+  void setException(std::exception_ptr error) {
+    std::shared_ptr<detail::FutureState<T>> shared = take();
+    {
+      std::lock_guard<std::mutex> lock{shared->mtx};
+      shared->error = std::move(error);
+      shared->done = true;
+    }
+    shared->ready.notify_all();
+  }
+};
+}  // namespace TSC
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "Locks.hpp"
+
+namespace TSC {
+namespace detail {
+// Hazard pointers let the lock-free containers delete the nodes they
+// unlink while other threads may still be reading them. A thread
+// announces each node it is about to read in one of its hazard slots, and
+// a retired node is only deleted once no slot announces it. Each thread
+// owns a record of slots from its first use to its exit, after which the
+// record is reused by another thread. Records are never freed, so that
+// scanning them needs no synchronization with exiting threads.
+class HazardDomain {
+ public:
+  static constexpr std::size_t SLOTS{4u};
+
+  struct RecordFields {
+    std::atomic<const void *> slots[SLOTS];
+    std::atomic<bool> active{true};
+    RecordFields *next{nullptr};
+    // The number of slots in use, only accessed by the owner.
+    std::size_t depth{0u};
+
+    RecordFields() {
+      for (auto &slot : slots) {
+        slot.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  // Records are padded to a cache line, so that announcing a node does not
+  // invalidate the records of other threads.
+  struct Record : RecordFields {
+    char padding[CACHE_LINE - sizeof(RecordFields) % CACHE_LINE];
+  };
+
+ private:
+  std::atomic<RecordFields *> records{nullptr};
+
+  HazardDomain() = default;
+
+ public:
+  // The domain outlives the threads releasing their records at exit.
+  static HazardDomain &global() {
+    static HazardDomain *domain{new HazardDomain};
+    return *domain;
+  }
+
+  Record *acquire() {
+    for (auto *record = records.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      bool expected{false};
+      if (!record->active.load(std::memory_order_relaxed) &&
+          record->active.compare_exchange_strong(expected, true,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+        return static_cast<Record *>(record);
+      }
+    }
+
+    auto *record = new Record;
+    RecordFields *head = records.load(std::memory_order_relaxed);
+    do {
+      record->next = head;
+    } while (!records.compare_exchange_weak(head, record,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+    return record;
+  }
+
+  void release(Record *record) {
+    for (auto &slot : record->slots) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+    record->active.store(false, std::memory_order_release);
+  }
+
+  // The announced method returns the sorted nodes announced by all
+  // threads.
+  std::vector<const void *> announced() const {
+    std::vector<const void *> nodes;
+
+    for (auto *record = records.load(std::memory_order_acquire);
+         record != nullptr; record = record->next) {
+      for (auto &slot : record->slots) {
+        const void *node = slot.load(std::memory_order_seq_cst);
+        if (node != nullptr) {
+          nodes.push_back(node);
+        }
+      }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+  }
+};
+
+class HazardOwner {
+ private:
+  HazardDomain::Record *record;
+
+ public:
+  HazardOwner() : record{HazardDomain::global().acquire()} {}
+
+  ~HazardOwner() { HazardDomain::global().release(record); }
+
+  HazardOwner(const HazardOwner &src) = delete;
+
+  HazardOwner &operator=(const HazardOwner &rhs) = delete;
+
+  static HazardDomain::Record &local() {
+    static thread_local HazardOwner owner;
+    return *owner.record;
+  }
+};
+
+// A HazardGuard holds one hazard slot of the calling thread for its
+// lifetime. Guards are scoped, and a thread holds at most SLOTS of them.
+class HazardGuard {
+ private:
+  HazardDomain::Record &record;
+  std::atomic<const void *> *slot;
+
+ public:
+  HazardGuard() : record{HazardOwner::local()} {
+    if (record.depth == HazardDomain::SLOTS) {
+      throw std::length_error("too many nested hazard guards");
+    }
+    slot = &record.slots[record.depth++];
+  }
+
+  ~HazardGuard() {
+    slot->store(nullptr, std::memory_order_release);
+    --record.depth;
+  }
+
+  HazardGuard(const HazardGuard &src) = delete;
+
+  HazardGuard &operator=(const HazardGuard &rhs) = delete;
+
+  // The protect method announces the node the source points to, and
+  // returns it once the source still points to it after the announcement,
+  // as a node can only be retired after being unlinked from its source.
+  template <typename Node>
+  Node *protect(const std::atomic<Node *> &source) {
+    Node *node = source.load(std::memory_order_relaxed);
+
+    for (;;) {
+      slot->store(node, std::memory_order_seq_cst);
+      Node *current = source.load(std::memory_order_seq_cst);
+      if (current == node) {
+        return node;
+      }
+      node = current;
+    }
+  }
+
+  void reset() { slot->store(nullptr, std::memory_order_release); }
+};
+
+// The RetiredList deletes the nodes retired by a container once they are
+// no longer announced, and the remaining ones along with the container.
+template <typename Node>
+class RetiredList {
+ private:
+  std::mutex mtx;
+  std::vector<std::unique_ptr<Node>> nodes;
+
+ public:
+  RetiredList() = default;
+
+  RetiredList(const RetiredList &src) = delete;
+
+  RetiredList &operator=(const RetiredList &rhs) = delete;
+
+  void retire(Node *node) {
+    std::lock_guard<std::mutex> lock{mtx};
+
+    nodes.emplace_back(node);
+    auto announced = HazardDomain::global().announced();
+    nodes.erase(std::remove_if(nodes.begin(), nodes.end(),
+                               [&announced](const std::unique_ptr<Node> &n) {
+                                 return !std::binary_search(
+                                     announced.begin(), announced.end(),
+                                     static_cast<const void *>(n.get()));
+                               }),
+                nodes.end());
+  }
+};
+}  // namespace detail
+}  // namespace TSC
@@ -0,0 +1,119 @@
+#include <cassert>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Locks.hpp"
+#include "ThreadSafeContainer.hpp"
+
+constexpr size_t NB_THREADS{6u};
+constexpr size_t NB_ITERATIONS{20000u};
+constexpr size_t NB_WRITER_THREADS{3u};
+constexpr size_t NB_READER_THREADS{3u};
+constexpr size_t NB_MESSAGES{3000u};
+constexpr size_t NB_ITEMS{8u};
+
+// The plain counter is only consistent if the lock excludes the other
+// threads, which the thread sanitizer checks as well.
+template <typename Lock>
+void exclusion() {
+  Lock lock;
+  size_t counter{};
+  std::vector<std::thread> threads;
+
+  for (size_t i{}; i < NB_THREADS; ++i) {
+    threads.emplace_back([&lock, &counter] {
+      for (size_t n{}; n < NB_ITERATIONS; ++n) {
+        std::lock_guard<Lock> guard{lock};
+        ++counter;
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  assert(counter == NB_THREADS * NB_ITERATIONS);
+}
+
+template <typename Lock>
+void tryLock() {
+  Lock first, second;
+
+  assert(first.try_lock());
+  // Queue locks can be held together by one thread.
+  second.lock();
+  std::thread other{[&first] {
+    bool locked = first.try_lock();
+    assert(!locked);
+    (void)locked;
+  }};
+  other.join();
+  first.unlock();
+  second.unlock();
+  assert(first.try_lock());
+  first.unlock();
+}
+
+// Waits of the container work with condition_variable_any.
+template <typename Lock>
+void container() {
+  TSC::ThreadSafeContainer<size_t, Lock> mtq{NB_ITEMS};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> sums(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+        mtq.waitAdd(n);
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &sums, r] {
+      for (size_t item : mtq.consume(4u)) {
+        sums[r] += item;
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  size_t total{};
+  for (auto sum : sums) {
+    total += sum;
+  }
+  assert(total == NB_WRITER_THREADS * NB_MESSAGES * (NB_MESSAGES + 1u) / 2u);
+}
+
+template <typename Lock>
+void basic() {
+  exclusion<Lock>();
+  container<Lock>();
+}
+
+template <typename Lock>
+void all() {
+  basic<Lock>();
+  tryLock<Lock>();
+}
+
+int main() {
+  all<std::mutex>();
+  all<TSC::TicketLock>();
+  all<TSC::McsLock>();
+  // ClhLock has no try_lock.
+  basic<TSC::ClhLock>();
+  all<TSC::AdaptiveMutex>();
+
+  std::cout << "locks passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace TSC {
+namespace detail {
+// Waits use std::condition_variable with std::mutex, and the slower
+// std::condition_variable_any, which works with any lock, otherwise.
+template <typename Lock>
+struct ConditionFor {
+  using type = std::condition_variable_any;
+};
+
+template <>
+struct ConditionFor<std::mutex> {
+  using type = std::condition_variable;
+};
+
+constexpr std::size_t CACHE_LINE{64u};
+
+// Spins with the pause instruction for a while, then yields, so that a
+// lock holder preempted on a busy machine gets the processor back.
+// Spinning is pointless on a single processor, where the thread awaited
+// cannot run meanwhile.
+inline void relax(unsigned spins) {
+  static const unsigned limit{std::thread::hardware_concurrency() > 1u ? 64u
+                                                                       : 0u};
+
+  if (spins < limit) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+  } else {
+    std::this_thread::yield();
+  }
+}
+
+// The queue locks need a node per acquisition, which lives from lock to
+// unlock, or longer for CLH. Each thread keeps its free nodes in a pool,
+// so that a thread may hold several queue locks at once.
+template <typename Node>
+class NodePool {
+ private:
+  std::vector<std::unique_ptr<Node>> nodes;
+
+ public:
+  static NodePool &local() {
+    static thread_local NodePool pool;
+    return pool;
+  }
+
+  Node *take() {
+    if (nodes.empty()) {
+      return new Node;
+    }
+    Node *node = nodes.back().release();
+    nodes.pop_back();
+    return node;
+  }
+
+  void give(Node *node) { nodes.emplace_back(node); }
+};
+}  // namespace detail
+
+// The TicketLock hands the lock over in arrival order. Threads draw a
+// ticket and wait for it to be served, every waiter spinning on the same
+// counter, which is kept apart from the ticket dispenser.
+class TicketLock {
+ private:
+  std::atomic<std::uint32_t> next{0u};
+  char padding[detail::CACHE_LINE - sizeof(std::atomic<std::uint32_t>)];
+  std::atomic<std::uint32_t> serving{0u};
+
+ public:
+  TicketLock() = default;
+
+  TicketLock(const TicketLock &src) = delete;
+
+  TicketLock &operator=(const TicketLock &rhs) = delete;
+
+  void lock() {
+    std::uint32_t ticket = next.fetch_add(1u, std::memory_order_relaxed);
+    for (unsigned spins{};
+         serving.load(std::memory_order_acquire) != ticket; ++spins) {
+      detail::relax(spins);
+    }
+  }
+
+  bool try_lock() {
+    std::uint32_t ticket = serving.load(std::memory_order_relaxed);
+    std::uint32_t expected{ticket};
+    return next.compare_exchange_strong(expected, ticket + 1u,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed);
+  }
+
+  void unlock() {
+    serving.store(serving.load(std::memory_order_relaxed) + 1u,
+                  std::memory_order_release);
+  }
+};
+
+// The McsLock queues waiters in a linked list of nodes, each waiter
+// spinning on its own node until its predecessor hands the lock over, so
+// that a release only touches the cache line of the next waiter.
+class McsLock {
+ private:
+  struct Node {
+    std::atomic<Node *> next{nullptr};
+    std::atomic<bool> locked{false};
+    char padding[detail::CACHE_LINE - sizeof(std::atomic<Node *>) -
+                 sizeof(std::atomic<bool>)];
+  };
+
+  std::atomic<Node *> tail{nullptr};
+  // The node of the holder, guarded by the lock itself.
+  Node *owner{nullptr};
+
+  static Node *take() {
+    Node *node = detail::NodePool<Node>::local().take();
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node->locked.store(true, std::memory_order_relaxed);
+    return node;
+  }
+
+ public:
+  McsLock() = default;
+
+  McsLock(const McsLock &src) = delete;
+
+  McsLock &operator=(const McsLock &rhs) = delete;
+
+  void lock() {
+    Node *node = take();
+    Node *pred = tail.exchange(node, std::memory_order_acq_rel);
+    if (pred != nullptr) {
+      pred->next.store(node, std::memory_order_release);
+      for (unsigned spins{}; node->locked.load(std::memory_order_acquire);
+           ++spins) {
+        detail::relax(spins);
+      }
+    }
+    owner = node;
+  }
+
+  bool try_lock() {
+    Node *node = take();
+    Node *expected{nullptr};
+    if (tail.compare_exchange_strong(expected, node,
+                                     std::memory_order_acquire,
+                                     std::memory_order_relaxed)) {
+      owner = node;
+      return true;
+    }
+    detail::NodePool<Node>::local().give(node);
+    return false;
+  }
+
+  void unlock() {
+    Node *node = owner;
+    Node *next = node->next.load(std::memory_order_acquire);
+
+    if (next == nullptr) {
+      Node *expected{node};
+      if (tail.compare_exchange_strong(expected, nullptr,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+        detail::NodePool<Node>::local().give(node);
+        return;
+      }
+      // A successor is linking itself in.
+      for (unsigned spins{};
+           (next = node->next.load(std::memory_order_acquire)) == nullptr;
+           ++spins) {
+        detail::relax(spins);
+      }
+    }
+    next->locked.store(false, std::memory_order_release);
+    detail::NodePool<Node>::local().give(node);
+  }
+};
+
+// The ClhLock queues waiters implicitly, each waiter spinning on the node
+// of its predecessor. Releasing only clears the node of the holder, which
+// remains in the queue until the successor takes it over as its next node.
+// It has no try_lock: the tail node may be recycled and queued again
+// between reading it and swapping it, which a plain compare and swap
+// cannot detect, so a try_lock could end up waiting. It is BasicLockable
+// only.
+class ClhLock {
+ private:
+  struct Node {
+    std::atomic<bool> locked{false};
+    char padding[detail::CACHE_LINE - sizeof(std::atomic<bool>)];
+  };
+
+  std::atomic<Node *> tail;
+  // The nodes of the holder and of its predecessor, guarded by the lock.
+  Node *owner{nullptr};
+  Node *ownerPred{nullptr};
+
+  void wait(Node *node, Node *pred) {
+    for (unsigned spins{}; pred->locked.load(std::memory_order_acquire);
+         ++spins) {
+      detail::relax(spins);
+    }
+    owner = node;
+    ownerPred = pred;
+  }
+
+ public:
+  ClhLock() : tail{new Node} {}
+
+  ~ClhLock() { delete tail.load(std::memory_order_relaxed); }
+
+  ClhLock(const ClhLock &src) = delete;
+
+  ClhLock &operator=(const ClhLock &rhs) = delete;
+
+  void lock() {
+    Node *node = detail::NodePool<Node>::local().take();
+    node->locked.store(true, std::memory_order_relaxed);
+    wait(node, tail.exchange(node, std::memory_order_acq_rel));
+  }
+
+  void unlock() {
+    Node *pred = ownerPred;
+    owner->locked.store(false, std::memory_order_release);
+    detail::NodePool<Node>::local().give(pred);
+  }
+};
+
+// The AdaptiveMutex spins for a while when the lock is taken, as holders
+// of a container lock release it quickly, then sleeps on a futex. The
+// state is 0 when free, 1 when held, and 2 when held with sleepers, so
+// that uncontended releases make no system call. Without futexes, the
+// waiters yield instead of sleeping.
+class AdaptiveMutex {
+ private:
+  std::atomic<int> state{0};
+
+  static_assert(sizeof(std::atomic<int>) == sizeof(int),
+                "the futex word must be a plain int");
+
+  void sleep() {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<int *>(&state), FUTEX_WAIT_PRIVATE, 2,
+            nullptr, nullptr, 0);
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  void wakeOne() {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<int *>(&state), FUTEX_WAKE_PRIVATE, 1,
+            nullptr, nullptr, 0);
+#endif
+  }
+
+ public:
+  AdaptiveMutex() = default;
+
+  AdaptiveMutex(const AdaptiveMutex &src) = delete;
+
+  AdaptiveMutex &operator=(const AdaptiveMutex &rhs) = delete;
+
+  bool try_lock() {
+    int expected{0};
+    return state.compare_exchange_strong(expected, 1,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed);
+  }
+
+  void lock() {
+    static const unsigned limit{
+        std::thread::hardware_concurrency() > 1u ? 100u : 0u};
+
+    for (unsigned spins{}; spins < limit; ++spins) {
+      if (state.load(std::memory_order_relaxed) == 0 && try_lock()) {
+        return;
+      }
+      detail::relax(0u);
+    }
+    if (try_lock()) {
+      return;
+    }
+    while (state.exchange(2, std::memory_order_acquire) != 0) {
+      sleep();
+    }
+  }
+
+  void unlock() {
+    if (state.exchange(0, std::memory_order_release) == 2) {
+      wakeOne();
+    }
+  }
+};
+}  // namespace TSC
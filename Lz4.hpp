@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace TSC {
+// A local implementation of the LZ4 block format: greedy matching over a
+// hash table of 4 byte sequences, without entropy coding. It trades ratio
+// for speed, which suits text payloads compressed on the producer side.
+// The block does not record the decompressed size, which the caller keeps.
+namespace Lz4 {
+namespace detail {
+constexpr std::size_t MIN_MATCH{4u};
+constexpr std::size_t LAST_LITERALS{5u};
+constexpr std::size_t MF_LIMIT{12u};
+constexpr std::size_t MAX_OFFSET{65535u};
+constexpr unsigned HASH_LOG{12u};
+
+inline std::uint32_t read32(const unsigned char *p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline std::size_t hash(std::uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32u - HASH_LOG);
+}
+
+inline unsigned char *writeLength(unsigned char *op, std::size_t length) {
+  while (length >= 255u) {
+    *op++ = 255u;
+    length -= 255u;
+  }
+  *op++ = static_cast<unsigned char>(length);
+  return op;
+}
+
+inline std::size_t readLength(const unsigned char *&ip,
+                              const unsigned char *end) {
+  std::size_t length{};
+  unsigned char byte;
+
+  do {
+    if (ip == end) {
+      throw std::runtime_error("truncated LZ4 block");
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255u);
+  return length;
+}
+
+// Writes the token and the literals of a sequence, and returns the token
+// so that the match length can be added to it.
+inline unsigned char *writeLiterals(unsigned char *&op,
+                                    const unsigned char *anchor,
+                                    std::size_t literals) {
+  unsigned char *token = op++;
+
+  *token = static_cast<unsigned char>((literals < 15u ? literals : 15u) << 4);
+  if (literals >= 15u) {
+    op = writeLength(op, literals - 15u);
+  }
+  std::memcpy(op, anchor, literals);
+  op += literals;
+  return token;
+}
+}  // namespace detail
+
+// Largest compressed size of an input of the given size.
+inline std::size_t bound(std::size_t size) { return size + size / 255u + 16u; }
+
+// The compress method writes the block into dst, which must hold at least
+// bound(size) bytes, and returns the compressed size.
+inline std::size_t compress(const char *src, std::size_t size, char *dst) {
+  using namespace detail;
+  auto begin = reinterpret_cast<const unsigned char *>(src);
+  auto end = begin + size;
+  auto ip = begin;
+  auto anchor = begin;
+  auto op = reinterpret_cast<unsigned char *>(dst);
+
+  if (size > MF_LIMIT) {
+    std::vector<std::uint32_t> table(std::size_t{1u} << HASH_LOG, 0u);
+    // The last match must start MF_LIMIT bytes before the end
+    // and leave at least LAST_LITERALS literals after it.
+    const unsigned char *searchLimit = end - MF_LIMIT;
+    const unsigned char *matchLimit = end - LAST_LITERALS;
+
+    while (ip <= searchLimit) {
+      std::uint32_t sequence = read32(ip);
+      std::size_t h = hash(sequence);
+      const unsigned char *ref = begin + table[h];
+      table[h] = static_cast<std::uint32_t>(ip - begin);
+
+      if (ref >= ip || static_cast<std::size_t>(ip - ref) > MAX_OFFSET ||
+          read32(ref) != sequence) {
+        // Incompressible input is skipped faster and faster.
+        ip += 1u + (static_cast<std::size_t>(ip - anchor) >> 6);
+        continue;
+      }
+      while (ip > anchor && ref > begin && ip[-1] == ref[-1]) {
+        --ip;
+        --ref;
+      }
+      const unsigned char *matchEnd = ip + MIN_MATCH;
+      const unsigned char *refEnd = ref + MIN_MATCH;
+      while (matchEnd < matchLimit && *matchEnd == *refEnd) {
+        ++matchEnd;
+        ++refEnd;
+      }
+
+      auto offset = static_cast<std::size_t>(ip - ref);
+      auto length = static_cast<std::size_t>(matchEnd - ip) - MIN_MATCH;
+      unsigned char *token =
+          writeLiterals(op, anchor, static_cast<std::size_t>(ip - anchor));
+      *op++ = static_cast<unsigned char>(offset & 0xffu);
+      *op++ = static_cast<unsigned char>(offset >> 8);
+      *token |= static_cast<unsigned char>(length < 15u ? length : 15u);
+      if (length >= 15u) {
+        op = writeLength(op, length - 15u);
+      }
+
+      ip = matchEnd;
+      anchor = ip;
+      if (ip <= searchLimit) {
+        auto position = static_cast<std::uint32_t>(ip - 2 - begin);
+        table[hash(read32(ip - 2))] = position;
+      }
+    }
+  }
+
+  writeLiterals(op, anchor, static_cast<std::size_t>(end - anchor));
+  return static_cast<std::size_t>(op - reinterpret_cast<unsigned char *>(dst));
+}
+
+inline std::string compress(const char *src, std::size_t size) {
+  std::string block(bound(size), '\0');
+
+  block.resize(compress(src, size, &block[0]));
+  return block;
+}
+
+// The decompress method expands the block into dst, which holds exactly the
+// original size. Malformed blocks throw instead of overflowing dst.
+inline void decompress(const char *src, std::size_t size, char *dst,
+                       std::size_t original) {
+  using namespace detail;
+  auto ip = reinterpret_cast<const unsigned char *>(src);
+  auto end = ip + size;
+  auto op = reinterpret_cast<unsigned char *>(dst);
+  auto outBegin = op;
+  auto outEnd = op + original;
+
+  for (;;) {
+    if (ip == end) {
+      throw std::runtime_error("truncated LZ4 block");
+    }
+    unsigned token = *ip++;
+    std::size_t literals = token >> 4;
+    if (literals == 15u) {
+      literals += readLength(ip, end);
+    }
+    if (literals > static_cast<std::size_t>(end - ip) ||
+        literals > static_cast<std::size_t>(outEnd - op)) {
+      throw std::runtime_error("corrupted LZ4 block");
+    }
+    std::memcpy(op, ip, literals);
+    ip += literals;
+    op += literals;
+    if (ip == end) {
+      break;
+    }
+
+    if (end - ip < 2) {
+      throw std::runtime_error("truncated LZ4 block");
+    }
+    std::size_t offset = ip[0] | static_cast<std::size_t>(ip[1]) << 8;
+    ip += 2;
+    std::size_t length = token & 15u;
+    if (length == 15u) {
+      length += readLength(ip, end);
+    }
+    length += MIN_MATCH;
+    if (offset == 0u || offset > static_cast<std::size_t>(op - outBegin) ||
+        length > static_cast<std::size_t>(outEnd - op)) {
+      throw std::runtime_error("corrupted LZ4 block");
+    }
+    // Matches may overlap their own output, hence the byte copy.
+    const unsigned char *ref = op - offset;
+    for (std::size_t i{}; i < length; ++i) {
+      op[i] = ref[i];
+    }
+    op += length;
+  }
+
+  if (op != outEnd) {
+    throw std::runtime_error("corrupted LZ4 block");
+  }
+}
+}  // namespace Lz4
+}  // namespace TSC
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+
+namespace TSC {
+// The MemoryBudget is a byte budget shared by any number of containers.
+// Charging and releasing are lock-free compare-and-swap loops on a single
+// counter. Only threads waiting for room take the mutex, and releasers
+// only take it when such waiters exist.
+class MemoryBudget {
+ public:
+  using size_type = std::size_t;
+
+ private:
+  const size_type maxBytes;
+  std::atomic<size_type> usedBytes{0u};
+  std::atomic<size_type> waiters{0u};
+  std::mutex mtx;
+  std::condition_variable released;
+
+ public:
+  explicit MemoryBudget(size_type limit) : maxBytes{limit} {}
+
+  MemoryBudget(const MemoryBudget &src) = delete;
+
+  MemoryBudget &operator=(const MemoryBudget &rhs) = delete;
+
+  // The tryCharge method returns true if the bytes fit within the budget
+  // and have been charged, and false otherwise.
+  bool tryCharge(size_type bytes) {
+    if (bytes > maxBytes) {
+      throw std::length_error("charge larger than the memory budget");
+    }
+
+    size_type current = usedBytes.load(std::memory_order_relaxed);
+    do {
+      if (bytes > maxBytes - current) {
+        return false;
+      }
+    } while (!usedBytes.compare_exchange_weak(current, current + bytes));
+    return true;
+  }
+
+  // The charge method blocks until the bytes fit within the budget and
+  // returns true, or returns false as soon as stop returns true. Whatever
+  // makes stop return true must be followed by a call to wake.
+  template <typename Predicate>
+  bool charge(size_type bytes, Predicate stop) {
+    if (tryCharge(bytes)) {
+      return true;
+    }
+
+    std::unique_lock<std::mutex> lock{mtx};
+    // The waiter is counted before checking the budget again, so that a
+    // concurrent release either lets the charge through or notifies.
+    waiters.fetch_add(1u);
+    bool charged{};
+    released.wait(lock, [&] { return (charged = tryCharge(bytes)) || stop(); });
+    waiters.fetch_sub(1u);
+    return charged;
+  }
+
+  void release(size_type bytes) {
+    usedBytes.fetch_sub(bytes);
+    if (waiters.load() > 0u) {
+      wake();
+    }
+  }
+
+  // The wake method gets the waiting threads to check their budget and
+  // stop condition again.
+  void wake() {
+    std::lock_guard<std::mutex> lock{mtx};
+
+    released.notify_all();
+  }
+
+  size_type limit() const { return maxBytes; }
+
+  size_type used() const { return usedBytes.load(std::memory_order_relaxed); }
+
+  // Number of threads blocked waiting for room.
+  size_type waiting() const { return waiters.load(std::memory_order_relaxed); }
+};
+}  // namespace TSC
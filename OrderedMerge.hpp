@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// An item stamped at enqueue time. In the global mode every producer draws
+// from one shared counter, in the per-producer mode each producer numbers
+// its own items and ordering is only restored within each producer.
+template <typename T>
+struct Sequenced {
+  std::uint32_t producer;
+  std::uint64_t sequence;
+  T value;
+};
+
+enum class SequenceMode { Global, PerProducer };
+
+// The GlobalSequence is shared by every producer. Items must be stamped
+// once, right before being added, and kept with their stamp if tryAdd
+// fails, otherwise the merging consumer sees a gap.
+class GlobalSequence {
+ private:
+  std::atomic<std::uint64_t> next{0u};
+
+ public:
+  template <typename T>
+  Sequenced<T> stamp(std::uint32_t producer, T value) {
+    return Sequenced<T>{producer,
+                        next.fetch_add(1u, std::memory_order_relaxed),
+                        std::move(value)};
+  }
+};
+
+// The ProducerSequence is owned by a single producer thread.
+class ProducerSequence {
+ private:
+  std::uint32_t producer;
+  std::uint64_t next;
+
+ public:
+  explicit ProducerSequence(std::uint32_t id) : producer{id}, next{0u} {}
+
+  template <typename T>
+  Sequenced<T> stamp(T value) {
+    return Sequenced<T>{producer, next++, std::move(value)};
+  }
+};
+
+// The OrderedMerger reassembles the stamped items spread over several shard
+// containers. Items are pulled from every shard into a reorder buffer and
+// released in sequence order. When the reorder buffer holds window items
+// without the expected sequence, the missing sequence is considered lost
+// and delivery resumes at the smallest buffered sequence. Items arriving
+// after their sequence was skipped are handed to the late handler, if any,
+// and dropped. A merger is meant to be driven by a single consumer thread.
+template <typename T>
+class OrderedMerger {
+ public:
+  using LateHandler = std::function<void(Sequenced<T> &&)>;
+
+ private:
+  struct Later {
+    bool operator()(const Sequenced<T> &lhs, const Sequenced<T> &rhs) const {
+      return lhs.sequence > rhs.sequence;
+    }
+  };
+
+  struct Stream {
+    std::uint64_t expected{0u};
+    std::priority_queue<Sequenced<T>, std::vector<Sequenced<T>>, Later>
+        pending;
+  };
+
+  std::vector<ThreadSafeContainer<Sequenced<T>> *> shards;
+  std::vector<bool> open;
+  SequenceMode mode;
+  std::size_t window;
+  std::size_t buffered;
+  std::map<std::uint32_t, Stream> streams;
+  LateHandler late;
+
+  Stream &streamOf(const Sequenced<T> &item) {
+    return streams[mode == SequenceMode::Global ? 0u : item.producer];
+  }
+
+  bool pop(Stream &stream, Sequenced<T> &item) {
+    item = stream.pending.top();
+    stream.pending.pop();
+    stream.expected = item.sequence + 1u;
+    --buffered;
+    return true;
+  }
+
+  // Releases an item whose predecessors were all delivered.
+  bool popReady(Sequenced<T> &item) {
+    for (auto &entry : streams) {
+      Stream &stream = entry.second;
+      if (!stream.pending.empty() &&
+          stream.pending.top().sequence == stream.expected) {
+        return pop(stream, item);
+      }
+    }
+    return false;
+  }
+
+  // Skips the gap of the stream holding the most buffered items.
+  bool popOldest(Sequenced<T> &item) {
+    Stream *fullest{nullptr};
+    for (auto &entry : streams) {
+      if (fullest == nullptr ||
+          entry.second.pending.size() > fullest->pending.size()) {
+        fullest = &entry.second;
+      }
+    }
+    return fullest != nullptr && !fullest->pending.empty() &&
+           pop(*fullest, item);
+  }
+
+  // Buffers an item, unless its sequence was already skipped.
+  void accept(Sequenced<T> &&item) {
+    Stream &stream = streamOf(item);
+
+    if (item.sequence < stream.expected) {
+      if (late) {
+        late(std::move(item));
+      }
+      return;
+    }
+    stream.pending.push(std::move(item));
+    ++buffered;
+  }
+
+  // Moves the immediately available items into the reorder buffer, one
+  // item per shard and pass, so that a busy shard cannot fill the window
+  // while the expected item waits in another one. Returns false once every
+  // shard has been shut down.
+  bool poll(bool &progress) {
+    bool pass{true};
+    Sequenced<T> item;
+
+    while (pass && buffered < window) {
+      pass = false;
+      for (std::size_t i{}; i < shards.size() && buffered < window; ++i) {
+        if (!open[i]) {
+          continue;
+        }
+        try {
+          if (shards[i]->tryRemove(item)) {
+            accept(std::move(item));
+            progress = true;
+            pass = true;
+          }
+        } catch (const ShutdownException &e) {
+          open[i] = false;
+        }
+      }
+    }
+    return std::find(open.begin(), open.end(), true) != open.end();
+  }
+
+ public:
+  OrderedMerger(std::vector<ThreadSafeContainer<Sequenced<T>> *> sources,
+                SequenceMode sequenceMode, std::size_t reorderWindow,
+                LateHandler onLate = LateHandler{})
+      : shards{std::move(sources)},
+        open(shards.size(), true),
+        mode{sequenceMode},
+        window{std::max<std::size_t>(reorderWindow, 1u)},
+        buffered{0u},
+        late{std::move(onLate)} {}
+
+  // The tryRemove method returns true if the next item in sequence order
+  // is available, and false otherwise.
+  bool tryRemove(Sequenced<T> &item) {
+    if (popReady(item)) {
+      return true;
+    }
+
+    bool progress{false};
+    bool anyOpen = poll(progress);
+    if (popReady(item)) {
+      return true;
+    }
+    if (buffered >= window || (!anyOpen && buffered > 0u)) {
+      return popOldest(item);
+    }
+    if (!anyOpen) {
+      throw ShutdownException("shutdown");
+    }
+    return false;
+  }
+
+  // The waitRemove method blocks until the next item in sequence order is
+  // available. As items may arrive through any shard, waiting relies on
+  // polling with an exponential backoff capped to one millisecond. Once
+  // every shard is shut down, the buffered items are delivered and a
+  // ShutdownException is thrown.
+  void waitRemove(Sequenced<T> &item) {
+    std::chrono::microseconds backoff{0};
+
+    while (!tryRemove(item)) {
+      if (backoff.count() == 0) {
+        std::this_thread::yield();
+        backoff = std::chrono::microseconds{1};
+      } else {
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, std::chrono::microseconds{1000});
+      }
+    }
+  }
+
+  std::size_t pending() const { return buffered; }
+};
+}  // namespace TSC
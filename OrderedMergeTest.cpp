@@ -0,0 +1,191 @@
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "OrderedMerge.hpp"
+#include "RandomGenerator.hpp"
+
+constexpr size_t NB_SHARDS{3u};
+constexpr size_t NB_PRODUCERS{4u};
+constexpr size_t NB_ITEMS_PER_PRODUCER{2000u};
+constexpr size_t NB_ITEMS{16u};
+constexpr size_t WINDOW{1024u};
+
+using Shard = TSC::ThreadSafeContainer<TSC::Sequenced<int>>;
+
+std::vector<Shard *> pointers(std::vector<std::unique_ptr<Shard>> &shards) {
+  std::vector<Shard *> result;
+
+  for (auto &shard : shards) {
+    result.push_back(shard.get());
+  }
+  return result;
+}
+
+void globalOrder() {
+  std::vector<std::unique_ptr<Shard>> shards;
+  for (size_t i{}; i < NB_SHARDS; ++i) {
+    shards.emplace_back(new Shard{NB_ITEMS});
+  }
+  TSC::GlobalSequence sequence;
+  std::vector<std::thread> producers;
+
+  for (size_t p{}; p < NB_PRODUCERS; ++p) {
+    producers.emplace_back([&shards, &sequence, p] {
+      for (size_t i{}; i < NB_ITEMS_PER_PRODUCER; ++i) {
+        auto item = sequence.stamp(static_cast<uint32_t>(p), 0);
+        shards[static_cast<size_t>(RND::pick(0, NB_SHARDS - 1))]->waitAdd(
+            item);
+      }
+    });
+  }
+
+  TSC::OrderedMerger<int> merger{pointers(shards), TSC::SequenceMode::Global,
+                                 WINDOW};
+  TSC::Sequenced<int> item;
+  for (uint64_t expected{}; expected < NB_PRODUCERS * NB_ITEMS_PER_PRODUCER;
+       ++expected) {
+    merger.waitRemove(item);
+    assert(item.sequence == expected);
+  }
+
+  for (auto &t : producers) {
+    t.join();
+  }
+  for (auto &shard : shards) {
+    shard->shutdown();
+  }
+  try {
+    merger.waitRemove(item);
+    assert(false);
+  } catch (const TSC::ShutdownException &e) {
+  }
+}
+
+void perProducerOrder() {
+  std::vector<std::unique_ptr<Shard>> shards;
+  for (size_t i{}; i < NB_SHARDS; ++i) {
+    shards.emplace_back(new Shard{NB_ITEMS});
+  }
+  std::vector<std::thread> producers;
+
+  for (size_t p{}; p < NB_PRODUCERS; ++p) {
+    producers.emplace_back([&shards, p] {
+      TSC::ProducerSequence sequence{static_cast<uint32_t>(p)};
+      for (size_t i{}; i < NB_ITEMS_PER_PRODUCER; ++i) {
+        shards[static_cast<size_t>(RND::pick(0, NB_SHARDS - 1))]->waitAdd(
+            sequence.stamp(static_cast<int>(i)));
+      }
+    });
+  }
+
+  TSC::OrderedMerger<int> merger{pointers(shards),
+                                 TSC::SequenceMode::PerProducer, WINDOW};
+  std::vector<uint64_t> expected(NB_PRODUCERS, 0u);
+  TSC::Sequenced<int> item;
+  for (size_t n{}; n < NB_PRODUCERS * NB_ITEMS_PER_PRODUCER; ++n) {
+    merger.waitRemove(item);
+    assert(item.sequence == expected[item.producer]);
+    assert(item.value == static_cast<int>(item.sequence));
+    ++expected[item.producer];
+  }
+
+  for (auto &t : producers) {
+    t.join();
+  }
+}
+
+void lostSequence() {
+  std::vector<std::unique_ptr<Shard>> shards;
+  shards.emplace_back(new Shard{NB_ITEMS});
+  TSC::GlobalSequence sequence;
+
+  for (int i{}; i < 10; ++i) {
+    auto item = sequence.stamp(0u, i);
+    if (i != 3) {
+      shards.front()->tryAdd(item);
+    }
+  }
+
+  TSC::OrderedMerger<int> merger{pointers(shards), TSC::SequenceMode::Global,
+                                 4u};
+  TSC::Sequenced<int> item;
+  for (uint64_t expected : {0u, 1u, 2u, 4u, 5u, 6u, 7u, 8u, 9u}) {
+    merger.waitRemove(item);
+    assert(item.sequence == expected);
+  }
+  assert(!merger.tryRemove(item));
+}
+
+// The expected item sits in a later shard while the first one holds more
+// items than the window, which must not be taken for a gap.
+void smallWindow() {
+  std::vector<std::unique_ptr<Shard>> shards;
+  for (size_t i{}; i < NB_SHARDS; ++i) {
+    shards.emplace_back(new Shard{NB_ITEMS});
+  }
+  TSC::GlobalSequence sequence;
+
+  for (int i{}; i < 24; ++i) {
+    auto item = sequence.stamp(0u, i);
+    size_t shard = i == 0 || (i >= 13 && i < 16) ? 1u : i < 13 ? 0u : 2u;
+    assert(shards[shard]->tryAdd(item));
+  }
+
+  TSC::OrderedMerger<int> merger{pointers(shards), TSC::SequenceMode::Global,
+                                 4u};
+  TSC::Sequenced<int> item;
+  for (uint64_t expected{}; expected < 24u; ++expected) {
+    merger.waitRemove(item);
+    assert(item.sequence == expected);
+  }
+  assert(!merger.tryRemove(item));
+}
+
+// An item arriving after its sequence was skipped goes to the late
+// handler instead of stalling the stream.
+void lateSequence() {
+  std::vector<std::unique_ptr<Shard>> shards;
+  shards.emplace_back(new Shard{NB_ITEMS});
+  TSC::GlobalSequence sequence;
+  std::vector<TSC::Sequenced<int>> stamped;
+  std::vector<uint64_t> late;
+
+  for (int i{}; i < 10; ++i) {
+    stamped.push_back(sequence.stamp(0u, i));
+  }
+  for (int i{}; i < 8; ++i) {
+    if (i != 3) {
+      shards.front()->tryAdd(stamped[static_cast<size_t>(i)]);
+    }
+  }
+
+  TSC::OrderedMerger<int> merger{
+      pointers(shards), TSC::SequenceMode::Global, 4u,
+      [&late](TSC::Sequenced<int> &&item) { late.push_back(item.sequence); }};
+  TSC::Sequenced<int> item;
+  for (uint64_t expected : {0u, 1u, 2u, 4u, 5u, 6u, 7u}) {
+    merger.waitRemove(item);
+    assert(item.sequence == expected);
+  }
+  shards.front()->tryAdd(stamped[3]);
+  shards.front()->tryAdd(stamped[8]);
+  merger.waitRemove(item);
+  assert(item.sequence == 8u);
+  assert(late.size() == 1u && late.front() == 3u);
+  assert(merger.pending() == 0u);
+}
+
+int main() {
+  globalOrder();
+  perProducerOrder();
+  lostSequence();
+  smallWindow();
+  lateSequence();
+
+  std::cout << "ordered merge passed" << std::endl;
+
+  return 0;
+}
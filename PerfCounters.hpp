@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace TSC {
+// The PerfCounters class opens one perf_event_open counter per event for the
+// calling process. Counters are opened disabled and inherited by threads
+// created after the constructor, so benchmark threads are spawned once the
+// counters exist, and start() and stop() enable and disable them in every
+// thread around the measured span.
+// Events the kernel refuses (missing PMU, perf_event_paranoid, containers)
+// are reported as unavailable instead of failing the run.
+class PerfCounters {
+ public:
+  enum Event {
+    Cycles,
+    Instructions,
+    CacheMisses,
+    LlcMisses,
+    BranchMisses,
+    ContextSwitches,
+    CpuMigrations,
+    NB_EVENTS
+  };
+
+  struct Sample {
+    std::array<double, NB_EVENTS> values{};
+    std::array<bool, NB_EVENTS> valid{};
+  };
+
+ private:
+  std::array<int, NB_EVENTS> fds;
+
+#ifdef __linux__
+  static int open(std::uint32_t type, std::uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    // Scheduler events are raised in kernel mode, so only hardware events
+    // are restricted to user space to cope with perf_event_paranoid.
+    attr.exclude_kernel = type == PERF_TYPE_SOFTWARE ? 0 : 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+  }
+#endif
+
+ public:
+  PerfCounters() {
+    fds.fill(-1);
+#ifdef __linux__
+    fds[Cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[Instructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[CacheMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fds[LlcMisses] = open(PERF_TYPE_HW_CACHE,
+                          PERF_COUNT_HW_CACHE_LL |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    fds[BranchMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fds[ContextSwitches] =
+        open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+    fds[CpuMigrations] = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS);
+#endif
+  }
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters &src) = delete;
+
+  PerfCounters &operator=(const PerfCounters &rhs) = delete;
+
+  bool available() const {
+    for (int fd : fds) {
+      if (fd >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static const char *name(Event event) {
+    static const char *const names[NB_EVENTS]{
+        "cycles",        "instructions", "cache-misses", "LLC-misses",
+        "branch-misses", "ctx-switches", "migrations"};
+    return names[event];
+  }
+
+  void start() {
+#ifdef __linux__
+    for (int fd : fds) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  // The stop method disables the counters and returns their values, scaled
+  // up when the kernel had to multiplex the hardware counters.
+  Sample stop() {
+    Sample sample;
+#ifdef __linux__
+    for (int i{}; i < NB_EVENTS; ++i) {
+      if (fds[i] < 0) {
+        continue;
+      }
+      ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+      std::uint64_t data[3]{};
+      if (read(fds[i], data, sizeof(data)) == sizeof(data) && data[2] != 0u) {
+        sample.values[i] = static_cast<double>(data[0]) *
+                           static_cast<double>(data[1]) /
+                           static_cast<double>(data[2]);
+        sample.valid[i] = true;
+      }
+    }
+#endif
+    return sample;
+  }
+};
+}  // namespace TSC
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// In the ordered mode items are handed to the callback one at a time in
+// queue order, by a single worker. In the unordered mode several workers
+// invoke the callback in parallel.
+enum class Dispatch { Ordered, Unordered };
+
+// The PushConsumer removes items from a container with a set of worker
+// threads and hands them to a callback, in place of reader threads looping
+// on waitRemove. Workers remove items in batches whose size adapts to the
+// backlog: it doubles while removals come back full, up to maxBatch, and
+// halves while they come back less than half full. An idle worker blocks
+// in waitRemoveBulk without spinning. Workers stop when the container is
+// shut down, or once it is closed and drained.
+template <typename T, typename Callback>
+class PushConsumer {
+ public:
+  using size_type = typename RingBuffer<T>::size_type;
+
+  static constexpr size_type DEFAULT_MAX_BATCH{64u};
+
+ private:
+  ThreadSafeContainer<T> &queue;
+  Callback callback;
+  size_type maxBatch;
+  std::vector<std::thread> workers;
+  std::mutex mtx;
+  std::exception_ptr error;
+  std::vector<T> lost;
+
+  void work();
+
+ public:
+  PushConsumer(ThreadSafeContainer<T> &container, Callback function,
+               size_type concurrency, Dispatch mode = Dispatch::Unordered,
+               size_type batch = DEFAULT_MAX_BATCH);
+
+  // The destructor shuts the container down and waits for the workers.
+  ~PushConsumer();
+
+  PushConsumer(const PushConsumer &src) = delete;
+
+  PushConsumer &operator=(const PushConsumer &rhs) = delete;
+
+  // The join method waits for the workers to stop, and rethrows the first
+  // exception a callback has thrown, if any.
+  void join();
+
+  // The stop method shuts the container down and joins the workers.
+  void stop();
+
+  // The undelivered method returns, once the workers stopped, the items
+  // removed from the container whose callback threw or was never called
+  // because an earlier callback of the batch threw. Items still in the
+  // container are left there.
+  std::vector<T> undelivered();
+};
+
+// Helper deducing the callback type.
+template <typename T, typename Callback>
+std::unique_ptr<PushConsumer<T, Callback>> makePushConsumer(
+    ThreadSafeContainer<T> &container, Callback function,
+    typename RingBuffer<T>::size_type concurrency,
+    Dispatch mode = Dispatch::Unordered,
+    typename RingBuffer<T>::size_type batch =
+        PushConsumer<T, Callback>::DEFAULT_MAX_BATCH) {
+  return std::unique_ptr<PushConsumer<T, Callback>>{
+      new PushConsumer<T, Callback>{container, std::move(function),
+                                    concurrency, mode, batch}};
+}
+
+template <typename T, typename Callback>
+constexpr typename PushConsumer<T, Callback>::size_type
+    PushConsumer<T, Callback>::DEFAULT_MAX_BATCH;
+
+template <typename T, typename Callback>
+PushConsumer<T, Callback>::PushConsumer(ThreadSafeContainer<T> &container,
+                                        Callback function,
+                                        size_type concurrency, Dispatch mode,
+                                        size_type batch)
+    : queue{container},
+      callback{std::move(function)},
+      maxBatch{std::max<size_type>(batch, 1u)} {
+  size_type count =
+      mode == Dispatch::Ordered ? 1u : std::max<size_type>(concurrency, 1u);
+
+  for (size_type i{}; i < count; ++i) {
+    workers.emplace_back(&PushConsumer::work, this);
+  }
+}
+
+template <typename T, typename Callback>
+PushConsumer<T, Callback>::~PushConsumer() {
+  queue.shutdown();
+  for (auto &worker : workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+// A callback throwing an exception, a ShutdownException included, shuts
+// the container down, which stops every worker, and the rest of its batch
+// is kept for undelivered. Only a shutdown seen by the removal itself
+// stops the worker quietly.
+template <typename T, typename Callback>
+void PushConsumer<T, Callback>::work() {
+  std::vector<T> batch;
+  size_type size{1u};
+  size_type next{};
+
+  batch.reserve(maxBatch);
+  try {
+    for (;;) {
+      batch.clear();
+      next = 0u;
+      size_type count{};
+      try {
+        count = queue.waitRemoveBulk(std::back_inserter(batch), size);
+      } catch (const ShutdownException &e) {
+        return;
+      }
+      for (; next < batch.size(); ++next) {
+        callback(batch[next]);
+      }
+      if (count == size) {
+        size = std::min(size * 2u, maxBatch);
+      } else if (2u * count < size) {
+        size = std::max<size_type>(size / 2u, 1u);
+      }
+    }
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock{mtx};
+      if (!error) {
+        error = std::current_exception();
+      }
+      std::move(batch.begin() + static_cast<std::ptrdiff_t>(next),
+                batch.end(), std::back_inserter(lost));
+    }
+    queue.shutdown();
+  }
+}
+
+template <typename T, typename Callback>
+void PushConsumer<T, Callback>::join() {
+  for (auto &worker : workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock{mtx};
+  if (error) {
+    std::exception_ptr first = error;
+    error = nullptr;
+    std::rethrow_exception(first);
+  }
+}
+
+template <typename T, typename Callback>
+void PushConsumer<T, Callback>::stop() {
+  queue.shutdown();
+  join();
+}
+
+template <typename T, typename Callback>
+std::vector<T> PushConsumer<T, Callback>::undelivered() {
+  std::lock_guard<std::mutex> lock{mtx};
+  std::vector<T> items;
+
+  items.swap(lost);
+  return items;
+}
+}  // namespace TSC
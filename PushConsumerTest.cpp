@@ -0,0 +1,174 @@
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "PushConsumer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{3u};
+constexpr size_t NB_WORKERS{4u};
+constexpr size_t NB_MESSAGES{20000u};
+constexpr size_t NB_ITEMS{256u};
+
+void bulkRemoval() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  std::vector<int> items;
+
+  for (int n{}; n < 10; ++n) {
+    mtq.waitAdd(n);
+  }
+  size_t count = mtq.tryRemoveBulk(std::back_inserter(items), 4u);
+  assert(count == 4u && items.size() == 4u && items[3] == 3);
+  count = mtq.waitRemoveBulk(std::back_inserter(items), 100u);
+  assert(count == 6u && items.size() == 10u && items[9] == 9);
+  assert(mtq.tryRemoveBulk(std::back_inserter(items), 100u) == 0u);
+}
+
+void unordered() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  std::atomic<long> sum{0};
+  std::atomic<size_t> received{0u};
+  std::vector<std::thread> writers;
+
+  auto consumer = TSC::makePushConsumer(
+      mtq,
+      [&sum, &received](int item) {
+        sum += item;
+        ++received;
+      },
+      NB_WORKERS);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+        mtq.waitAdd(static_cast<int>(n));
+      }
+    });
+  }
+  for (auto &t : writers) {
+    t.join();
+  }
+  // The workers stop by themselves once the queue is drained.
+  mtq.close();
+  consumer->join();
+
+  assert(received.load() == NB_WRITER_THREADS * NB_MESSAGES);
+  assert(sum.load() == static_cast<long>(NB_WRITER_THREADS * NB_MESSAGES *
+                                         (NB_MESSAGES + 1u) / 2u));
+}
+
+void ordered() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  int last{};
+
+  auto consumer = TSC::makePushConsumer(
+      mtq,
+      [&last](int item) {
+        assert(item == last + 1);
+        last = item;
+      },
+      NB_WORKERS, TSC::Dispatch::Ordered);
+
+  for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+    mtq.waitAdd(static_cast<int>(n));
+  }
+  mtq.close();
+  consumer->join();
+  assert(last == static_cast<int>(NB_MESSAGES));
+}
+
+// A failing callback stops the dispatch and is reported by join.
+void failure() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+
+  auto consumer = TSC::makePushConsumer(
+      mtq,
+      [](int item) {
+        if (item == 5) {
+          throw std::runtime_error("rejected");
+        }
+      },
+      NB_WORKERS);
+
+  try {
+    for (int n{}; n < 10; ++n) {
+      mtq.waitAdd(n);
+    }
+  } catch (const TSC::ShutdownException &e) {
+  }
+  try {
+    consumer->join();
+    assert(false);
+  } catch (const std::runtime_error &e) {
+  }
+}
+
+// The items removed along with the one whose callback threw are handed
+// back. With the items queued up front, the single ordered worker removes
+// batches of 1, 2, 4 and 4 items.
+void undelivered() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  std::vector<int> delivered;
+
+  for (int n{}; n < 10; ++n) {
+    mtq.waitAdd(n);
+  }
+  auto consumer = TSC::makePushConsumer(
+      mtq,
+      [&delivered](int item) {
+        if (item == 5) {
+          throw std::runtime_error("rejected");
+        }
+        delivered.push_back(item);
+      },
+      1u, TSC::Dispatch::Ordered);
+
+  try {
+    consumer->join();
+    assert(false);
+  } catch (const std::runtime_error &e) {
+  }
+  assert((delivered == std::vector<int>{0, 1, 2, 3, 4}));
+  assert((consumer->undelivered() == std::vector<int>{5, 6}));
+  assert(consumer->undelivered().empty() && mtq.size() == 3u);
+}
+
+// A ShutdownException thrown by the callback is an error like any other.
+void callbackShutdown() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+
+  for (int n{}; n < 10; ++n) {
+    mtq.waitAdd(n);
+  }
+  auto consumer = TSC::makePushConsumer(
+      mtq,
+      [](int item) {
+        if (item == 5) {
+          throw TSC::ShutdownException("callback");
+        }
+      },
+      1u, TSC::Dispatch::Ordered);
+
+  try {
+    consumer->join();
+    assert(false);
+  } catch (const TSC::ShutdownException &e) {
+  }
+  assert((consumer->undelivered() == std::vector<int>{5, 6}));
+}
+
+int main() {
+  bulkRemoval();
+  unordered();
+  ordered();
+  failure();
+  undelivered();
+  callbackShutdown();
+
+  std::cout << "push consumer passed" << std::endl;
+
+  return 0;
+}
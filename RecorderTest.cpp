@@ -0,0 +1,101 @@
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+#include "WorkloadReplayer.hpp"
+
+#ifndef TSC_ENABLE_RECORDER
+#error "RecorderTest requires TSC_ENABLE_RECORDER"
+#endif
+
+constexpr size_t NB_THREADS{3u};
+constexpr size_t NB_OPERATIONS{200u};
+constexpr size_t NB_ITEMS{16u};
+
+void producer(TSC::ThreadSafeContainer<int> &mtq) {
+  for (size_t i{}; i < NB_OPERATIONS; ++i) {
+    if (!mtq.tryAdd(static_cast<int>(i))) {
+      mtq.waitAdd(static_cast<int>(i));
+    }
+  }
+}
+
+void consumer(TSC::ThreadSafeContainer<int> &mtq) {
+  int item;
+
+  for (size_t i{}; i < NB_OPERATIONS; ++i) {
+    if (!mtq.tryRemove(item)) {
+      mtq.waitRemove(item);
+    }
+  }
+}
+
+int main() {
+  auto &recorder = TSC::Recorder::instance();
+  std::vector<std::thread> threads;
+
+  {
+    TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+
+    recorder.reset();
+    recorder.start();
+    for (size_t i{}; i < NB_THREADS; ++i) {
+      threads.emplace_back(producer, std::ref(mtq));
+      threads.emplace_back(consumer, std::ref(mtq));
+    }
+    // Restarting moves the time origin under the recording threads.
+    threads.emplace_back([&recorder] {
+      for (size_t i{}; i < NB_OPERATIONS / 10u; ++i) {
+        recorder.start();
+        std::this_thread::yield();
+      }
+    });
+    for (auto &t : threads) {
+      t.join();
+    }
+    mtq.shutdown();
+    recorder.stop();
+  }
+
+  TSC::Trace trace = recorder.snapshot();
+  size_t shutdowns{}, adds{}, removes{};
+  for (const auto &event : trace) {
+    assert(event.occupancy <= NB_ITEMS);
+    if (event.op == TSC::TraceOp::Shutdown) {
+      ++shutdowns;
+    } else if (event.outcome == TSC::TraceOutcome::Success) {
+      bool add = event.op == TSC::TraceOp::TryAdd ||
+                 event.op == TSC::TraceOp::WaitAdd;
+      ++(add ? adds : removes);
+    }
+  }
+  assert(shutdowns == 1u);
+  assert(adds == NB_THREADS * NB_OPERATIONS);
+  assert(removes == NB_THREADS * NB_OPERATIONS);
+
+  const char *path = "RecorderTest.trace";
+  TSC::TraceFile::save(path, trace);
+  TSC::Trace loaded = TSC::TraceFile::load(path);
+  std::remove(path);
+  assert(loaded.size() == trace.size());
+  for (size_t i{}; i < trace.size(); ++i) {
+    assert(loaded[i].timestamp == trace[i].timestamp);
+    assert(loaded[i].op == trace[i].op);
+  }
+
+  // Replaying must not be recorded again.
+  TSC::ThreadSafeContainer<int> replayed{NB_ITEMS};
+  TSC::ReplayStats stats = TSC::replay(loaded, replayed, 0);
+  assert(stats.threads == 2u * NB_THREADS + 1u);
+  assert(stats.operations <= loaded.size());
+  assert(recorder.snapshot().size() == trace.size());
+
+  std::cout << "replayed " << stats.operations << " operations on "
+            << stats.threads << " threads in " << stats.elapsed.count()
+            << " ns" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+
+namespace TSC {
+// A type is trivially relocatable when moving an object to a new address
+// and ending the lifetime of the original can be done with memcpy, without
+// running the move constructor and the destructor. Trivially copyable
+// types always are. Other types, such as those owning a heap pointer, can
+// opt in by specializing this trait.
+template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+struct IsTriviallyRelocatable<std::unique_ptr<T>> : std::true_type {};
+}  // namespace TSC
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Relocatable.hpp"
+#include "SimdCopy.hpp"
+
+namespace TSC {
+// The RingBuffer is the preallocated storage behind ThreadSafeContainer. It
+// is not synchronized by itself. Besides the usual FIFO operations, slots
+// can be reserved by producers and filled in place before being committed,
+// and consumers can acquire published slots to process them in place before
+// releasing them. The occupied slots therefore form three consecutive
+// regions starting at head: slots acquired by consumers, published slots,
+// and slots reserved by producers. Reserved slots are published in
+// reservation order, once every earlier reservation has been committed or
+// cancelled, which keeps the FIFO order. Cancelled reservations remain in
+// the published region until they reach its front, where they are skipped.
+// Consumers may also hold slots for items they removed but may hand back,
+// which count against the capacity without being part of any region.
+template <typename T>
+class RingBuffer {
+ public:
+  using size_type = std::size_t;
+
+ private:
+  enum class State : std::uint8_t {
+    Free,
+    Reserved,
+    Committed,
+    Cancelled,
+    Acquired,
+    Released
+  };
+
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  size_type maxSize;
+  std::unique_ptr<Storage[]> storage;
+  std::vector<State> states;
+  size_type head;
+  size_type acquired;
+  size_type published;
+  size_type reserved;
+  size_type held;
+
+  size_type wrap(size_type position) const {
+    return position < maxSize ? position : position - maxSize;
+  }
+
+  // Frees the released slots found at head.
+  void reclaim() {
+    while (acquired > 0u && states[head] == State::Released) {
+      states[head] = State::Free;
+      head = wrap(head + 1u);
+      --acquired;
+    }
+  }
+
+  // Skips the cancelled reservations found at the published front.
+  void normalize() {
+    size_type front = wrap(head + acquired);
+    while (published > 0u && states[front] == State::Cancelled) {
+      states[front] = State::Released;
+      ++acquired;
+      --published;
+      front = wrap(front + 1u);
+    }
+    reclaim();
+  }
+
+  void popInto(T &item, std::true_type) {
+    size_type position = acquire();
+    item.~T();
+    std::memcpy(static_cast<void *>(&item), slot(position), sizeof(T));
+    states[position] = State::Released;
+    reclaim();
+  }
+
+  void popInto(T &item, std::false_type) {
+    item = std::move(front());
+    pop();
+  }
+
+  static const T *address(const T *items) { return items; }
+
+  static const T *address(std::move_iterator<T *> items) {
+    return items.base();
+  }
+
+  // Position of the first free slot.
+  size_type end() const { return wrap(head + acquired + published + reserved); }
+
+  // Constructs an item in the free slot before head, as the first
+  // published item.
+  void pushFront(T &&item) {
+    size_type position = wrap(head + maxSize - 1u);
+    new (slot(position)) T(std::move(item));
+    states[position] = State::Committed;
+    head = position;
+    ++published;
+  }
+
+  template <typename InputIt>
+  void pushBulk(InputIt first, size_type count, std::true_type) {
+    size_type position = end();
+    size_type split = std::min(count, maxSize - position);
+
+    const T *items = address(first);
+
+    Simd::copy(slot(position), items, split * sizeof(T));
+    Simd::copy(slot(0u), items + split, (count - split) * sizeof(T));
+    for (size_type i{}; i < count; ++i) {
+      states[wrap(position + i)] = State::Committed;
+    }
+    reserved += count;
+    publish();
+  }
+
+  template <typename InputIt>
+  void pushBulk(InputIt first, size_type count, std::false_type) {
+    for (size_type i{}; i < count; ++i, ++first) {
+      emplace(*first);
+    }
+  }
+
+  size_type popBulk(T *out, size_type maxItems, std::true_type) {
+    size_type count{};
+
+    while (count < maxItems && published > 0u) {
+      // Relocates the longest run of committed slots that is
+      // contiguous in memory, cancelled slots breaking runs.
+      size_type front = wrap(head + acquired);
+      size_type limit =
+          std::min(std::min(maxItems - count, published), maxSize - front);
+      size_type run{};
+      while (run < limit && states[front + run] == State::Committed) {
+        out[count + run].~T();
+        states[front + run] = State::Released;
+        ++run;
+      }
+      Simd::copy(static_cast<void *>(out + count), slot(front),
+                 run * sizeof(T));
+      acquired += run;
+      published -= run;
+      count += run;
+      normalize();
+    }
+    return count;
+  }
+
+  size_type popBulk(T *out, size_type maxItems, std::false_type) {
+    size_type count{};
+
+    for (; count < maxItems && published > 0u; ++count) {
+      out[count] = std::move(front());
+      pop();
+    }
+    return count;
+  }
+
+  void publish() {
+    size_type tail = wrap(head + acquired + published);
+    while (reserved > 0u && (states[tail] == State::Committed ||
+                             states[tail] == State::Cancelled)) {
+      ++published;
+      --reserved;
+      tail = wrap(tail + 1u);
+    }
+    normalize();
+  }
+
+ public:
+  explicit RingBuffer(size_type capacity)
+      : maxSize{capacity},
+        storage{new Storage[capacity > 0u ? capacity : 1u]},
+        states(capacity, State::Free),
+        head{0u},
+        acquired{0u},
+        published{0u},
+        reserved{0u},
+        held{0u} {}
+
+  ~RingBuffer() {
+    for (size_type i{}; i < maxSize; ++i) {
+      if (states[i] == State::Committed || states[i] == State::Acquired) {
+        slot(i)->~T();
+      }
+    }
+  }
+
+  RingBuffer(const RingBuffer &src) = delete;
+
+  RingBuffer &operator=(const RingBuffer &rhs) = delete;
+
+  T *slot(size_type position) {
+    return reinterpret_cast<T *>(&storage[position]);
+  }
+
+  // Number of published items, including cancelled reservations that have
+  // not reached the front yet.
+  size_type size() const { return published; }
+
+  bool empty() const { return published == 0u; }
+
+  // Number of slots in use, whatever their region, and held slots.
+  size_type occupancy() const {
+    return acquired + published + reserved + held;
+  }
+
+  bool full() const { return occupancy() == maxSize; }
+
+  size_type capacity() const { return maxSize; }
+
+  // The reserve method returns the position of a free slot at the tail,
+  // which must not be full.
+  size_type reserve() {
+    size_type position = end();
+    states[position] = State::Reserved;
+    ++reserved;
+    return position;
+  }
+
+  // The commit method publishes a reserved slot holding a constructed
+  // item, along with the following committed reservations.
+  void commit(size_type position) {
+    states[position] = State::Committed;
+    publish();
+  }
+
+  // The cancel method abandons a reserved slot holding no item.
+  void cancel(size_type position) {
+    states[position] = State::Cancelled;
+    publish();
+  }
+
+  // The acquire method hands the published front slot over to a consumer,
+  // and the buffer must not be empty.
+  size_type acquire() {
+    size_type position = wrap(head + acquired);
+    states[position] = State::Acquired;
+    ++acquired;
+    --published;
+    normalize();
+    return position;
+  }
+
+  // The release method destroys the item of an acquired slot.
+  void release(size_type position) {
+    slot(position)->~T();
+    states[position] = State::Released;
+    reclaim();
+  }
+
+  template <typename... Args>
+  void emplace(Args &&... args) {
+    size_type position = reserve();
+    try {
+      new (slot(position)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      cancel(position);
+      throw;
+    }
+    commit(position);
+  }
+
+  void push(const T &item) { emplace(item); }
+
+  void push(T &&item) { emplace(std::move(item)); }
+
+  T &front() { return *slot(wrap(head + acquired)); }
+
+  void pop() { release(acquire()); }
+
+  // The popInto method moves the front item into item and frees its slot.
+  // Trivially relocatable items are transferred with memcpy, the slot being
+  // freed without running the destructor of the item it held.
+  void popInto(T &item) { popInto(item, IsTriviallyRelocatable<T>{}); }
+
+  // The pushBulk method appends count items read from first, which must
+  // fit. Items of trivially copyable types read through a pointer, or
+  // moved through a std::move_iterator over a pointer, are copied with
+  // the copy kernels of SimdCopy.hpp, in two segments when they wrap around
+  // the end of the buffer. Other items are constructed one at a time.
+  template <typename InputIt>
+  void pushBulk(InputIt first, size_type count) {
+    using Iterator = typename std::decay<InputIt>::type;
+    pushBulk(first, count,
+             std::integral_constant<
+                 bool, std::is_trivially_copyable<T>::value &&
+                           (std::is_same<Iterator, T *>::value ||
+                            std::is_same<Iterator, const T *>::value ||
+                            std::is_same<Iterator,
+                                         std::move_iterator<T *>>::value)>{});
+  }
+
+  // The hold method keeps count slots for items a consumer removed, and
+  // the unhold method frees them.
+  void hold(size_type count) { held += count; }
+
+  void unhold(size_type count) { held -= count; }
+
+  // The restore method moves count items back into held slots, ahead of
+  // the published items. While slots are acquired the front is taken, and
+  // the items are appended behind the reservations instead. The held slots
+  // are freed even if a move throws.
+  void restore(T *items, size_type count) {
+    size_type left{count};
+
+    try {
+      for (; left > 0u; --left) {
+        if (acquired > 0u) {
+          emplace(std::move(items[count - left]));
+        } else {
+          pushFront(std::move(items[left - 1u]));
+        }
+        --held;
+      }
+    } catch (...) {
+      held -= left;
+      throw;
+    }
+  }
+
+  // The popBulk method moves up to maxItems published items into out and
+  // returns their number. Trivially relocatable items are transferred with
+  // the copy kernels, the items of out being destroyed first.
+  size_type popBulk(T *out, size_type maxItems) {
+    return popBulk(out, maxItems, IsTriviallyRelocatable<T>{});
+  }
+};
+}  // namespace TSC
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "HazardPointers.hpp"
+#include "Locks.hpp"
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// The SegmentedContainer is an unbounded queue, in the style of the
+// ConcurrentQueue of moodycamel, where each producer owns a sub-queue of
+// segments, so that additions never contend, and consumers rotate across
+// the sub-queues. Items are only in FIFO order per producer. A producer is
+// either explicit, holding a ProducerToken for as long as it needs it, or
+// implicit, using the sub-queue its thread acquired on its first addition
+// without a token, until it exits. Released sub-queues are reused by the
+// next producer, after their remaining items.
+//
+// The producer constructs items in its last segment and publishes them by
+// storing the segment tail, and links a new segment once it is full.
+// Consumers claim runs of items from the first segment of a sub-queue with
+// compare-and-swap on its head, which moves a whole batch in one step, and
+// unlink segments once drained, which are deleted when no thread announces
+// them in its hazard pointers. A ConsumerToken keeps the position of a
+// consumer in the rotation, which moves on after QUOTA items, or when the
+// sub-queue is empty. Consumers without a token use one per thread.
+//
+// An addition racing with close reads the flag after publishing its items,
+// and takes back those no consumer claimed yet, so that a consumer finding
+// the closed queue empty either sees the items, or the producer sees the
+// flag. Waiting removals sleep as in FetchAddContainer.
+template <typename T>
+class SegmentedContainer {
+ public:
+  using size_type = std::size_t;
+
+  static constexpr size_type DEFAULT_SEGMENT_SIZE{256u};
+
+  static constexpr size_type QUOTA{256u};
+
+ private:
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  struct Segment {
+    std::atomic<size_type> head{0u};
+    char headPadding[detail::CACHE_LINE - sizeof(std::atomic<size_type>)];
+    std::atomic<size_type> tail{0u};
+    char tailPadding[detail::CACHE_LINE - sizeof(std::atomic<size_type>)];
+    std::atomic<Segment *> next{nullptr};
+    // The position of the first item within the sub-queue, for size.
+    size_type base;
+    size_type capacity;
+    std::unique_ptr<Storage[]> items;
+
+    Segment(size_type capacity, size_type base);
+
+    ~Segment();
+
+    T *slot(size_type position) {
+      return reinterpret_cast<T *>(&items[position]);
+    }
+  };
+
+  struct SubQueueFields {
+    std::atomic<Segment *> headSegment;
+    std::atomic<Segment *> tailSegment;
+    std::atomic<bool> owned{true};
+    // Set once the sub-queue is published, as sub-queues are never
+    // unlinked.
+    SubQueueFields *next{nullptr};
+  };
+
+  struct SubQueue : SubQueueFields {
+    char padding[detail::CACHE_LINE -
+                 sizeof(SubQueueFields) % detail::CACHE_LINE];
+
+    explicit SubQueue(size_type segmentSize);
+
+    ~SubQueue();
+  };
+
+  // The sub-queues outlive the container while an exiting thread is
+  // releasing its implicit producer.
+  struct SubQueueList {
+    std::atomic<SubQueueFields *> head{nullptr};
+
+    SubQueueList() = default;
+
+    ~SubQueueList();
+  };
+
+ public:
+  class ProducerToken {
+   private:
+    friend class SegmentedContainer<T>;
+
+    SubQueue *subQueue;
+
+   public:
+    explicit ProducerToken(SegmentedContainer<T> &queue)
+        : subQueue{queue.acquire()} {}
+
+    ~ProducerToken() {
+      subQueue->owned.store(false, std::memory_order_release);
+    }
+
+    ProducerToken(const ProducerToken &src) = delete;
+
+    ProducerToken &operator=(const ProducerToken &rhs) = delete;
+  };
+
+  class ConsumerToken {
+   private:
+    friend class SegmentedContainer<T>;
+
+    SubQueue *current{nullptr};
+    size_type taken{0u};
+
+   public:
+    ConsumerToken() = default;
+  };
+
+ private:
+  // The implicit producer and consumer of a thread, for each container
+  // of this type it used.
+  struct Implicit {
+    std::uint64_t id;
+    std::weak_ptr<SubQueueList> subQueues;
+    SubQueue *producer{nullptr};
+    ConsumerToken consumer;
+  };
+
+  struct ImplicitTable {
+    std::vector<Implicit> entries;
+
+    ~ImplicitTable();
+  };
+
+  size_type segmentSize;
+  std::uint64_t id;
+  std::shared_ptr<SubQueueList> subQueues;
+  detail::RetiredList<Segment> retired;
+  std::atomic<bool> inUse{true};
+  std::atomic<bool> closed{false};
+
+  // The wait word holds an epoch times two, plus one while consumers may
+  // sleep on it.
+  alignas(64) std::atomic<std::uint64_t> readersWait{0u};
+  std::mutex sleepMtx;
+  std::condition_variable notEmpty;
+
+  static std::uint64_t nextId();
+
+  Implicit &implicit();
+
+  bool refused() const;
+
+  SubQueue *acquire();
+
+  SubQueue &producer();
+
+  Segment &extend(SubQueue &subQueue, Segment &segment);
+
+  // The reclaim method takes back the run of items in [first, last) of the
+  // last segment that no consumer claimed, and returns where it starts.
+  static size_type reclaim(Segment &segment, size_type first, size_type last);
+
+  // The retract method destroys the items reclaimed in [first, last), and
+  // returns their number. Given the input the items were read from, which
+  // points to the item at first, they are handed back to it beforehand
+  // when it is a forward iterator, so that a std::move_iterator input
+  // gets them back.
+  static size_type retract(Segment &segment, size_type first, size_type last);
+
+  template <typename InputIt>
+  static size_type retract(Segment &segment, size_type first, size_type last,
+                           InputIt items);
+
+  template <typename InputIt>
+  static void giveBack(Segment &segment, size_type first, size_type last,
+                       InputIt items, std::forward_iterator_tag);
+
+  template <typename InputIt>
+  static void giveBack(Segment &segment, size_type first, size_type last,
+                       InputIt items, std::input_iterator_tag);
+
+  template <typename U>
+  void push(SubQueue &subQueue, U &&item);
+
+  template <typename InputIt>
+  size_type pushBulk(SubQueue &subQueue, InputIt first, size_type count);
+
+  // The take method moves a run of up to maxItems items from the first
+  // segment of the sub-queue to out.
+  template <typename OutputIt>
+  size_type take(SubQueue &subQueue, OutputIt &out, size_type maxItems);
+
+  template <typename OutputIt>
+  size_type removeBulk(ConsumerToken &token, OutputIt out,
+                       size_type maxItems);
+
+  template <typename OutputIt>
+  size_type waitBulk(ConsumerToken &token, OutputIt out, size_type maxItems);
+
+  void wake();
+
+  static void restore(const T &item, T &taken);
+
+  static void restore(T &&item, T &taken);
+
+ public:
+  explicit SegmentedContainer(size_type segmentSize = DEFAULT_SEGMENT_SIZE);
+
+  ~SegmentedContainer();
+
+  SegmentedContainer(const SegmentedContainer<T> &src) = delete;
+
+  SegmentedContainer<T> &operator=(const SegmentedContainer<T> &rhs) =
+      delete;
+
+  // The additions never fail while the container is in use, and waitAdd
+  // is the same as tryAdd.
+  bool tryAdd(const T &item);
+
+  bool tryAdd(T &&item);
+
+  void waitAdd(const T &item);
+
+  void waitAdd(T &&item);
+
+  bool tryAdd(ProducerToken &token, const T &item);
+
+  bool tryAdd(ProducerToken &token, T &&item);
+
+  void waitAdd(ProducerToken &token, const T &item);
+
+  void waitAdd(ProducerToken &token, T &&item);
+
+  // The bulk additions publish the items read from first once per
+  // segment, and return their number. Items taken back because the
+  // container was closed meanwhile are moved back into a std::move_iterator
+  // input over a forward range, and lost with a single pass input.
+  template <typename InputIt>
+  size_type tryAddBulk(InputIt first, size_type count);
+
+  template <typename InputIt>
+  size_type tryAddBulk(ProducerToken &token, InputIt first, size_type count);
+
+  bool tryRemove(T &item);
+
+  void waitRemove(T &item);
+
+  bool tryRemove(ConsumerToken &token, T &item);
+
+  void waitRemove(ConsumerToken &token, T &item);
+
+  // The bulk removals move up to maxItems items of a single producer to
+  // out and return their number.
+  template <typename OutputIt>
+  size_type tryRemoveBulk(OutputIt out, size_type maxItems);
+
+  template <typename OutputIt>
+  size_type waitRemoveBulk(OutputIt out, size_type maxItems);
+
+  template <typename OutputIt>
+  size_type tryRemoveBulk(ConsumerToken &token, OutputIt out,
+                          size_type maxItems);
+
+  template <typename OutputIt>
+  size_type waitRemoveBulk(ConsumerToken &token, OutputIt out,
+                           size_type maxItems);
+
+  void shutdown();
+
+  void close();
+
+  void clear();
+
+  // The size and empty methods add up the sub-queues, and are only exact
+  // while the queue is not being modified.
+  size_type size() const;
+
+  bool empty() const;
+};
+}  // namespace TSC
+
+#include "SegmentedContainerPrivate.hpp"
@@ -0,0 +1,606 @@
+#pragma once
+
+namespace TSC {
+template <typename T>
+constexpr typename SegmentedContainer<T>::size_type
+    SegmentedContainer<T>::DEFAULT_SEGMENT_SIZE;
+
+template <typename T>
+constexpr typename SegmentedContainer<T>::size_type
+    SegmentedContainer<T>::QUOTA;
+
+template <typename T>
+SegmentedContainer<T>::Segment::Segment(size_type capacity, size_type base)
+    : base{base}, capacity{capacity}, items{new Storage[capacity]} {}
+
+template <typename T>
+SegmentedContainer<T>::Segment::~Segment() {
+  size_type last = tail.load(std::memory_order_acquire);
+
+  for (size_type i = head.load(std::memory_order_acquire); i < last; ++i) {
+    slot(i)->~T();
+  }
+}
+
+template <typename T>
+SegmentedContainer<T>::SubQueue::SubQueue(size_type segmentSize) {
+  Segment *segment = new Segment{segmentSize, 0u};
+  this->headSegment.store(segment, std::memory_order_relaxed);
+  this->tailSegment.store(segment, std::memory_order_relaxed);
+}
+
+template <typename T>
+SegmentedContainer<T>::SubQueue::~SubQueue() {
+  Segment *segment = this->headSegment.load(std::memory_order_acquire);
+
+  while (segment != nullptr) {
+    Segment *next = segment->next.load(std::memory_order_acquire);
+    delete segment;
+    segment = next;
+  }
+}
+
+template <typename T>
+SegmentedContainer<T>::SubQueueList::~SubQueueList() {
+  SubQueueFields *subQueue = head.load(std::memory_order_acquire);
+
+  while (subQueue != nullptr) {
+    SubQueueFields *next = subQueue->next;
+    delete static_cast<SubQueue *>(subQueue);
+    subQueue = next;
+  }
+}
+
+// A thread releases its implicit producers when it exits, unless their
+// container is already gone.
+template <typename T>
+SegmentedContainer<T>::ImplicitTable::~ImplicitTable() {
+  for (auto &entry : entries) {
+    auto subQueues = entry.subQueues.lock();
+    if (subQueues && entry.producer != nullptr) {
+      entry.producer->owned.store(false, std::memory_order_release);
+    }
+  }
+}
+
+template <typename T>
+SegmentedContainer<T>::SegmentedContainer(size_type segmentSize)
+    : segmentSize{segmentSize > 0u ? segmentSize : 1u},
+      id{nextId()},
+      subQueues{std::make_shared<SubQueueList>()} {}
+
+// Segments retired by consumers are deleted along with the list of
+// retired segments, and the sub-queues along with the last reference to
+// their list.
+template <typename T>
+SegmentedContainer<T>::~SegmentedContainer() = default;
+
+template <typename T>
+std::uint64_t SegmentedContainer<T>::nextId() {
+  static std::atomic<std::uint64_t> next{0u};
+
+  return next.fetch_add(1u, std::memory_order_relaxed);
+}
+
+// Entries of containers that no longer exist are dropped when the thread
+// meets a new container.
+template <typename T>
+typename SegmentedContainer<T>::Implicit &SegmentedContainer<T>::implicit() {
+  static thread_local ImplicitTable table;
+
+  for (auto &entry : table.entries) {
+    if (entry.id == id) {
+      return entry;
+    }
+  }
+  table.entries.erase(
+      std::remove_if(table.entries.begin(), table.entries.end(),
+                     [](const Implicit &entry) {
+                       return entry.subQueues.expired();
+                     }),
+      table.entries.end());
+  table.entries.push_back(Implicit{id, subQueues, nullptr, ConsumerToken{}});
+  return table.entries.back();
+}
+
+template <typename T>
+bool SegmentedContainer<T>::refused() const {
+  return !inUse.load() || closed.load();
+}
+
+template <typename T>
+typename SegmentedContainer<T>::SubQueue *SegmentedContainer<T>::acquire() {
+  for (auto *subQueue = subQueues->head.load(std::memory_order_acquire);
+       subQueue != nullptr; subQueue = subQueue->next) {
+    if (!subQueue->owned.load(std::memory_order_relaxed) &&
+        !subQueue->owned.exchange(true, std::memory_order_acquire)) {
+      return static_cast<SubQueue *>(subQueue);
+    }
+  }
+
+  auto *subQueue = new SubQueue{segmentSize};
+  SubQueueFields *head = subQueues->head.load(std::memory_order_relaxed);
+  do {
+    subQueue->next = head;
+  } while (!subQueues->head.compare_exchange_weak(head, subQueue));
+  return subQueue;
+}
+
+template <typename T>
+typename SegmentedContainer<T>::SubQueue &SegmentedContainer<T>::producer() {
+  Implicit &entry = implicit();
+
+  if (entry.producer == nullptr) {
+    entry.producer = acquire();
+  }
+  return *entry.producer;
+}
+
+// The tail segment moves before the new segment is linked, as consumers
+// only retire a segment once it has a successor.
+template <typename T>
+typename SegmentedContainer<T>::Segment &SegmentedContainer<T>::extend(
+    SubQueue &subQueue, Segment &segment) {
+  auto *fresh = new Segment{segmentSize, segment.base + segment.capacity};
+
+  subQueue.tailSegment.store(fresh, std::memory_order_release);
+  segment.next.store(fresh);
+  return *fresh;
+}
+
+// Claims are runs starting at the head, so that items behind earlier
+// unclaimed ones are left, as a consumer will see them while taking the
+// earlier ones.
+template <typename T>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::reclaim(
+    Segment &segment, size_type first, size_type last) {
+  size_type head = segment.head.load();
+
+  while (head >= first && head < last) {
+    if (segment.head.compare_exchange_weak(head, last)) {
+      return head;
+    }
+  }
+  return last;
+}
+
+template <typename T>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::retract(
+    Segment &segment, size_type first, size_type last) {
+  size_type head = reclaim(segment, first, last);
+
+  for (size_type i{head}; i < last; ++i) {
+    segment.slot(i)->~T();
+  }
+  return last - head;
+}
+
+template <typename T>
+template <typename InputIt>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::retract(
+    Segment &segment, size_type first, size_type last, InputIt items) {
+  size_type head = reclaim(segment, first, last);
+
+  std::advance(items, head - first);
+  giveBack(segment, head, last, items,
+           typename std::iterator_traits<InputIt>::iterator_category{});
+  return last - head;
+}
+
+template <typename T>
+template <typename InputIt>
+void SegmentedContainer<T>::giveBack(Segment &segment, size_type first,
+                                     size_type last, InputIt items,
+                                     std::forward_iterator_tag) {
+  for (size_type i{first}; i < last; ++i, ++items) {
+    T *taken = segment.slot(i);
+    restore(*items, *taken);
+    taken->~T();
+  }
+}
+
+// A single pass input cannot be read again, and keeps nothing to restore.
+template <typename T>
+template <typename InputIt>
+void SegmentedContainer<T>::giveBack(Segment &segment, size_type first,
+                                     size_type last, InputIt,
+                                     std::input_iterator_tag) {
+  for (size_type i{first}; i < last; ++i) {
+    segment.slot(i)->~T();
+  }
+}
+
+template <typename T>
+void SegmentedContainer<T>::restore(const T &, T &) {}
+
+template <typename T>
+void SegmentedContainer<T>::restore(T &&item, T &taken) {
+  item = std::move(taken);
+}
+
+template <typename T>
+template <typename U>
+void SegmentedContainer<T>::push(SubQueue &subQueue, U &&item) {
+  if (refused()) {
+    throw ShutdownException("shutdown");
+  }
+
+  Segment *segment = subQueue.tailSegment.load(std::memory_order_relaxed);
+  size_type tail = segment->tail.load(std::memory_order_relaxed);
+  if (tail == segment->capacity) {
+    segment = &extend(subQueue, *segment);
+    tail = 0u;
+  }
+  new (segment->slot(tail)) T(std::forward<U>(item));
+  segment->tail.store(tail + 1u);
+
+  if (refused()) {
+    size_type head{tail};
+    if (segment->head.compare_exchange_strong(head, tail + 1u)) {
+      T *taken = segment->slot(tail);
+      restore(std::forward<U>(item), *taken);
+      taken->~T();
+      throw ShutdownException("shutdown");
+    }
+  }
+  wake();
+}
+
+template <typename T>
+template <typename InputIt>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::pushBulk(
+    SubQueue &subQueue, InputIt first, size_type count) {
+  if (refused()) {
+    throw ShutdownException("shutdown");
+  }
+
+  size_type added{};
+  while (added < count) {
+    Segment *segment = subQueue.tailSegment.load(std::memory_order_relaxed);
+    size_type tail = segment->tail.load(std::memory_order_relaxed);
+    if (tail == segment->capacity) {
+      segment = &extend(subQueue, *segment);
+      tail = 0u;
+    }
+
+    size_type last = tail + std::min(count - added, segment->capacity - tail);
+    size_type position{tail};
+    InputIt run{first};
+    try {
+      for (; position < last; ++position, ++first) {
+        new (segment->slot(position)) T(*first);
+      }
+    } catch (...) {
+      segment->tail.store(position);
+      if (added > 0u || position > tail) {
+        wake();
+      }
+      throw;
+    }
+    segment->tail.store(last);
+
+    if (refused()) {
+      added += last - tail - retract(*segment, tail, last, run);
+      if (added == 0u) {
+        throw ShutdownException("shutdown");
+      }
+      break;
+    }
+    added += last - tail;
+  }
+  wake();
+  return added;
+}
+
+// Segments are retired by the consumer unlinking them, once drained and
+// followed by another one.
+template <typename T>
+template <typename OutputIt>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::take(
+    SubQueue &subQueue, OutputIt &out, size_type maxItems) {
+  detail::HazardGuard guard;
+
+  for (;;) {
+    Segment *segment = guard.protect(subQueue.headSegment);
+    size_type head = segment->head.load(std::memory_order_relaxed);
+    size_type tail = segment->tail.load();
+
+    while (head < tail) {
+      size_type last = head + std::min(maxItems, tail - head);
+      if (segment->head.compare_exchange_weak(head, last,
+                                              std::memory_order_relaxed)) {
+        size_type position{head};
+        try {
+          for (; position < last; ++position) {
+            T *item = segment->slot(position);
+            *out = std::move(*item);
+            ++out;
+            item->~T();
+          }
+        } catch (...) {
+          for (; position < last; ++position) {
+            segment->slot(position)->~T();
+          }
+          throw;
+        }
+        return last - head;
+      }
+    }
+
+    Segment *next = segment->next.load();
+    if (head < segment->capacity || next == nullptr) {
+      return 0u;
+    }
+    Segment *expected{segment};
+    if (subQueue.headSegment.compare_exchange_strong(expected, next)) {
+      guard.reset();
+      retired.retire(segment);
+    }
+  }
+}
+
+// The closed flag is read before looking for items, so that a producer
+// adding some concurrently either is seen, or sees the flag.
+template <typename T>
+template <typename OutputIt>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::removeBulk(
+    ConsumerToken &token, OutputIt out, size_type maxItems) {
+  if (!inUse.load()) {
+    throw ShutdownException("shutdown");
+  }
+
+  bool wasClosed = closed.load();
+  auto *first = static_cast<SubQueue *>(subQueues->head.load());
+  if (first != nullptr && maxItems > 0u) {
+    SubQueue *start = token.current != nullptr ? token.current : first;
+    SubQueue *subQueue{start};
+    do {
+      size_type taken = take(*subQueue, out, maxItems);
+      SubQueue *next = subQueue->next != nullptr
+                           ? static_cast<SubQueue *>(subQueue->next)
+                           : static_cast<SubQueue *>(subQueues->head.load());
+      if (taken > 0u) {
+        token.taken += taken;
+        token.current = subQueue;
+        if (token.taken >= QUOTA) {
+          token.current = next;
+          token.taken = 0u;
+        }
+        return taken;
+      }
+      subQueue = next;
+      token.taken = 0u;
+    } while (subQueue != start);
+  }
+
+  if (wasClosed) {
+    throw ShutdownException("shutdown");
+  }
+  return 0u;
+}
+
+// A sleeper sets the flag before retrying, and producers read it after
+// publishing, so that either the producer sees the flag or the retry sees
+// the items.
+template <typename T>
+template <typename OutputIt>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::waitBulk(
+    ConsumerToken &token, OutputIt out, size_type maxItems) {
+  for (;;) {
+    size_type taken = removeBulk(token, out, maxItems);
+    if (taken > 0u) {
+      return taken;
+    }
+    std::uint64_t seen = readersWait.fetch_or(1u);
+    taken = removeBulk(token, out, maxItems);
+    if (taken > 0u) {
+      return taken;
+    }
+
+    std::unique_lock<std::mutex> lock{sleepMtx};
+    notEmpty.wait(lock, [this, seen] {
+      return readersWait.load() / 2u != seen / 2u;
+    });
+  }
+}
+
+// Only the first producer after a sleeper set the flag takes the mutex,
+// and moves to the next epoch, which wakes every sleeper up.
+template <typename T>
+void SegmentedContainer<T>::wake() {
+  if ((readersWait.load() & 1u) == 0u) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock{sleepMtx};
+  std::uint64_t current = readersWait.load(std::memory_order_relaxed);
+  if ((current & 1u) != 0u) {
+    readersWait.store(current + 1u);
+    notEmpty.notify_all();
+  }
+}
+
+template <typename T>
+bool SegmentedContainer<T>::tryAdd(const T &item) {
+  push(producer(), item);
+  return true;
+}
+
+// The item is only moved from if tryAdd succeeds.
+template <typename T>
+bool SegmentedContainer<T>::tryAdd(T &&item) {
+  push(producer(), std::move(item));
+  return true;
+}
+
+template <typename T>
+void SegmentedContainer<T>::waitAdd(const T &item) {
+  push(producer(), item);
+}
+
+template <typename T>
+void SegmentedContainer<T>::waitAdd(T &&item) {
+  push(producer(), std::move(item));
+}
+
+template <typename T>
+bool SegmentedContainer<T>::tryAdd(ProducerToken &token, const T &item) {
+  push(*token.subQueue, item);
+  return true;
+}
+
+template <typename T>
+bool SegmentedContainer<T>::tryAdd(ProducerToken &token, T &&item) {
+  push(*token.subQueue, std::move(item));
+  return true;
+}
+
+template <typename T>
+void SegmentedContainer<T>::waitAdd(ProducerToken &token, const T &item) {
+  push(*token.subQueue, item);
+}
+
+template <typename T>
+void SegmentedContainer<T>::waitAdd(ProducerToken &token, T &&item) {
+  push(*token.subQueue, std::move(item));
+}
+
+template <typename T>
+template <typename InputIt>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::tryAddBulk(
+    InputIt first, size_type count) {
+  return pushBulk(producer(), first, count);
+}
+
+template <typename T>
+template <typename InputIt>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::tryAddBulk(
+    ProducerToken &token, InputIt first, size_type count) {
+  return pushBulk(*token.subQueue, first, count);
+}
+
+template <typename T>
+bool SegmentedContainer<T>::tryRemove(T &item) {
+  return removeBulk(implicit().consumer, &item, 1u) == 1u;
+}
+
+template <typename T>
+void SegmentedContainer<T>::waitRemove(T &item) {
+  waitBulk(implicit().consumer, &item, 1u);
+}
+
+template <typename T>
+bool SegmentedContainer<T>::tryRemove(ConsumerToken &token, T &item) {
+  return removeBulk(token, &item, 1u) == 1u;
+}
+
+template <typename T>
+void SegmentedContainer<T>::waitRemove(ConsumerToken &token, T &item) {
+  waitBulk(token, &item, 1u);
+}
+
+template <typename T>
+template <typename OutputIt>
+typename SegmentedContainer<T>::size_type
+SegmentedContainer<T>::tryRemoveBulk(OutputIt out, size_type maxItems) {
+  return removeBulk(implicit().consumer, out, maxItems);
+}
+
+// The waitRemoveBulk method waits until at least one item is available.
+template <typename T>
+template <typename OutputIt>
+typename SegmentedContainer<T>::size_type
+SegmentedContainer<T>::waitRemoveBulk(OutputIt out, size_type maxItems) {
+  return waitBulk(implicit().consumer, out, maxItems);
+}
+
+template <typename T>
+template <typename OutputIt>
+typename SegmentedContainer<T>::size_type
+SegmentedContainer<T>::tryRemoveBulk(ConsumerToken &token, OutputIt out,
+                                     size_type maxItems) {
+  return removeBulk(token, out, maxItems);
+}
+
+template <typename T>
+template <typename OutputIt>
+typename SegmentedContainer<T>::size_type
+SegmentedContainer<T>::waitRemoveBulk(ConsumerToken &token, OutputIt out,
+                                      size_type maxItems) {
+  return waitBulk(token, out, maxItems);
+}
+
+template <typename T>
+void SegmentedContainer<T>::shutdown() {
+  inUse.store(false);
+
+  std::lock_guard<std::mutex> lock{sleepMtx};
+  readersWait.fetch_add(2u);
+  notEmpty.notify_all();
+}
+
+// After close, additions fail while removals drain the queue.
+template <typename T>
+void SegmentedContainer<T>::close() {
+  closed.store(true);
+
+  std::lock_guard<std::mutex> lock{sleepMtx};
+  readersWait.fetch_add(2u);
+  notEmpty.notify_all();
+}
+
+// The clear method removes any elements present within the queue. This
+// method will do nothing when called while the queue is still in use.
+template <typename T>
+void SegmentedContainer<T>::clear() {
+  if (inUse.load()) {
+    return;
+  }
+
+  for (auto *subQueue = subQueues->head.load(); subQueue != nullptr;
+       subQueue = subQueue->next) {
+    auto &queue = *static_cast<SubQueue *>(subQueue);
+    detail::HazardGuard guard;
+    for (;;) {
+      Segment *segment = guard.protect(queue.headSegment);
+      size_type head = segment->head.load();
+      size_type tail = segment->tail.load();
+      if (head < tail) {
+        retract(*segment, head, tail);
+        continue;
+      }
+      Segment *next = segment->next.load();
+      if (next == nullptr) {
+        break;
+      }
+      Segment *expected{segment};
+      if (queue.headSegment.compare_exchange_strong(expected, next)) {
+        guard.reset();
+        retired.retire(segment);
+      }
+    }
+  }
+}
+
+template <typename T>
+typename SegmentedContainer<T>::size_type SegmentedContainer<T>::size()
+    const {
+  size_type total{};
+
+  for (auto *subQueue = subQueues->head.load(); subQueue != nullptr;
+       subQueue = subQueue->next) {
+    detail::HazardGuard first, last;
+    Segment *head = first.protect(subQueue->headSegment);
+    Segment *tail = last.protect(subQueue->tailSegment);
+    size_type begin = head->base + head->head.load();
+    size_type end = tail->base + tail->tail.load();
+    total += end > begin ? end - begin : 0u;
+  }
+  return total;
+}
+
+template <typename T>
+bool SegmentedContainer<T>::empty() const {
+  return size() == 0u;
+}
+}  // namespace TSC
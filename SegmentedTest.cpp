@@ -0,0 +1,315 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "SegmentedContainer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{4u};
+constexpr size_t NB_READER_THREADS{4u};
+constexpr size_t NB_MESSAGES{5000u};
+
+using Queue = TSC::SegmentedContainer<size_t>;
+
+void sequential() {
+  Queue mtq{4u};
+  size_t item;
+
+  assert(mtq.empty() && !mtq.tryRemove(item));
+  for (size_t n{}; n < 1000u; ++n) {
+    assert(mtq.tryAdd(n));
+  }
+  assert(mtq.size() == 1000u);
+  for (size_t n{}; n < 1000u; ++n) {
+    assert(mtq.tryRemove(item) && item == n);
+  }
+  assert(!mtq.tryRemove(item) && mtq.empty());
+
+  // Each producer keeps its own order, whatever the rotation.
+  Queue::ConsumerToken consumer;
+  {
+    Queue::ProducerToken first{mtq}, second{mtq};
+    for (size_t n{1u}; n <= 10u; ++n) {
+      mtq.waitAdd(first, n * 2u);
+      mtq.waitAdd(second, n * 2u + 1u);
+    }
+  }
+  std::vector<size_t> last(2u, 0u);
+  for (size_t n{}; n < 20u; ++n) {
+    assert(mtq.tryRemove(consumer, item));
+    assert(item / 2u > last[item % 2u]);
+    last[item % 2u] = item / 2u;
+  }
+  assert(!mtq.tryRemove(consumer, item));
+
+  TSC::SegmentedContainer<std::unique_ptr<int>> pointers{};
+  std::unique_ptr<int> pointer{new int{1}};
+  assert(pointers.tryAdd(std::move(pointer)) && !pointer);
+  pointers.waitRemove(pointer);
+  assert(pointer && *pointer == 1);
+  pointers.close();
+  pointer.reset(new int{2});
+  bool failed{false};
+  try {
+    pointers.tryAdd(std::move(pointer));
+  } catch (const TSC::ShutdownException &e) {
+    failed = true;
+  }
+  assert(failed && pointer && *pointer == 2);
+}
+
+// Bulk removals stop at the end of a segment, and take items of a single
+// producer.
+void bulk() {
+  Queue mtq{8u};
+  Queue::ProducerToken token{mtq};
+  std::vector<size_t> items(20u), out;
+
+  for (size_t n{}; n < items.size(); ++n) {
+    items[n] = n;
+  }
+  assert(mtq.tryAddBulk(token, items.begin(), items.size()) == 20u);
+  assert(mtq.tryAddBulk(items.begin(), 5u) == 5u);
+  assert(mtq.size() == 25u);
+
+  Queue::ConsumerToken consumer;
+  while (out.size() < 25u) {
+    size_t taken = mtq.tryRemoveBulk(consumer, std::back_inserter(out), 6u);
+    assert(taken > 0u && taken <= 6u);
+  }
+  assert(mtq.tryRemoveBulk(std::back_inserter(out), 6u) == 0u);
+
+  size_t sum{};
+  for (auto value : out) {
+    sum += value;
+  }
+  assert(sum == 190u + 10u && mtq.empty());
+}
+
+// An item that closes its target container when moved in with a value of
+// 2, and whose copy throws when its value is negative.
+struct Probe {
+  static TSC::SegmentedContainer<Probe> *target;
+  std::unique_ptr<int> value;
+
+  Probe() = default;
+
+  explicit Probe(int value) : value{new int{value}} {}
+
+  Probe(Probe &&src) : value{std::move(src.value)} {
+    if (target != nullptr && value && *value == 2) {
+      target->close();
+    }
+  }
+
+  Probe(const Probe &src) : value{new int{*src.value}} {
+    if (*value < 0) {
+      throw std::runtime_error("copy");
+    }
+  }
+
+  Probe &operator=(Probe &&rhs) = default;
+};
+
+TSC::SegmentedContainer<Probe> *Probe::target{nullptr};
+
+// Items taken back on close are moved back into a std::move_iterator
+// input, and the items published before a throwing copy wake a reader up.
+void bulkFailures() {
+  {
+    TSC::SegmentedContainer<Probe> mtq{8u};
+    std::vector<Probe> items;
+    for (int n{1}; n <= 3; ++n) {
+      items.emplace_back(n);
+    }
+    Probe::target = &mtq;
+    bool failed{false};
+    try {
+      mtq.tryAddBulk(std::make_move_iterator(items.begin()), items.size());
+    } catch (const TSC::ShutdownException &e) {
+      failed = true;
+    }
+    Probe::target = nullptr;
+    assert(failed && mtq.empty());
+    for (int n{1}; n <= 3; ++n) {
+      assert(items[n - 1].value && *items[n - 1].value == n);
+    }
+  }
+  {
+    TSC::SegmentedContainer<Probe> mtq{8u};
+    std::vector<Probe> items;
+    items.emplace_back(1);
+    items.emplace_back(-1);
+    std::thread reader{[&mtq] {
+      Probe item;
+      mtq.waitRemove(item);
+      assert(*item.value == 1);
+    }};
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    bool failed{false};
+    try {
+      mtq.tryAddBulk(items.begin(), items.size());
+    } catch (const std::runtime_error &e) {
+      failed = true;
+    }
+    assert(failed);
+    reader.join();
+  }
+}
+
+// Items left in the segments are destroyed with them, or by clear after a
+// shutdown, and sub-queues released by their tokens are reused.
+void lifetime() {
+  auto tracked = std::make_shared<int>(0);
+  {
+    TSC::SegmentedContainer<std::shared_ptr<int>> mtq{2u};
+    for (int n{}; n < 7; ++n) {
+      mtq.waitAdd(tracked);
+    }
+    {
+      TSC::SegmentedContainer<std::shared_ptr<int>>::ProducerToken token{mtq};
+      mtq.waitAdd(token, tracked);
+    }
+    assert(tracked.use_count() == 9 && mtq.size() == 8u);
+    mtq.clear();
+    assert(tracked.use_count() == 9);
+    mtq.shutdown();
+    mtq.clear();
+    assert(tracked.use_count() == 1 && mtq.empty());
+  }
+  {
+    TSC::SegmentedContainer<std::shared_ptr<int>> mtq{2u};
+    std::shared_ptr<int> item;
+    std::thread writer{[&mtq, &tracked] {
+      for (int n{}; n < 5; ++n) {
+        mtq.waitAdd(tracked);
+      }
+    }};
+    writer.join();
+    mtq.waitRemove(item);
+    item.reset();
+    assert(tracked.use_count() == 5);
+  }
+  assert(tracked.use_count() == 1);
+}
+
+void closeAndShutdown() {
+  Queue mtq{};
+  size_t item;
+
+  mtq.waitAdd(1u);
+  mtq.close();
+  bool failed{false};
+  try {
+    mtq.waitAdd(2u);
+  } catch (const TSC::ShutdownException &e) {
+    failed = true;
+  }
+  assert(failed);
+  mtq.waitRemove(item);
+  assert(item == 1u);
+  failed = false;
+  try {
+    mtq.waitRemove(item);
+  } catch (const TSC::ShutdownException &e) {
+    failed = true;
+  }
+  assert(failed);
+
+  Queue open{};
+  std::thread reader{[&open] {
+    size_t item;
+    bool failed{false};
+    try {
+      open.waitRemove(item);
+    } catch (const TSC::ShutdownException &e) {
+      failed = true;
+    }
+    assert(failed);
+    (void)failed;
+  }};
+  open.shutdown();
+  reader.join();
+}
+
+// Each writer sends increasing numbers tagged with its index, so that the
+// readers check the order of each writer along with the total. Half of
+// the writers and readers use tokens.
+void concurrent(size_t segmentSize) {
+  Queue mtq{segmentSize};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> sums(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq, w] {
+      if (w % 2u == 0u) {
+        Queue::ProducerToken token{mtq};
+        for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+          mtq.waitAdd(token, n * NB_WRITER_THREADS + w);
+        }
+      } else {
+        for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+          mtq.waitAdd(n * NB_WRITER_THREADS + w);
+        }
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &sums, r] {
+      std::vector<size_t> last(NB_WRITER_THREADS, 0u);
+      Queue::ConsumerToken token;
+      size_t items[4];
+      try {
+        for (;;) {
+          size_t taken{1u};
+          if (r % 2u == 0u) {
+            taken = mtq.waitRemoveBulk(token, items, 4u);
+          } else {
+            mtq.waitRemove(items[0]);
+          }
+          for (size_t i{}; i < taken; ++i) {
+            size_t writer = items[i] % NB_WRITER_THREADS;
+            assert(items[i] / NB_WRITER_THREADS > last[writer]);
+            last[writer] = items[i] / NB_WRITER_THREADS;
+            sums[r] += items[i] / NB_WRITER_THREADS;
+          }
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  size_t total{};
+  for (auto sum : sums) {
+    total += sum;
+  }
+  assert(total == NB_WRITER_THREADS * NB_MESSAGES * (NB_MESSAGES + 1u) / 2u);
+  assert(mtq.empty());
+}
+
+int main() {
+  sequential();
+  bulk();
+  bulkFailures();
+  lifetime();
+  closeAndShutdown();
+  concurrent(1u);
+  concurrent(16u);
+  concurrent(Queue::DEFAULT_SEGMENT_SIZE);
+
+  std::cout << "segmented passed" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define TSC_SIMD_X86 1
+#endif
+
+namespace TSC {
+// Copy kernels for the bulk transfers of trivially copyable items. The
+// widest kernel the CPU supports, which is checked with cpuid, is chosen
+// on first use, and select overrides it; the scalar kernel is plain
+// memcpy. The SSE2 and AVX2 kernels use non-temporal stores for copies of
+// at least STREAM_THRESHOLD bytes, which bypass the cache instead of
+// evicting the working set of the copying thread.
+namespace Simd {
+enum class Kernel { Scalar, Sse2, Avx2 };
+
+constexpr std::size_t STREAM_THRESHOLD{std::size_t{1u} << 20};
+
+using CopyFunction = void (*)(void *dst, const void *src, std::size_t bytes);
+
+inline const char *name(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Sse2:
+      return "sse2";
+    case Kernel::Avx2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+
+namespace detail {
+inline void copyScalar(void *dst, const void *src, std::size_t bytes) {
+  std::memcpy(dst, src, bytes);
+}
+
+#ifdef TSC_SIMD_X86
+__attribute__((target("sse2"))) inline void copySse2(void *dst,
+                                                     const void *src,
+                                                     std::size_t bytes) {
+  auto out = static_cast<char *>(dst);
+  auto in = static_cast<const char *>(src);
+
+  if (bytes >= STREAM_THRESHOLD) {
+    // Aligns the destination for the streaming stores, the
+    // first vector being stored unaligned.
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(in)));
+    std::size_t skew =
+        16u - (reinterpret_cast<std::uintptr_t>(out) & 15u);
+    out += skew;
+    in += skew;
+    bytes -= skew;
+    for (; bytes >= 64u; bytes -= 64u, out += 64, in += 64) {
+      auto source = reinterpret_cast<const __m128i *>(in);
+      auto target = reinterpret_cast<__m128i *>(out);
+      __m128i a = _mm_loadu_si128(source);
+      __m128i b = _mm_loadu_si128(source + 1);
+      __m128i c = _mm_loadu_si128(source + 2);
+      __m128i d = _mm_loadu_si128(source + 3);
+      _mm_stream_si128(target, a);
+      _mm_stream_si128(target + 1, b);
+      _mm_stream_si128(target + 2, c);
+      _mm_stream_si128(target + 3, d);
+    }
+    _mm_sfence();
+  } else {
+    for (; bytes >= 64u; bytes -= 64u, out += 64, in += 64) {
+      auto source = reinterpret_cast<const __m128i *>(in);
+      auto target = reinterpret_cast<__m128i *>(out);
+      __m128i a = _mm_loadu_si128(source);
+      __m128i b = _mm_loadu_si128(source + 1);
+      __m128i c = _mm_loadu_si128(source + 2);
+      __m128i d = _mm_loadu_si128(source + 3);
+      _mm_storeu_si128(target, a);
+      _mm_storeu_si128(target + 1, b);
+      _mm_storeu_si128(target + 2, c);
+      _mm_storeu_si128(target + 3, d);
+    }
+  }
+  for (; bytes >= 16u; bytes -= 16u, out += 16, in += 16) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(in)));
+  }
+  std::memcpy(out, in, bytes);
+}
+
+__attribute__((target("avx2"))) inline void copyAvx2(void *dst,
+                                                     const void *src,
+                                                     std::size_t bytes) {
+  auto out = static_cast<char *>(dst);
+  auto in = static_cast<const char *>(src);
+
+  if (bytes >= STREAM_THRESHOLD) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(out),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in)));
+    std::size_t skew =
+        32u - (reinterpret_cast<std::uintptr_t>(out) & 31u);
+    out += skew;
+    in += skew;
+    bytes -= skew;
+    for (; bytes >= 128u; bytes -= 128u, out += 128, in += 128) {
+      auto source = reinterpret_cast<const __m256i *>(in);
+      auto target = reinterpret_cast<__m256i *>(out);
+      __m256i a = _mm256_loadu_si256(source);
+      __m256i b = _mm256_loadu_si256(source + 1);
+      __m256i c = _mm256_loadu_si256(source + 2);
+      __m256i d = _mm256_loadu_si256(source + 3);
+      _mm256_stream_si256(target, a);
+      _mm256_stream_si256(target + 1, b);
+      _mm256_stream_si256(target + 2, c);
+      _mm256_stream_si256(target + 3, d);
+    }
+    _mm_sfence();
+  } else {
+    for (; bytes >= 128u; bytes -= 128u, out += 128, in += 128) {
+      auto source = reinterpret_cast<const __m256i *>(in);
+      auto target = reinterpret_cast<__m256i *>(out);
+      __m256i a = _mm256_loadu_si256(source);
+      __m256i b = _mm256_loadu_si256(source + 1);
+      __m256i c = _mm256_loadu_si256(source + 2);
+      __m256i d = _mm256_loadu_si256(source + 3);
+      _mm256_storeu_si256(target, a);
+      _mm256_storeu_si256(target + 1, b);
+      _mm256_storeu_si256(target + 2, c);
+      _mm256_storeu_si256(target + 3, d);
+    }
+  }
+  for (; bytes >= 32u; bytes -= 32u, out += 32, in += 32) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(out),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in)));
+  }
+  std::memcpy(out, in, bytes);
+}
+#endif
+
+inline CopyFunction function(Kernel kernel) {
+#ifdef TSC_SIMD_X86
+  switch (kernel) {
+    case Kernel::Sse2:
+      return copySse2;
+    case Kernel::Avx2:
+      return copyAvx2;
+    default:
+      break;
+  }
+#endif
+  (void)kernel;
+  return copyScalar;
+}
+
+inline std::atomic<CopyFunction> &selected();
+}  // namespace detail
+
+inline bool supported(Kernel kernel) {
+#ifdef TSC_SIMD_X86
+  __builtin_cpu_init();
+  switch (kernel) {
+    case Kernel::Sse2:
+      return __builtin_cpu_supports("sse2");
+    case Kernel::Avx2:
+      return __builtin_cpu_supports("avx2");
+    default:
+      return true;
+  }
+#else
+  return kernel == Kernel::Scalar;
+#endif
+}
+
+// The widest kernel supported by the CPU.
+inline Kernel best() {
+  if (supported(Kernel::Avx2)) {
+    return Kernel::Avx2;
+  }
+  return supported(Kernel::Sse2) ? Kernel::Sse2 : Kernel::Scalar;
+}
+
+// The kernel used unless another one is selected, detected once.
+inline Kernel defaultKernel() {
+  static const Kernel kernel{best()};
+  return kernel;
+}
+
+inline std::atomic<CopyFunction> &detail::selected() {
+  static std::atomic<CopyFunction> copy{function(defaultKernel())};
+  return copy;
+}
+
+// The current method returns true if the kernel is the one in use.
+inline bool current(Kernel kernel) {
+  return detail::selected().load(std::memory_order_relaxed) ==
+         detail::function(kernel);
+}
+
+// The select method changes the kernel used by every bulk transfer. It
+// returns false if the CPU does not support the kernel.
+inline bool select(Kernel kernel) {
+  if (!supported(kernel)) {
+    return false;
+  }
+  detail::selected().store(detail::function(kernel),
+                           std::memory_order_relaxed);
+  return true;
+}
+
+// Copies below a cache line are left to the inlined memcpy of the compiler.
+inline void copy(void *dst, const void *src, std::size_t bytes) {
+  if (bytes < 64u) {
+    std::memcpy(dst, src, bytes);
+  } else {
+    detail::selected().load(std::memory_order_relaxed)(dst, src, bytes);
+  }
+}
+}  // namespace Simd
+}  // namespace TSC
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#ifdef __cpp_lib_jthread
+#include <stop_token>
+#endif
+
+namespace TSC {
+template <typename Callback>
+class StopCallback;
+
+namespace detail {
+struct StopCallbackBase {
+  StopCallbackBase *prev{nullptr};
+  StopCallbackBase *next{nullptr};
+
+  virtual void invoke() = 0;
+
+ protected:
+  ~StopCallbackBase() = default;
+};
+
+// The StopState is shared by a StopSource and its tokens. Registered
+// callbacks form an intrusive list guarded by the mutex, and run outside
+// of it. A callback being destroyed while it runs on another thread waits
+// for it to return, as std::stop_callback does.
+struct StopState {
+  std::mutex mtx;
+  std::condition_variable finished;
+  std::atomic<bool> stopped{false};
+  StopCallbackBase *callbacks{nullptr};
+  StopCallbackBase *running{nullptr};
+  std::thread::id runner;
+
+  bool requestStop();
+
+  // The attach method returns false if the stop was already requested,
+  // in which case the callback is not registered.
+  bool attach(StopCallbackBase *callback);
+
+  void detach(StopCallbackBase *callback);
+};
+
+inline bool StopState::requestStop() {
+  std::unique_lock<std::mutex> lock{mtx};
+
+  if (stopped.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  stopped.store(true, std::memory_order_release);
+  runner = std::this_thread::get_id();
+  while (callbacks != nullptr) {
+    running = callbacks;
+    callbacks = running->next;
+    if (callbacks != nullptr) {
+      callbacks->prev = nullptr;
+    }
+    lock.unlock();
+    running->invoke();
+    lock.lock();
+    running = nullptr;
+    finished.notify_all();
+  }
+  return true;
+}
+
+inline bool StopState::attach(StopCallbackBase *callback) {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  if (stopped.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  callback->next = callbacks;
+  if (callbacks != nullptr) {
+    callbacks->prev = callback;
+  }
+  callbacks = callback;
+  return true;
+}
+
+inline void StopState::detach(StopCallbackBase *callback) {
+  std::unique_lock<std::mutex> lock{mtx};
+
+  if (running == callback) {
+    // A callback destroying itself while it runs must not wait.
+    if (runner != std::this_thread::get_id()) {
+      finished.wait(lock, [this, callback] { return running != callback; });
+    }
+    return;
+  }
+  if (callback->prev != nullptr) {
+    callback->prev->next = callback->next;
+  } else if (callbacks == callback) {
+    callbacks = callback->next;
+  } else {
+    // The callback already ran.
+    return;
+  }
+  if (callback->next != nullptr) {
+    callback->next->prev = callback->prev;
+  }
+}
+}  // namespace detail
+
+// The StopSource, StopToken and StopCallback classes are a shim with the
+// interface of std::stop_source, std::stop_token and std::stop_callback,
+// for the cancellable waits of C++14 and C++17 code.
+class StopToken {
+ private:
+  std::shared_ptr<detail::StopState> state;
+
+  friend class StopSource;
+
+  template <typename Callback>
+  friend class StopCallback;
+
+  explicit StopToken(std::shared_ptr<detail::StopState> state)
+      : state{std::move(state)} {}
+
+ public:
+  StopToken() = default;
+
+  bool stop_requested() const noexcept {
+    return state && state->stopped.load(std::memory_order_acquire);
+  }
+
+  bool stop_possible() const noexcept { return static_cast<bool>(state); }
+};
+
+class StopSource {
+ private:
+  std::shared_ptr<detail::StopState> state;
+
+ public:
+  StopSource() : state{std::make_shared<detail::StopState>()} {}
+
+  StopToken get_token() const noexcept { return StopToken{state}; }
+
+  // The request_stop method runs the registered callbacks on the calling
+  // thread, and returns false if the stop was already requested.
+  bool request_stop() { return state->requestStop(); }
+
+  bool stop_requested() const noexcept {
+    return state->stopped.load(std::memory_order_acquire);
+  }
+};
+
+// The StopCallback runs its callback once the stop of the token is
+// requested, at once if it already was.
+template <typename Callback>
+class StopCallback : private detail::StopCallbackBase {
+ private:
+  std::shared_ptr<detail::StopState> state;
+  Callback callback;
+
+  void invoke() override { callback(); }
+
+ public:
+  template <typename C>
+  StopCallback(const StopToken &token, C &&callback)
+      : state{token.state}, callback(std::forward<C>(callback)) {
+    if (state && !state->attach(this)) {
+      state.reset();
+      this->callback();
+    }
+  }
+
+  ~StopCallback() {
+    if (state) {
+      state->detach(this);
+    }
+  }
+
+  StopCallback(const StopCallback &src) = delete;
+
+  StopCallback &operator=(const StopCallback &rhs) = delete;
+};
+}  // namespace TSC
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Affinity.hpp"
+#include "FetchAddContainer.hpp"
+#include "FlatCombiningContainer.hpp"
+#include "PerfCounters.hpp"
+#include "SegmentedContainer.hpp"
+#include "ThreadSafeContainer.hpp"
+#include "TwoLockContainer.hpp"
+
+struct Config {
+  size_t producers{2u};
+  size_t consumers{2u};
+  size_t capacity{1024u};
+  size_t items{1000000u};
+  size_t runs{3u};
+  bool perf{false};
+  std::vector<TSC::Affinity::Layout> layouts{TSC::Affinity::Layout::None};
+  TSC::Affinity::Placement placement;
+};
+
+struct Result {
+  double seconds{};
+  // Set when a thread could not be pinned to the CPU of the layout.
+  bool unpinned{false};
+  TSC::PerfCounters::Sample counters;
+};
+
+// Splits the items evenly between the threads, the first threads
+// taking the remainder.
+size_t share(size_t items, size_t threads, size_t index) {
+  return items / threads + (index < items % threads ? 1u : 0u);
+}
+
+// Moves config.items integers from the producers to the consumers through
+// the queue and measures the elapsed time once every thread is ready.
+template <typename Queue>
+Result run(const Config &config) {
+  Queue queue{config.capacity};
+  std::atomic<size_t> ready{0u};
+  std::atomic<bool> go{false};
+  std::atomic<bool> unpinned{false};
+  std::vector<std::thread> threads;
+  TSC::PerfCounters counters;
+  Result result;
+
+  // Each thread pins itself before reporting ready.
+  auto wait = [&](const std::vector<int> &cpus, size_t index) {
+    if (!cpus.empty() && !TSC::Affinity::pinCurrentThread(cpus[index])) {
+      unpinned.store(true);
+    }
+    ++ready;
+    while (!go.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  };
+
+  for (size_t i{}; i < config.producers; ++i) {
+    size_t count = share(config.items, config.producers, i);
+    threads.emplace_back([&queue, &wait, &config, count, i] {
+      wait(config.placement.producers, i);
+      for (size_t n{}; n < count; ++n) {
+        queue.waitAdd(static_cast<int>(n));
+      }
+    });
+  }
+  for (size_t i{}; i < config.consumers; ++i) {
+    size_t count = share(config.items, config.consumers, i);
+    threads.emplace_back([&queue, &wait, &config, count, i] {
+      int item;
+      wait(config.placement.consumers, i);
+      for (size_t n{}; n < count; ++n) {
+        queue.waitRemove(item);
+      }
+    });
+  }
+
+  while (ready.load() != threads.size()) {
+    std::this_thread::yield();
+  }
+  // The counters were opened disabled before the threads were created, so
+  // that they follow them, and only cover the same span as the clock.
+  if (config.perf) {
+    counters.start();
+  }
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto &t : threads) {
+    t.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (config.perf) {
+    result.counters = counters.stop();
+  }
+
+  result.seconds = std::chrono::duration<double>(end - start).count();
+  result.unpinned = unpinned.load();
+  return result;
+}
+
+void report(const std::string &name, const Config &config,
+            const Result &result) {
+  double items = static_cast<double>(config.items);
+
+  std::cout << std::left << std::setw(10) << name << std::setw(10)
+            << TSC::Affinity::name(config.layouts.front()) << std::right
+            << std::setw(4) << config.producers << "p" << std::setw(4)
+            << config.consumers << "c" << std::setw(10) << std::fixed
+            << std::setprecision(3) << items / result.seconds / 1e6
+            << " Mops/s";
+  if (result.unpinned) {
+    std::cout << "  (pinning failed, layout not applied)";
+  }
+  if (config.perf) {
+    for (int e{}; e < TSC::PerfCounters::NB_EVENTS; ++e) {
+      auto event = static_cast<TSC::PerfCounters::Event>(e);
+      std::cout << "  " << TSC::PerfCounters::name(event) << "/op ";
+      if (result.counters.valid[e]) {
+        std::cout << std::setprecision(3)
+                  << result.counters.values[e] / items;
+      } else {
+        std::cout << "n/a";
+      }
+    }
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  Config config;
+
+  for (int i{1}; i < argc; ++i) {
+    std::string arg{argv[i]};
+    auto next = [&]() -> size_t {
+      if (i + 1 >= argc) {
+        std::cerr << "missing value for " << arg << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      return std::stoul(argv[++i]);
+    };
+
+    if (arg == "--producers") {
+      config.producers = std::max<size_t>(next(), 1u);
+    } else if (arg == "--consumers") {
+      config.consumers = std::max<size_t>(next(), 1u);
+    } else if (arg == "--capacity") {
+      config.capacity = std::max<size_t>(next(), 1u);
+    } else if (arg == "--items") {
+      config.items = next();
+      if (config.items == 0u) {
+        std::cerr << "--items must be positive" << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--runs") {
+      config.runs = next();
+    } else if (arg == "--perf") {
+      config.perf = true;
+    } else if (arg == "--layout" && i + 1 < argc) {
+      std::string layout{argv[++i]};
+      config.layouts.clear();
+      for (auto candidate :
+           {TSC::Affinity::Layout::None, TSC::Affinity::Layout::SameCpu,
+            TSC::Affinity::Layout::Siblings, TSC::Affinity::Layout::SameL3,
+            TSC::Affinity::Layout::CrossSocket}) {
+        if (layout == "all" || layout == TSC::Affinity::name(candidate)) {
+          config.layouts.push_back(candidate);
+        }
+      }
+      if (config.layouts.empty()) {
+        std::cerr << "unknown layout " << layout << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--producers N] [--consumers N] [--capacity N]"
+                   " [--items N] [--runs N] [--perf]"
+                   " [--layout none|same-cpu|siblings|same-l3|x-socket|all]"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (config.perf && !TSC::PerfCounters{}.available()) {
+    std::cerr << "perf events unavailable, reporting throughput only"
+              << std::endl;
+    config.perf = false;
+  }
+
+  for (auto layout : std::vector<TSC::Affinity::Layout>{config.layouts}) {
+    Config current{config};
+    current.layouts = {layout};
+    if (!TSC::Affinity::place(layout, current.producers, current.consumers,
+                              current.placement)) {
+      std::cout << TSC::Affinity::name(layout)
+                << " layout unavailable on this machine" << std::endl;
+      continue;
+    }
+
+    for (size_t r{}; r < current.runs; ++r) {
+      report("mutex", current, run<TSC::ThreadSafeContainer<int>>(current));
+      report("combining", current,
+             run<TSC::FlatCombiningContainer<int>>(current));
+      report("two-lock", current, run<TSC::TwoLockContainer<int>>(current));
+      report("fetch-add", current,
+             run<TSC::FetchAddContainer<int>>(current));
+      report("segmented", current,
+             run<TSC::SegmentedContainer<int>>(current));
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
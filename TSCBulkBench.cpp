@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+
+struct Config {
+  size_t capacity{1024u};
+  size_t batch{256u};
+  size_t items{4000000u};
+  size_t runs{3u};
+};
+
+struct Pod16 {
+  std::uint64_t low;
+  std::uint64_t high;
+};
+
+struct Pod64 {
+  char bytes[64];
+};
+
+// Item factories, so that every payload carries a distinct value.
+int make(int *, size_t n) { return static_cast<int>(n); }
+
+std::uint64_t make(std::uint64_t *, size_t n) { return n; }
+
+Pod16 make(Pod16 *, size_t n) { return Pod16{n, ~std::uint64_t{n}}; }
+
+Pod64 make(Pod64 *, size_t n) {
+  Pod64 pod;
+  std::fill(std::begin(pod.bytes), std::end(pod.bytes),
+            static_cast<char>(n));
+  return pod;
+}
+
+std::unique_ptr<int> make(std::unique_ptr<int> *, size_t n) {
+  return std::unique_ptr<int>{new int{static_cast<int>(n)}};
+}
+
+// Items go through the queue one at a time.
+template <typename T>
+void single(TSC::ThreadSafeContainer<T> &queue, std::vector<T> &in,
+            std::vector<T> &out, size_t batch) {
+  for (size_t i{}; i < batch; ++i) {
+    queue.tryAdd(std::move(in[i]));
+  }
+  for (size_t i{}; i < batch; ++i) {
+    queue.tryRemove(out[i]);
+  }
+}
+
+// Bulk calls through vector iterators, which take the per-element path.
+template <typename T>
+void elementwise(TSC::ThreadSafeContainer<T> &queue, std::vector<T> &in,
+                 std::vector<T> &out, size_t batch) {
+  queue.tryAddBulk(std::make_move_iterator(in.begin()), batch);
+  queue.tryRemoveBulk(out.begin(), batch);
+}
+
+// Bulk calls through pointers, which take the memcpy path whenever the
+// type allows it. Items that are not trivially copyable are still moved
+// in one at a time, and relocated out with memcpy.
+template <typename T>
+void relocating(TSC::ThreadSafeContainer<T> &queue, std::vector<T> &in,
+                std::vector<T> &out, size_t batch) {
+  queue.tryAddBulk(std::make_move_iterator(in.data()), batch);
+  queue.tryRemoveBulk(out.data(), batch);
+}
+
+// Returns the nanoseconds spent per item, excluding the creation of the
+// items, which the output items are moved back into between batches.
+template <typename T, typename Transfer>
+double measure(const Config &config, Transfer transfer) {
+  TSC::ThreadSafeContainer<T> queue{config.capacity};
+  std::vector<T> in, out(config.batch);
+  std::chrono::duration<double, std::nano> elapsed{};
+
+  for (size_t i{}; i < config.batch; ++i) {
+    in.push_back(make(static_cast<T *>(nullptr), i));
+  }
+  for (size_t done{}; done < config.items; done += config.batch) {
+    auto start = std::chrono::steady_clock::now();
+    transfer(queue, in, out, config.batch);
+    elapsed += std::chrono::steady_clock::now() - start;
+    std::swap(in, out);
+  }
+  return elapsed.count() / static_cast<double>(config.items);
+}
+
+void report(const std::string &type, const std::string &mode,
+            double nanoseconds) {
+  std::cout << std::left << std::setw(16) << type << std::setw(14) << mode
+            << std::right << std::fixed << std::setprecision(2)
+            << std::setw(10) << nanoseconds << " ns/item" << std::endl;
+}
+
+template <typename T>
+void runAll(const std::string &type, const Config &config) {
+  report(type, "single", measure<T>(config, single<T>));
+  report(type, "bulk-element", measure<T>(config, elementwise<T>));
+  report(type, "bulk-memcpy", measure<T>(config, relocating<T>));
+}
+
+// Bulk calls through pointers with each copy kernel the CPU supports.
+// Batches of at least TSC::Simd::STREAM_THRESHOLD bytes use streaming
+// stores.
+template <typename T>
+void runKernels(const std::string &type, const Config &config) {
+  for (auto kernel : {TSC::Simd::Kernel::Scalar, TSC::Simd::Kernel::Sse2,
+                      TSC::Simd::Kernel::Avx2}) {
+    if (TSC::Simd::select(kernel)) {
+      report(type, std::string{"bulk-"} + TSC::Simd::name(kernel),
+             measure<T>(config, relocating<T>));
+    }
+  }
+  TSC::Simd::select(TSC::Simd::defaultKernel());
+}
+
+int main(int argc, char *argv[]) {
+  Config config;
+
+  for (int i{1}; i < argc; ++i) {
+    std::string arg{argv[i]};
+    auto next = [&]() -> size_t {
+      if (i + 1 >= argc) {
+        std::cerr << "missing value for " << arg << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      return std::stoul(argv[++i]);
+    };
+
+    if (arg == "--capacity") {
+      config.capacity = std::max<size_t>(next(), 1u);
+    } else if (arg == "--batch") {
+      config.batch = std::max<size_t>(next(), 1u);
+    } else if (arg == "--items") {
+      config.items = next();
+    } else if (arg == "--runs") {
+      config.runs = next();
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--capacity N] [--batch N] [--items N] [--runs N]"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  config.batch = std::min(config.batch, config.capacity);
+
+  for (size_t run{}; run < config.runs; ++run) {
+    runAll<int>("int", config);
+    runAll<Pod64>("pod64", config);
+    runAll<std::unique_ptr<int>>("unique_ptr", config);
+    runKernels<int>("int", config);
+    runKernels<std::uint64_t>("uint64", config);
+    runKernels<Pod16>("pod16", config);
+  }
+
+  return 0;
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Locks.hpp"
+#include "ThreadSafeContainer.hpp"
+
+struct Config {
+  std::vector<size_t> threads{2u, 4u, 8u, 16u, 32u, 64u};
+  size_t milliseconds{200u};
+  size_t capacity{1024u};
+  size_t items{200000u};
+  size_t runs{1u};
+};
+
+struct Result {
+  double mops{};
+  double p99{};
+};
+
+// Threads take the lock in turn for a short critical section, and record
+// how long each acquisition waited. Throughput counts acquisitions.
+template <typename Lock>
+Result contend(const Config &config, size_t threads) {
+  Lock lock;
+  std::atomic<bool> go{false}, stop{false};
+  std::vector<std::vector<std::uint32_t>> waits(threads);
+  std::vector<std::thread> workers;
+  volatile size_t shared[8]{};
+
+  for (size_t i{}; i < threads; ++i) {
+    workers.emplace_back([&, i] {
+      auto &samples = waits[i];
+      samples.reserve(1u << 16);
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto start = std::chrono::steady_clock::now();
+        lock.lock();
+        auto acquired = std::chrono::steady_clock::now();
+        for (auto &word : shared) {
+          word = word + 1u;
+        }
+        lock.unlock();
+        samples.push_back(static_cast<std::uint32_t>(std::min<long long>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(acquired -
+                                                                 start)
+                .count(),
+            UINT32_MAX)));
+      }
+    });
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::milliseconds{config.milliseconds});
+  stop.store(true, std::memory_order_relaxed);
+  for (auto &t : workers) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::vector<std::uint32_t> all;
+  for (auto &samples : waits) {
+    all.insert(all.end(), samples.begin(), samples.end());
+  }
+  Result result;
+  result.mops = static_cast<double>(all.size()) / seconds / 1e6;
+  if (!all.empty()) {
+    auto p99 = all.begin() + static_cast<std::ptrdiff_t>(all.size() * 99u /
+                                                          100u);
+    std::nth_element(all.begin(), p99, all.end());
+    result.p99 = *p99;
+  }
+  return result;
+}
+
+// Half of the threads move config.items integers to the other half
+// through a container guarded by the lock.
+template <typename Lock>
+double transfer(const Config &config, size_t threads) {
+  TSC::ThreadSafeContainer<int, Lock> queue{config.capacity};
+  size_t producers = std::max<size_t>(threads / 2u, 1u);
+  size_t consumers = std::max<size_t>(threads - producers, 1u);
+  std::vector<std::thread> workers;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i{}; i < producers; ++i) {
+    size_t count = config.items / producers +
+                   (i < config.items % producers ? 1u : 0u);
+    workers.emplace_back([&queue, count] {
+      for (size_t n{}; n < count; ++n) {
+        queue.waitAdd(static_cast<int>(n));
+      }
+    });
+  }
+  for (size_t i{}; i < consumers; ++i) {
+    size_t count = config.items / consumers +
+                   (i < config.items % consumers ? 1u : 0u);
+    workers.emplace_back([&queue, count] {
+      int item;
+      for (size_t n{}; n < count; ++n) {
+        queue.waitRemove(item);
+      }
+    });
+  }
+  for (auto &t : workers) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return static_cast<double>(config.items) / seconds / 1e6;
+}
+
+template <typename Lock>
+void runAll(const std::string &name, const Config &config) {
+  for (size_t threads : config.threads) {
+    Result result = contend<Lock>(config, threads);
+    double container = transfer<Lock>(config, threads);
+    std::cout << std::left << std::setw(10) << name << std::right
+              << std::setw(4) << threads << " threads" << std::fixed
+              << std::setprecision(3) << std::setw(10) << result.mops
+              << " Mlocks/s" << std::setprecision(0) << std::setw(12)
+              << result.p99 << " ns p99 wait" << std::setprecision(3)
+              << std::setw(10) << container << " Mops/s container"
+              << std::endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Config config;
+  std::string only;
+
+  for (int i{1}; i < argc; ++i) {
+    std::string arg{argv[i]};
+    auto next = [&]() -> size_t {
+      if (i + 1 >= argc) {
+        std::cerr << "missing value for " << arg << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      return std::stoul(argv[++i]);
+    };
+
+    if (arg == "--threads") {
+      config.threads = {std::max<size_t>(next(), 1u)};
+    } else if (arg == "--ms") {
+      config.milliseconds = next();
+    } else if (arg == "--capacity") {
+      config.capacity = std::max<size_t>(next(), 1u);
+    } else if (arg == "--items") {
+      config.items = next();
+    } else if (arg == "--runs") {
+      config.runs = next();
+    } else if (arg == "--lock" && i + 1 < argc) {
+      only = argv[++i];
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--threads N] [--ms N] [--capacity N] [--items N]"
+                   " [--runs N]"
+                   " [--lock mutex|ticket|mcs|clh|adaptive]"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  for (size_t run{}; run < config.runs; ++run) {
+    if (only.empty() || only == "mutex") {
+      runAll<std::mutex>("mutex", config);
+    }
+    if (only.empty() || only == "ticket") {
+      runAll<TSC::TicketLock>("ticket", config);
+    }
+    if (only.empty() || only == "mcs") {
+      runAll<TSC::McsLock>("mcs", config);
+    }
+    if (only.empty() || only == "clh") {
+      runAll<TSC::ClhLock>("clh", config);
+    }
+    if (only.empty() || only == "adaptive") {
+      runAll<TSC::AdaptiveMutex>("adaptive", config);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.hpp"
+#include "ThreadSafeContainer.hpp"
+
+struct Config {
+  size_t threads{std::max(std::thread::hardware_concurrency(), 1u)};
+  size_t tasks{1000000u};
+  size_t asyncTasks{20000u};
+  size_t runs{3u};
+};
+
+// The naive pool most of our code used to build by hand: workers looping
+// on waitRemove over a single queue of std::function copies.
+class NaivePool {
+ private:
+  TSC::ThreadSafeContainer<std::function<void()>> queue;
+  std::vector<std::thread> workers;
+
+ public:
+  explicit NaivePool(size_t threads) : queue{1024u} {
+    for (size_t i{}; i < threads; ++i) {
+      workers.emplace_back([this] {
+        std::function<void()> task;
+        try {
+          for (;;) {
+            queue.waitRemove(task);
+            task();
+          }
+        } catch (const TSC::ShutdownException &e) {
+        }
+      });
+    }
+  }
+
+  ~NaivePool() {
+    queue.close();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  void execute(const std::function<void()> &task) { queue.waitAdd(task); }
+};
+
+// Waits until every task has run.
+void await(const std::atomic<size_t> &done, size_t tasks) {
+  while (done.load(std::memory_order_acquire) < tasks) {
+    std::this_thread::yield();
+  }
+}
+
+// Each task captures three words, which exceeds the inline storage of
+// std::function but leaves room for the promise of submit in a Task.
+template <typename Execute>
+double measure(size_t tasks, Execute execute) {
+  std::atomic<size_t> done{0u};
+  auto start = std::chrono::steady_clock::now();
+
+  for (size_t n{}; n < tasks; ++n) {
+    size_t a{n}, b{n + 1u};
+    execute([&done, a, b] {
+      if (a + b != 0u) {
+        done.fetch_add(1u, std::memory_order_release);
+      }
+    });
+  }
+  await(done, tasks);
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / static_cast<double>(tasks);
+}
+
+void report(const std::string &name, const Config &config, size_t tasks,
+            double nanoseconds) {
+  std::cout << std::left << std::setw(14) << name << std::right
+            << " threads=" << config.threads << " tasks=" << tasks
+            << std::fixed << std::setprecision(1) << std::setw(10)
+            << nanoseconds << " ns/task" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  Config config;
+
+  for (int i{1}; i < argc; ++i) {
+    std::string arg{argv[i]};
+    auto next = [&]() -> size_t {
+      if (i + 1 >= argc) {
+        std::cerr << "missing value for " << arg << std::endl;
+        std::exit(EXIT_FAILURE);
+      }
+      return std::stoul(argv[++i]);
+    };
+
+    if (arg == "--threads") {
+      config.threads = std::max<size_t>(next(), 1u);
+    } else if (arg == "--tasks") {
+      config.tasks = std::max<size_t>(next(), 1u);
+    } else if (arg == "--async-tasks") {
+      config.asyncTasks = std::max<size_t>(next(), 1u);
+    } else if (arg == "--runs") {
+      config.runs = next();
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--threads N] [--tasks N] [--async-tasks N] [--runs N]"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  for (size_t run{}; run < config.runs; ++run) {
+    {
+      TSC::ThreadPool pool{config.threads};
+      report("pool execute", config, config.tasks,
+             measure(config.tasks, [&pool](auto task) {
+               pool.execute(std::move(task));
+             }));
+      report("pool submit", config, config.tasks,
+             measure(config.tasks,
+                     [&pool](auto task) { pool.submit(std::move(task)); }));
+    }
+    {
+      NaivePool pool{config.threads};
+      report("naive pool", config, config.tasks,
+             measure(config.tasks,
+                     [&pool](auto task) { pool.execute(std::move(task)); }));
+    }
+    {
+      // std::async starts a thread per task, hence fewer tasks.
+      std::vector<std::future<void>> futures;
+      futures.reserve(config.asyncTasks);
+      report("std::async", config, config.asyncTasks,
+             measure(config.asyncTasks, [&futures](auto task) {
+               futures.push_back(std::async(std::launch::async, task));
+             }));
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,36 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "ThreadSafeContainer.hpp"
+#include "WorkloadReplayer.hpp"
+
+// Replays a trace recorded with TSC_ENABLE_RECORDER against a
+// ThreadSafeContainer<int> of the given capacity.
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <trace-file> <capacity> [speed]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    TSC::Trace trace = TSC::TraceFile::load(argv[1]);
+    TSC::ThreadSafeContainer<int> mtq{std::stoul(argv[2])};
+    double speed = argc > 3 ? std::stod(argv[3]) : 1.0;
+
+    TSC::ReplayStats stats = TSC::replay(trace, mtq, 0, speed);
+    std::cout << "threads    : " << stats.threads << '\n'
+              << "operations : " << stats.operations << '\n'
+              << "successes  : " << stats.successes << '\n'
+              << "failures   : " << stats.failures << '\n'
+              << "shutdowns  : " << stats.shutdowns << '\n'
+              << "blocked ns : " << stats.blocked.count() << '\n'
+              << "elapsed ns : " << stats.elapsed.count() << std::endl;
+  } catch (const std::exception &e) {
+    std::cerr << "replay failed: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
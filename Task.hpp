@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Relocatable.hpp"
+
+namespace TSC {
+// The InlineTask is a move-only type-erased void() callable meant to be
+// stored in task queues. Callables of up to Size bytes that are trivially
+// relocatable or nothrow move constructible are stored inline, so that
+// typical lambdas capturing references, scalars, strings or shared
+// pointers need no allocation, while other callables are kept on the heap.
+// Moving a task copies its storage with memcpy, unless it holds a callable
+// that must be relocated with its move constructor and destructor.
+template <std::size_t Size>
+class InlineTask {
+  static_assert(Size >= sizeof(void *), "the storage must hold a pointer");
+
+ public:
+  static constexpr std::size_t INLINE_SIZE{Size};
+
+ private:
+  // Operations of the stored callable, shared by every task of its type.
+  // Relocation is null when a plain copy of the storage will do.
+  struct Operations {
+    void (*invoke)(void *storage);
+    void (*destroy)(void *storage);
+    void (*relocate)(void *target, void *source);
+  };
+
+  template <typename F>
+  struct Inline {
+    static F &get(void *storage) {
+      return *static_cast<F *>(storage);
+    }
+
+    static void invoke(void *storage) { get(storage)(); }
+
+    static void destroy(void *storage) { get(storage).~F(); }
+
+    static void relocate(void *target, void *source) {
+      new (target) F(std::move(get(source)));
+      destroy(source);
+    }
+
+    static const Operations *operations() {
+      static constexpr Operations table{
+          invoke, destroy,
+          IsTriviallyRelocatable<F>::value ? nullptr : relocate};
+      return &table;
+    }
+  };
+
+  template <typename F>
+  struct Heap {
+    static F *get(void *storage) {
+      return *static_cast<F **>(storage);
+    }
+
+    static void invoke(void *storage) { (*get(storage))(); }
+
+    static void destroy(void *storage) { delete get(storage); }
+
+    static const Operations *operations() {
+      static constexpr Operations table{invoke, destroy, nullptr};
+      return &table;
+    }
+  };
+
+  template <typename F>
+  using Fits = std::integral_constant<
+      bool, sizeof(F) <= Size && alignof(F) <= alignof(std::max_align_t) &&
+                (IsTriviallyRelocatable<F>::value ||
+                 std::is_nothrow_move_constructible<F>::value)>;
+
+  // The storage is an array rather than an aligned_storage, whose size
+  // would be rounded up to its alignment.
+  alignas(std::max_align_t) unsigned char storage[Size];
+  const Operations *operations;
+
+  template <typename F>
+  void store(F &&function, std::true_type) {
+    using Callable = typename std::decay<F>::type;
+    new (storage) Callable(std::forward<F>(function));
+    operations = Inline<Callable>::operations();
+  }
+
+  template <typename F>
+  void store(F &&function, std::false_type) {
+    using Callable = typename std::decay<F>::type;
+    new (storage) Callable *(new Callable(std::forward<F>(function)));
+    operations = Heap<Callable>::operations();
+  }
+
+  // Takes the callable of src over, src being left empty.
+  void take(InlineTask &src) noexcept {
+    operations = src.operations;
+    if (operations != nullptr) {
+      if (operations->relocate != nullptr) {
+        operations->relocate(storage, src.storage);
+      } else {
+        std::memcpy(storage, src.storage, Size);
+      }
+      src.operations = nullptr;
+    }
+  }
+
+  void reset() {
+    if (operations != nullptr) {
+      operations->destroy(storage);
+      operations = nullptr;
+    }
+  }
+
+ public:
+  InlineTask() noexcept : operations{nullptr} {}
+
+  template <typename F,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type, InlineTask>::value>::type>
+  InlineTask(F &&function) : operations{nullptr} {
+    store(std::forward<F>(function), Fits<typename std::decay<F>::type>{});
+  }
+
+  InlineTask(InlineTask &&src) noexcept { take(src); }
+
+  InlineTask &operator=(InlineTask &&rhs) noexcept {
+    if (this != &rhs) {
+      reset();
+      take(rhs);
+    }
+    return *this;
+  }
+
+  InlineTask(const InlineTask &src) = delete;
+
+  InlineTask &operator=(const InlineTask &rhs) = delete;
+
+  ~InlineTask() { reset(); }
+
+  // Whether the callable of type F would be stored inline.
+  template <typename F>
+  static constexpr bool storesInline() {
+    return Fits<typename std::decay<F>::type>::value;
+  }
+
+  explicit operator bool() const { return operations != nullptr; }
+
+  void operator()() { operations->invoke(storage); }
+};
+
+template <std::size_t Size>
+constexpr std::size_t InlineTask<Size>::INLINE_SIZE;
+
+// The default task takes a whole cache line.
+using Task = InlineTask<64u - sizeof(void *)>;
+}  // namespace TSC
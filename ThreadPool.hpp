@@ -0,0 +1,382 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Future.hpp"
+#include "Task.hpp"
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+namespace detail {
+template <typename R, typename F>
+void fulfil(Promise<R> &promise, F &function, std::false_type) {
+  try {
+    promise.setValue(function());
+  } catch (...) {
+    promise.setException(std::current_exception());
+  }
+}
+
+template <typename F>
+void fulfil(Promise<void> &promise, F &function, std::true_type) {
+  try {
+    function();
+    promise.setValue();
+  } catch (...) {
+    promise.setException(std::current_exception());
+  }
+}
+
+// The function of a submitted job shares its block with the future state,
+// so that submit allocates once.
+template <typename R, typename F>
+struct SubmittedState : FutureState<R> {
+  F function;
+
+  explicit SubmittedState(F callable) : function{std::move(callable)} {}
+};
+
+// The callable queued by submit. It holds the promise and a pointer to the
+// function, both into the shared block, which leaves the job trivially
+// relocatable and small enough to be stored inline in a Task.
+template <typename R, typename F>
+class SubmittedJob {
+ private:
+  Promise<R> promise;
+  F *function;
+
+ public:
+  explicit SubmittedJob(std::shared_ptr<SubmittedState<R, F>> state)
+      : promise{state}, function{&state->function} {}
+
+  Future<R> getFuture() { return promise.getFuture(); }
+
+  void operator()() { fulfil(promise, *function, std::is_void<R>{}); }
+};
+}  // namespace detail
+
+template <typename R, typename F>
+struct IsTriviallyRelocatable<detail::SubmittedJob<R, F>> : std::true_type {};
+
+// The ThreadPool runs tasks on a fixed set of workers. Each worker owns a
+// bounded local queue, and a shared overflow queue takes the tasks that
+// find the chosen local queue full. Tasks posted by a worker go to its own
+// queue, other tasks are spread round-robin. An idle worker takes tasks
+// from its own queue first, then from the overflow queue, then from the
+// other workers, and sleeps on a condition variable once every queue is
+// empty. Destroying the pool runs the queued tasks before joining.
+// Workers never block on the queues themselves: a task they post while
+// both their local queue and the overflow queue are full runs inline,
+// whereas execute blocks other threads until the overflow queue has room.
+class ThreadPool {
+ public:
+  using size_type = std::size_t;
+
+  static constexpr size_type DEFAULT_LOCAL_CAPACITY{256u};
+  static constexpr size_type DEFAULT_OVERFLOW_CAPACITY{65536u};
+
+ private:
+  // Counts the outstanding tasks of a parallelFor or parallelInvoke call,
+  // and keeps the first exception thrown by one of them.
+  class Group {
+   private:
+    std::atomic<size_type> remaining;
+    std::mutex mtx;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+   public:
+    explicit Group(size_type tasks) : remaining{tasks} {}
+
+    bool finished() const { return remaining.load() == 0u; }
+
+    void arrive(std::exception_ptr failure);
+
+    // Blocks until every task has arrived, then rethrows the first
+    // exception, if any.
+    void wait();
+  };
+
+  std::vector<std::unique_ptr<ThreadSafeContainer<Task>>> locals;
+  ThreadSafeContainer<Task> overflow;
+  std::vector<std::thread> workers;
+  std::atomic<size_type> next{0u};
+  // Tasks are counted before being queued, so that a worker never sleeps
+  // while a task it could run is on its way.
+  std::atomic<std::ptrdiff_t> pending{0};
+  std::atomic<size_type> sleepers{0u};
+  std::atomic<bool> stopping{false};
+  std::mutex mtx;
+  std::condition_variable wake;
+
+  // The worker running on the current thread, if any.
+  static std::pair<const ThreadPool *, size_type> &currentWorker() {
+    static thread_local std::pair<const ThreadPool *, size_type> worker{
+        nullptr, 0u};
+    return worker;
+  }
+
+  size_type self() const;
+
+  bool runOne(size_type index);
+
+  void work(size_type index);
+
+  void helpWait(Group &group);
+
+ public:
+  explicit ThreadPool(
+      size_type threads = std::max(std::thread::hardware_concurrency(), 1u),
+      size_type localCapacity = DEFAULT_LOCAL_CAPACITY,
+      size_type overflowCapacity = DEFAULT_OVERFLOW_CAPACITY);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &src) = delete;
+
+  ThreadPool &operator=(const ThreadPool &rhs) = delete;
+
+  size_type size() const { return workers.size(); }
+
+  // The execute method queues a task without any way to wait for it. The
+  // task must not throw.
+  void execute(Task task);
+
+  // The submit method queues the function and returns a Future of its
+  // result, which also carries the exception it may throw.
+  template <typename F>
+  Future<typename std::result_of<typename std::decay<F>::type()>::type>
+  submit(F &&function);
+
+  // The parallelFor method calls body(i) for every i in [begin, end),
+  // split into chunks of at least grain indices, and returns once every
+  // call has returned. The calling thread runs queued tasks meanwhile.
+  template <typename Index, typename Body>
+  void parallelFor(Index begin, Index end, Body body, size_type grain = 1u);
+
+  // The parallelInvoke method calls every function in parallel and returns
+  // once they have all returned.
+  template <typename... Functions>
+  void parallelInvoke(Functions &&... functions);
+};
+
+// The count is decreased under the lock, so that the waiter cannot
+// destroy the group before the last arrival is over.
+inline void ThreadPool::Group::arrive(std::exception_ptr failure) {
+  std::lock_guard<std::mutex> lock{mtx};
+
+  if (failure && !error) {
+    error = failure;
+  }
+  if (remaining.fetch_sub(1u) == 1u) {
+    done.notify_all();
+  }
+}
+
+inline void ThreadPool::Group::wait() {
+  std::unique_lock<std::mutex> lock{mtx};
+
+  done.wait(lock, [this] { return finished(); });
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+inline ThreadPool::ThreadPool(size_type threads, size_type localCapacity,
+                              size_type overflowCapacity)
+    : overflow{overflowCapacity} {
+  threads = std::max<size_type>(threads, 1u);
+  for (size_type i{}; i < threads; ++i) {
+    locals.emplace_back(new ThreadSafeContainer<Task>{localCapacity});
+  }
+  for (size_type i{}; i < threads; ++i) {
+    workers.emplace_back(&ThreadPool::work, this, i);
+  }
+}
+
+inline ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{mtx};
+    stopping.store(true);
+    wake.notify_all();
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+// Index of the worker running on the current thread, or the number of
+// workers for other threads.
+inline ThreadPool::size_type ThreadPool::self() const {
+  const auto &worker = currentWorker();
+
+  return worker.first == this ? worker.second : locals.size();
+}
+
+// Once the pool is being destroyed, only the tasks being run
+// may queue further tasks.
+inline void ThreadPool::execute(Task task) {
+  size_type index = self();
+  bool worker = index < locals.size();
+  bool queued{true};
+
+  if (stopping.load() && !worker) {
+    throw ShutdownException("shutdown");
+  }
+  if (!worker) {
+    index = next.fetch_add(1u, std::memory_order_relaxed) % locals.size();
+  }
+
+  pending.fetch_add(1);
+  try {
+    if (!locals[index]->tryAdd(std::move(task))) {
+      if (worker) {
+        queued = overflow.tryAdd(std::move(task));
+      } else {
+        overflow.waitAdd(std::move(task));
+      }
+    }
+  } catch (...) {
+    pending.fetch_sub(1);
+    throw;
+  }
+  // A worker waiting for room in the overflow queue could deadlock the
+  // pool, as the workers are the only threads making room.
+  if (!queued) {
+    pending.fetch_sub(1);
+    task();
+    return;
+  }
+  if (sleepers.load() > 0u) {
+    std::lock_guard<std::mutex> lock{mtx};
+    wake.notify_one();
+  }
+}
+
+inline bool ThreadPool::runOne(size_type index) {
+  Task task;
+  size_type count = locals.size();
+  bool found = index < count && locals[index]->tryRemove(task);
+
+  if (!found) {
+    found = overflow.tryRemove(task);
+  }
+  for (size_type i{1u}; !found && i <= count; ++i) {
+    found = locals[(index + i) % count]->tryRemove(task);
+  }
+  if (!found) {
+    return false;
+  }
+  pending.fetch_sub(1);
+  task();
+  return true;
+}
+
+inline void ThreadPool::work(size_type index) {
+  currentWorker() = {this, index};
+
+  for (;;) {
+    if (runOne(index)) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{mtx};
+    // The sleeper is counted before checking for tasks again, so that a
+    // concurrent execute either sees it or is seen.
+    sleepers.fetch_add(1u);
+    wake.wait(lock, [this] { return pending.load() > 0 || stopping.load(); });
+    sleepers.fetch_sub(1u);
+    if (stopping.load() && pending.load() <= 0) {
+      break;
+    }
+  }
+}
+
+// The helpWait method runs queued tasks until none is left, which
+// prevents workers waiting for nested groups from starving the pool.
+inline void ThreadPool::helpWait(Group &group) {
+  size_type index = self();
+
+  while (!group.finished() && runOne(index)) {
+  }
+  group.wait();
+}
+
+template <typename F>
+Future<typename std::result_of<typename std::decay<F>::type()>::type>
+ThreadPool::submit(F &&function) {
+  using Callable = typename std::decay<F>::type;
+  using Result = typename std::result_of<Callable()>::type;
+  using State = detail::SubmittedState<Result, Callable>;
+  detail::SubmittedJob<Result, Callable> job{std::allocate_shared<State>(
+      std::allocator<State>{}, Callable(std::forward<F>(function)))};
+  Future<Result> future = job.getFuture();
+
+  execute(std::move(job));
+  return future;
+}
+
+template <typename Index, typename Body>
+void ThreadPool::parallelFor(Index begin, Index end, Body body,
+                             size_type grain) {
+  if (!(begin < end)) {
+    return;
+  }
+
+  auto count = static_cast<size_type>(end - begin);
+  // A few chunks per worker balance the load without
+  // queueing one task per index.
+  size_type chunks = std::min(count / std::max<size_type>(grain, 1u),
+                              4u * workers.size());
+  chunks = std::max<size_type>(chunks, 1u);
+  Group group{chunks};
+
+  for (size_type chunk{}; chunk < chunks; ++chunk) {
+    Index first = begin + static_cast<Index>(count * chunk / chunks);
+    Index last = begin + static_cast<Index>(count * (chunk + 1u) / chunks);
+    execute([&group, &body, first, last] {
+      std::exception_ptr failure;
+      try {
+        for (Index i = first; i < last; ++i) {
+          body(i);
+        }
+      } catch (...) {
+        failure = std::current_exception();
+      }
+      group.arrive(failure);
+    });
+  }
+  helpWait(group);
+}
+
+template <typename... Functions>
+void ThreadPool::parallelInvoke(Functions &&... functions) {
+  Group group{sizeof...(Functions)};
+  auto post = [this, &group](auto &function) {
+    execute([&group, &function] {
+      std::exception_ptr failure;
+      try {
+        function();
+      } catch (...) {
+        failure = std::current_exception();
+      }
+      group.arrive(failure);
+    });
+  };
+
+  // Expands the pack in order within a braced list.
+  int expand[]{0, (post(functions), 0)...};
+  (void)expand;
+  helpWait(group);
+}
+}  // namespace TSC
@@ -0,0 +1,158 @@
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Task.hpp"
+#include "ThreadPool.hpp"
+
+constexpr size_t NB_WORKERS{4u};
+constexpr size_t NB_TASKS{20000u};
+constexpr size_t NB_INDICES{100000u};
+
+void tasks() {
+  int calls{};
+  auto owned = std::unique_ptr<int>{new int{5}};
+  char large[128]{};
+  large[0] = 2;
+
+  auto increment = [&calls] { ++calls; };
+  auto addOwned = [&calls, owned = std::move(owned)] { calls += *owned; };
+  auto addLarge = [&calls, large] { calls += large[0]; };
+  auto addLength = [&calls, text = std::string{"abc"}] {
+    calls += static_cast<int>(text.size());
+  };
+  static_assert(sizeof(TSC::Task) == 64u, "a task takes a cache line");
+  static_assert(TSC::Task::storesInline<decltype(increment)>() &&
+                    TSC::Task::storesInline<decltype(addOwned)>() &&
+                    TSC::Task::storesInline<decltype(addLength)>(),
+                "small nothrow movable callables are stored inline");
+  static_assert(!TSC::Task::storesInline<decltype(addLarge)>(),
+                "larger callables are stored on the heap");
+  static_assert(TSC::InlineTask<16u>::storesInline<void (*)()>(),
+                "the inline size is configurable");
+
+  TSC::Task small{increment};
+  TSC::Task moved{std::move(small)};
+  assert(!small && moved);
+  moved();
+
+  // Inline callables that are not trivially relocatable, such as a
+  // string whose characters are stored inline, are moved through the ring
+  // with their move constructor.
+  TSC::ThreadSafeContainer<TSC::Task> mtq{3u};
+  TSC::Task task;
+  mtq.waitAdd(TSC::Task{std::move(addOwned)});
+  mtq.waitAdd(TSC::Task{addLarge});
+  mtq.waitAdd(TSC::Task{addLength});
+  for (int round{}; round < 3; ++round) {
+    mtq.waitRemove(task);
+    task();
+    mtq.waitAdd(std::move(task));
+  }
+  while (mtq.tryRemove(task)) {
+    task();
+  }
+  assert(calls == 21);
+}
+
+void submit() {
+  TSC::ThreadPool pool{NB_WORKERS, 16u};
+  std::vector<TSC::Future<size_t>> futures;
+  std::atomic<size_t> executed{0u};
+  auto twice = [](size_t n) { return [n] { return n * 2u; }; };
+
+  // The function shares its allocation with the future state, and the
+  // queued job only holds pointers to it.
+  static_assert(TSC::Task::storesInline<
+                    TSC::detail::SubmittedJob<size_t, decltype(twice(0u))>>(),
+                "submitted jobs are stored inline");
+
+  for (size_t n{}; n < NB_TASKS; ++n) {
+    futures.push_back(pool.submit(twice(n)));
+  }
+  for (size_t n{}; n < NB_TASKS; ++n) {
+    assert(futures[n].get() == n * 2u);
+  }
+
+  auto failing = pool.submit([]() -> std::string {
+    throw std::runtime_error("failed");
+  });
+  try {
+    failing.get();
+    assert(false);
+  } catch (const std::runtime_error &e) {
+  }
+
+  // Tasks queued by tasks run before the pool is destroyed.
+  {
+    TSC::ThreadPool nested{NB_WORKERS};
+    for (size_t n{}; n < 100u; ++n) {
+      nested.execute([&nested, &executed] {
+        ++executed;
+        nested.execute([&executed] { ++executed; });
+      });
+    }
+  }
+  assert(executed.load() == 200u);
+
+  // A worker posting while every queue is full runs the task itself
+  // instead of waiting for room only it could make.
+  executed.store(0u);
+  {
+    TSC::ThreadPool single{1u, 1u, 1u};
+    auto posted = single.submit([&single, &executed] {
+      for (size_t n{}; n < 100u; ++n) {
+        single.execute([&executed] { ++executed; });
+      }
+    });
+    posted.get();
+  }
+  assert(executed.load() == 100u);
+}
+
+void parallel() {
+  TSC::ThreadPool pool{NB_WORKERS};
+  std::vector<int> values(NB_INDICES, 0);
+
+  pool.parallelFor(size_t{0u}, NB_INDICES,
+                   [&values](size_t i) { values[i] = static_cast<int>(i); });
+  for (size_t i{}; i < NB_INDICES; ++i) {
+    assert(values[i] == static_cast<int>(i));
+  }
+
+  // Nested loops complete, the waiting workers running queued chunks.
+  std::atomic<size_t> count{0u};
+  pool.parallelFor(0, 16, [&pool, &count](int) {
+    pool.parallelFor(0, 1000, [&count](int) { ++count; });
+  });
+  assert(count.load() == 16000u);
+
+  int a{}, b{}, c{};
+  pool.parallelInvoke([&a] { a = 1; }, [&b] { b = 2; }, [&c] { c = 3; });
+  assert(a + b + c == 6);
+
+  try {
+    pool.parallelFor(0, 100, [](int i) {
+      if (i == 42) {
+        throw std::runtime_error("failed");
+      }
+    });
+    assert(false);
+  } catch (const std::runtime_error &e) {
+  }
+}
+
+int main() {
+  tasks();
+  submit();
+  parallel();
+
+  std::cout << "thread pool passed" << std::endl;
+
+  return 0;
+}
@@ -1,10 +1,21 @@
 #pragma once
 
+#include <algorithm>
 #include <condition_variable>
 #include <exception>
+#include <iterator>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
+#include <utility>
+
+#include "Future.hpp"
+#include "Locks.hpp"
+#include "RingBuffer.hpp"
+#include "StopToken.hpp"
+#include "Tracing.hpp"
+#include "UsdtProbes.hpp"
+#include "WorkloadRecorder.hpp"
 
 namespace TSC {
 class ShutdownException : public std::exception {
@@ -16,42 +27,324 @@ class ShutdownException : public std::exception {
   std::string message;
 };
 
-template <typename T>
+template <typename T, typename Lock = std::mutex>
+class ConsumeRange;
+
+// The Lock parameter is the type of the container lock, std::mutex or one
+// of the locks of Locks.hpp. Waits use std::condition_variable with
+// std::mutex, and std::condition_variable_any with the other locks.
+template <typename T, typename Lock = std::mutex>
 class ThreadSafeContainer {
- private:
-  mutable std::mutex mtx;
-  std::condition_variable notFull;
-  std::condition_variable notEmpty;
-  typename std::queue<T>::size_type maxSize;
-  std::queue<T> fifo;
+ protected:
+  using Condition = typename detail::ConditionFor<Lock>::type;
+
+  mutable Lock mtx;
+  Condition notFull;
+  Condition notEmpty;
+  typename RingBuffer<T>::size_type maxSize;
+  RingBuffer<T> fifo;
   bool inUse;
+  bool closed;
+
+  // Requests of asyncAdd and asyncRemove that cannot be served at once
+  // are queued as heap nodes linked into intrusive FIFO lists, instead of
+  // blocking threads. Served or failed nodes are moved to a Completions
+  // list, which runs them once the container lock is released.
+  struct AsyncWaiter {
+    AsyncWaiter *next{nullptr};
+    std::exception_ptr error;
+
+    virtual ~AsyncWaiter() = default;
+
+    virtual void complete() = 0;
+  };
+
+  struct AsyncAdd : AsyncWaiter {
+    T item;
+
+    explicit AsyncAdd(const T &value) : item{value} {}
+  };
+
+  struct AsyncRemove : AsyncWaiter {
+    T item{};
+  };
+
+  template <typename Callback>
+  struct AsyncAddCallback;
+
+  template <typename Callback>
+  struct AsyncRemoveCallback;
+
+  class WaiterList {
+   private:
+    AsyncWaiter *head{nullptr};
+    AsyncWaiter *tail{nullptr};
+
+   public:
+    bool empty() const { return head == nullptr; }
+
+    AsyncWaiter *front() const { return head; }
+
+    void push(AsyncWaiter *waiter);
+
+    AsyncWaiter *pop();
+  };
+
+  // The Completions list must be declared before the lock it is filled
+  // under, so that it is destroyed, and its waiters run, after unlocking.
+  // Callbacks must not throw.
+  class Completions : public WaiterList {
+   public:
+    ~Completions();
+  };
+
+  WaiterList addWaiters;
+  WaiterList removeWaiters;
+
+  template <typename U>
+  bool tryPush(U &&item);
+
+  // The waitPush and waitPop methods return false, without adding or
+  // removing, when stopped returns true while they would block.
+  template <typename U, typename Stopped>
+  bool waitPush(U &&item, Stopped stopped);
+
+  template <typename Stopped>
+  bool waitPop(T &item, Stopped stopped);
+
+  // The cancellable waits register a stop callback, of the type matching
+  // the token, which wakes the waiters up. The callback is destroyed once
+  // the container lock is released, as it locks the container.
+  template <template <typename> class Callback, typename Token, typename U>
+  bool cancellableAdd(U &&item, const Token &token);
+
+  template <template <typename> class Callback, typename Token>
+  bool cancellableRemove(T &item, const Token &token);
+
+  void finishAdd(typename RingBuffer<T>::size_type position, bool commit);
+
+  void serveWaiters(Completions &done) {
+    if (!addWaiters.empty() || !removeWaiters.empty()) {
+      serveWaitersSlow(done);
+    }
+  }
+
+  void serveWaitersSlow(Completions &done);
+
+  void failWaiters(WaiterList &waiters, Completions &done);
+
+  template <typename OutputIt>
+  typename RingBuffer<T>::size_type removeBulk(
+      OutputIt out, typename RingBuffer<T>::size_type maxItems,
+      Completions &done);
+
+  typename RingBuffer<T>::size_type removeBulk(
+      T *out, typename RingBuffer<T>::size_type maxItems, Completions &done);
+
+  template <typename InputIt>
+  typename RingBuffer<T>::size_type addBulk(
+      InputIt first, typename RingBuffer<T>::size_type count,
+      Completions &done);
+
+  friend class ConsumeRange<T, Lock>;
+
+  // The holdBulk method frees the slots of the yielded items previously
+  // held, then waits for items and moves up to maxItems of them to the
+  // uninitialized storage out, counting them in count, while holding
+  // their slots. The restore method hands count of them back to the front
+  // of the queue, and frees the slots held for the others.
+  void holdBulk(T *out, typename RingBuffer<T>::size_type maxItems,
+                typename RingBuffer<T>::size_type yielded,
+                typename RingBuffer<T>::size_type &count);
+
+  void restore(T *items, typename RingBuffer<T>::size_type count,
+               typename RingBuffer<T>::size_type held);
 
  public:
-  explicit ThreadSafeContainer(typename std::queue<T>::size_type capacity);
+  // The AddSlot handle refers to a slot reserved in the ring by reserveAdd
+  // or tryReserveAdd. The producer fills the slot in place and publishes it
+  // with commitAdd. A slot destroyed without having been committed is
+  // cancelled and skipped by consumers.
+  class AddSlot {
+   private:
+    ThreadSafeContainer<T, Lock> *owner;
+    typename RingBuffer<T>::size_type position;
+    bool constructed;
+
+    friend class ThreadSafeContainer<T, Lock>;
+
+    AddSlot(ThreadSafeContainer<T, Lock> *container,
+            typename RingBuffer<T>::size_type slot)
+        : owner{container}, position{slot}, constructed{false} {}
+
+   public:
+    AddSlot() : owner{nullptr}, position{0u}, constructed{false} {}
+
+    AddSlot(AddSlot &&src) noexcept;
+
+    AddSlot &operator=(AddSlot &&rhs) noexcept;
+
+    ~AddSlot();
+
+    explicit operator bool() const { return owner != nullptr; }
+
+    // Uninitialized storage of the slot. Types that are not trivially
+    // default constructible must be constructed with emplace instead.
+    T *get() const { return owner->fifo.slot(position); }
+
+    template <typename... Args>
+    T &emplace(Args &&... args);
+  };
+
+  // The RemoveSlot handle refers to the published item handed over by
+  // peekRemove or tryPeekRemove. The consumer processes the item in place,
+  // and its slot is only given back to producers by release.
+  class RemoveSlot {
+   private:
+    ThreadSafeContainer<T, Lock> *owner;
+    typename RingBuffer<T>::size_type position;
+
+    friend class ThreadSafeContainer<T, Lock>;
+
+    RemoveSlot(ThreadSafeContainer<T, Lock> *container,
+               typename RingBuffer<T>::size_type slot)
+        : owner{container}, position{slot} {}
+
+   public:
+    RemoveSlot() : owner{nullptr}, position{0u} {}
+
+    RemoveSlot(RemoveSlot &&src) noexcept;
+
+    RemoveSlot &operator=(RemoveSlot &&rhs) noexcept;
+
+    ~RemoveSlot();
+
+    explicit operator bool() const { return owner != nullptr; }
+
+    T *get() const { return owner->fifo.slot(position); }
+
+    T &operator*() const { return *get(); }
+
+    T *operator->() const { return get(); }
+  };
+
+  explicit ThreadSafeContainer(typename RingBuffer<T>::size_type capacity);
 
   virtual ~ThreadSafeContainer();
 
-  ThreadSafeContainer(const ThreadSafeContainer<T> &src) = delete;
+  ThreadSafeContainer(const ThreadSafeContainer<T, Lock> &src) = delete;
 
-  ThreadSafeContainer<T> &operator=(const ThreadSafeContainer<T> &rhs) = delete;
+  ThreadSafeContainer<T, Lock> &operator=(
+      const ThreadSafeContainer<T, Lock> &rhs) = delete;
 
-  ThreadSafeContainer(ThreadSafeContainer<T> &&src) = delete;
+  ThreadSafeContainer(ThreadSafeContainer<T, Lock> &&src) = delete;
 
-  ThreadSafeContainer<T> &operator=(ThreadSafeContainer<T> &&rhs) = delete;
+  ThreadSafeContainer<T, Lock> &operator=(
+      ThreadSafeContainer<T, Lock> &&rhs) = delete;
 
   bool tryAdd(const T &item);
 
+  bool tryAdd(T &&item);
+
   void waitAdd(const T &item);
 
+  void waitAdd(T &&item);
+
   bool tryRemove(T &item);
 
   void waitRemove(T &item);
 
+  // The cancellable waits return false, without adding or removing, when
+  // the stop of the token is requested while they wait, which leaves the
+  // container in use for the other threads. They still throw a
+  // ShutdownException after shutdown.
+  bool waitAdd(const T &item, const StopToken &token);
+
+  bool waitAdd(T &&item, const StopToken &token);
+
+  bool waitRemove(T &item, const StopToken &token);
+
+#ifdef __cpp_lib_jthread
+  bool waitAdd(const T &item, const std::stop_token &token);
+
+  bool waitAdd(T &&item, const std::stop_token &token);
+
+  bool waitRemove(T &item, const std::stop_token &token);
+#endif
+
+  // The bulk additions add items read from first within a single critical
+  // section. Trivially copyable items read through a pointer are copied
+  // with memcpy, and std::move_iterator moves the items in.
+  template <typename InputIt>
+  typename RingBuffer<T>::size_type tryAddBulk(
+      InputIt first, typename RingBuffer<T>::size_type count);
+
+  template <typename InputIt>
+  void waitAddBulk(InputIt first, typename RingBuffer<T>::size_type count);
+
+  // The bulk removals move up to maxItems items to out within a single
+  // critical section and return their number.
+  template <typename OutputIt>
+  typename RingBuffer<T>::size_type tryRemoveBulk(
+      OutputIt out, typename RingBuffer<T>::size_type maxItems);
+
+  template <typename OutputIt>
+  typename RingBuffer<T>::size_type waitRemoveBulk(
+      OutputIt out, typename RingBuffer<T>::size_type maxItems);
+
+  // Removals into an array of constructed items relocate trivially
+  // relocatable items with memcpy.
+  typename RingBuffer<T>::size_type tryRemoveBulk(
+      T *out, typename RingBuffer<T>::size_type maxItems);
+
+  typename RingBuffer<T>::size_type waitRemoveBulk(
+      T *out, typename RingBuffer<T>::size_type maxItems);
+
+  AddSlot tryReserveAdd();
+
+  AddSlot reserveAdd();
+
+  // The waitNotFull method blocks until the queue has room, without taking
+  // it, for producers which must not hold another resource while blocked.
+  void waitNotFull();
+
+  void commitAdd(AddSlot &slot);
+
+  RemoveSlot tryPeekRemove();
+
+  RemoveSlot peekRemove();
+
+  void release(RemoveSlot &slot);
+
+  // The asyncAdd method adds the item at once if there is room, otherwise
+  // queues a request that is served when room is made. The callback is
+  // invoked with a null exception_ptr once the item is added, or with a
+  // ShutdownException, from the thread that served or failed the request.
+  template <typename Callback>
+  void asyncAdd(const T &item, Callback callback);
+
+  Future<void> asyncAdd(const T &item);
+
+  // The asyncRemove method hands the front item to the callback, along with
+  // a null exception_ptr, at once or when an item is added.
+  template <typename Callback>
+  void asyncRemove(Callback callback);
+
+  Future<T> asyncRemove();
+
+  // The consume method returns a blocking input range over the removed
+  // items, fetched batch at a time, which ends on shutdown:
+  //   for (auto &item : queue.consume()) { ... }
+  ConsumeRange<T, Lock> consume(typename RingBuffer<T>::size_type batch =
+                              ConsumeRange<T, Lock>::DEFAULT_BATCH);
+
   void shutdown();
 
+  void close();
+
   void clear();
 
-  typename std::queue<T>::size_type size() const;
+  typename RingBuffer<T>::size_type size() const;
 
   bool empty() const;
 
@@ -60,3 +353,4 @@ class ThreadSafeContainer {
 }  // namespace TSC
 
 #include "ThreadSafeContainerPrivate.hpp"
+#include "ConsumeRange.hpp"
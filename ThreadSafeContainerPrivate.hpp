@@ -1,98 +1,192 @@
 #pragma once
 
 namespace TSC {
-template <typename T>
-ThreadSafeContainer<T>::ThreadSafeContainer(
-    typename std::queue<T>::size_type capacity)
-    : maxSize{capacity}, inUse{true} {}
+template <typename T, typename Lock>
+ThreadSafeContainer<T, Lock>::ThreadSafeContainer(
+    typename RingBuffer<T>::size_type capacity)
+    : maxSize{capacity}, fifo{capacity}, inUse{true}, closed{false} {}
 
-template <typename T>
-ThreadSafeContainer<T>::~ThreadSafeContainer() {
+template <typename T, typename Lock>
+ThreadSafeContainer<T, Lock>::~ThreadSafeContainer() {
   shutdown();
   clear();
 }
 
-// The tryAdd method returns true if tryAdd succeeds
-// and false if tryAdd fails.
-template <typename T>
-bool ThreadSafeContainer<T>::tryAdd(const T &item) {
-  std::lock_guard<std::mutex> lock{mtx};
+// The tryPush method returns true if the item is added
+// and false if the queue is full. It implements both
+// tryAdd overloads.
+template <typename T, typename Lock>
+template <typename U>
+bool ThreadSafeContainer<T, Lock>::tryPush(U &&item) {
+  Completions done;
+  TSC_RECORD_SCOPE(TraceOp::TryAdd);
+  TSC_USDT(try_add_entry, 1u);
+  TSC_TRACE_LOCK_BEGIN();
+  std::lock_guard<Lock> lock{mtx};
+  TSC_TRACE_LOCK_ACQUIRED();
 
-  if (!inUse) {
+  if (!inUse || closed) {
+    TSC_USDT(try_add_failure, fifo.size());
     throw ShutdownException("shutdown");
   }
 
-  if (fifo.size() == maxSize) {
+  if (fifo.full()) {
+    TSC_RECORD_RESULT(TraceOutcome::Failure, fifo.size());
+    TSC_USDT(try_add_failure, fifo.size());
     return false;
   } else {
-    fifo.push(item);
+    fifo.emplace(std::forward<U>(item));
+    TSC_RECORD_RESULT(TraceOutcome::Success, fifo.size());
+    TSC_USDT(try_add_success, fifo.size());
     // We signal to potential readers in case
     // the queue was previously empty.
     if (fifo.size() == 1) {
+      TSC_TRACE(NotifyNotEmpty);
       notEmpty.notify_all();
     }
+    serveWaiters(done);
     return true;
   }
 }
 
-template <typename T>
-void ThreadSafeContainer<T>::waitAdd(const T &item) {
-  std::unique_lock<std::mutex> lock{mtx};
+template <typename T, typename Lock>
+template <typename U, typename Stopped>
+bool ThreadSafeContainer<T, Lock>::waitPush(U &&item, Stopped stopped) {
+  Completions done;
+  TSC_RECORD_SCOPE(TraceOp::WaitAdd);
+  TSC_USDT(wait_add_entry, 1u);
+  TSC_TRACE_LOCK_BEGIN();
+  std::unique_lock<Lock> lock{mtx};
+  TSC_TRACE_LOCK_ACQUIRED();
 
   // Waits using a condition variable until the queue
   // is no longer full.
-  notFull.wait(lock, [this] { return !((fifo.size() == maxSize) && inUse); });
+  if (fifo.full() && inUse && !closed) {
+    TSC_USDT(wait_add_block, fifo.size());
+    TSC_TRACE(WaitAddBegin);
+    notFull.wait(lock, [this, &stopped] {
+      return !(fifo.full() && inUse && !closed) || stopped();
+    });
+    TSC_TRACE(WaitAddEnd);
+    TSC_USDT(wait_add_wake, fifo.size());
+  }
 
-  if ((fifo.size() == maxSize) && !inUse) {
+  if (fifo.full() && !inUse) {
     // Even if the queue is not in use, we need to
     // signal to potential writers blocked on
     // a full queue.
     notFull.notify_all();
   }
 
-  if (!inUse) {
+  if (!inUse || closed) {
+    TSC_USDT(wait_add_failure, fifo.size());
     throw ShutdownException("shutdown");
   }
 
-  fifo.push(item);
+  if (fifo.full()) {
+    TSC_RECORD_RESULT(TraceOutcome::Failure, fifo.size());
+    TSC_USDT(wait_add_cancel, fifo.size());
+    return false;
+  }
+
+  fifo.emplace(std::forward<U>(item));
+  TSC_RECORD_RESULT(TraceOutcome::Success, fifo.size());
+  TSC_USDT(wait_add_success, fifo.size());
   // We signal to potential readers in case
   // the queue was previously empty.
   if (fifo.size() == 1) {
+    TSC_TRACE(NotifyNotEmpty);
     notEmpty.notify_all();
   }
+  serveWaiters(done);
+  return true;
+}
+
+// The tryAdd method returns true if tryAdd succeeds
+// and false if tryAdd fails.
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::tryAdd(const T &item) {
+  return tryPush(item);
+}
+
+// The item is only moved from if tryAdd succeeds.
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::tryAdd(T &&item) {
+  return tryPush(std::move(item));
+}
+
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::waitAdd(const T &item) {
+  waitPush(item, [] { return false; });
+}
+
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::waitAdd(T &&item) {
+  waitPush(std::move(item), [] { return false; });
 }
 
 // The tryRemove method returns true if tryRemove succeeds
 // and false if tryRemove fails.
-template <typename T>
-bool ThreadSafeContainer<T>::tryRemove(T &item) {
-  std::lock_guard<std::mutex> lock{mtx};
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::tryRemove(T &item) {
+  Completions done;
+  TSC_RECORD_SCOPE(TraceOp::TryRemove);
+  TSC_USDT(try_remove_entry, 1u);
+  TSC_TRACE_LOCK_BEGIN();
+  std::lock_guard<Lock> lock{mtx};
+  TSC_TRACE_LOCK_ACQUIRED();
 
-  if (!inUse) {
+  if (!inUse || (closed && fifo.empty())) {
+    TSC_USDT(try_remove_failure, fifo.size());
     throw ShutdownException("shutdown");
   }
 
   if (fifo.empty()) {
+    TSC_RECORD_RESULT(TraceOutcome::Failure, fifo.size());
+    TSC_USDT(try_remove_failure, fifo.size());
     return false;
   } else {
-    item = fifo.front();
-    fifo.pop();
+    bool wasFull = fifo.full();
+    fifo.popInto(item);
+    TSC_RECORD_RESULT(TraceOutcome::Success, fifo.size());
+    TSC_USDT(try_remove_success, fifo.size());
     // We signal to potential writers in case
     // the queue was previously full.
-    if (fifo.size() == (maxSize - 1)) {
+    if (wasFull && !fifo.full()) {
+      TSC_TRACE(NotifyNotFull);
       notFull.notify_all();
     }
+    serveWaiters(done);
     return true;
   }
 }
 
-template <typename T>
-void ThreadSafeContainer<T>::waitRemove(T &item) {
-  std::unique_lock<std::mutex> lock{mtx};
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::waitRemove(T &item) {
+  waitPop(item, [] { return false; });
+}
+
+template <typename T, typename Lock>
+template <typename Stopped>
+bool ThreadSafeContainer<T, Lock>::waitPop(T &item, Stopped stopped) {
+  Completions done;
+  TSC_RECORD_SCOPE(TraceOp::WaitRemove);
+  TSC_USDT(wait_remove_entry, 1u);
+  TSC_TRACE_LOCK_BEGIN();
+  std::unique_lock<Lock> lock{mtx};
+  TSC_TRACE_LOCK_ACQUIRED();
 
   // Waits using a condition variable until the queue
   // is no longer empty.
-  notEmpty.wait(lock, [this] { return !(fifo.empty() && inUse); });
+  if (fifo.empty() && inUse && !closed) {
+    TSC_USDT(wait_remove_block, fifo.size());
+    TSC_TRACE(WaitRemoveBegin);
+    notEmpty.wait(lock, [this, &stopped] {
+      return !(fifo.empty() && inUse && !closed) || stopped();
+    });
+    TSC_TRACE(WaitRemoveEnd);
+    TSC_USDT(wait_remove_wake, fifo.size());
+  }
 
   if (fifo.empty() && !inUse) {
     // Even if the queue is not in use, we need to
@@ -101,37 +195,796 @@ void ThreadSafeContainer<T>::waitRemove(T &item) {
     notEmpty.notify_all();
   }
 
-  if (!inUse) {
+  if (fifo.empty() && inUse && !closed) {
+    TSC_RECORD_RESULT(TraceOutcome::Failure, fifo.size());
+    TSC_USDT(wait_remove_cancel, fifo.size());
+    return false;
+  }
+
+  if (!inUse || fifo.empty()) {
+    TSC_USDT(wait_remove_failure, fifo.size());
+    throw ShutdownException("shutdown");
+  }
+
+  bool wasFull = fifo.full();
+  fifo.popInto(item);
+  TSC_RECORD_RESULT(TraceOutcome::Success, fifo.size());
+  TSC_USDT(wait_remove_success, fifo.size());
+  // We signal to potential writers in case
+  // the queue was previously full.
+  if (wasFull && !fifo.full()) {
+    TSC_TRACE(NotifyNotFull);
+    notFull.notify_all();
+  }
+  serveWaiters(done);
+  return true;
+}
+
+template <typename T, typename Lock>
+template <template <typename> class Callback, typename Token, typename U>
+bool ThreadSafeContainer<T, Lock>::cancellableAdd(U &&item,
+                                                  const Token &token) {
+  auto wake = [this] {
+    std::lock_guard<Lock> lock{mtx};
+    notFull.notify_all();
+  };
+  Callback<decltype(wake)> onStop{token, wake};
+
+  return waitPush(std::forward<U>(item),
+                  [&token] { return token.stop_requested(); });
+}
+
+template <typename T, typename Lock>
+template <template <typename> class Callback, typename Token>
+bool ThreadSafeContainer<T, Lock>::cancellableRemove(T &item,
+                                                     const Token &token) {
+  auto wake = [this] {
+    std::lock_guard<Lock> lock{mtx};
+    notEmpty.notify_all();
+  };
+  Callback<decltype(wake)> onStop{token, wake};
+
+  return waitPop(item, [&token] { return token.stop_requested(); });
+}
+
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::waitAdd(const T &item,
+                                           const StopToken &token) {
+  return cancellableAdd<StopCallback>(item, token);
+}
+
+// The item is only moved from if waitAdd succeeds.
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::waitAdd(T &&item, const StopToken &token) {
+  return cancellableAdd<StopCallback>(std::move(item), token);
+}
+
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::waitRemove(T &item, const StopToken &token) {
+  return cancellableRemove<StopCallback>(item, token);
+}
+
+#ifdef __cpp_lib_jthread
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::waitAdd(const T &item,
+                                           const std::stop_token &token) {
+  return cancellableAdd<std::stop_callback>(item, token);
+}
+
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::waitAdd(T &&item,
+                                           const std::stop_token &token) {
+  return cancellableAdd<std::stop_callback>(std::move(item), token);
+}
+
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::waitRemove(T &item,
+                                              const std::stop_token &token) {
+  return cancellableRemove<std::stop_callback>(item, token);
+}
+#endif
+
+template <typename T, typename Lock>
+template <typename OutputIt>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::removeBulk(
+    OutputIt out, typename RingBuffer<T>::size_type maxItems,
+    Completions &done) {
+  typename RingBuffer<T>::size_type count{};
+  bool wasFull = fifo.full();
+
+  while (count < maxItems && !fifo.empty()) {
+    *out++ = std::move(fifo.front());
+    fifo.pop();
+    ++count;
+  }
+  // We signal to potential writers in case
+  // the queue was previously full.
+  if (wasFull && !fifo.full()) {
+    notFull.notify_all();
+  }
+  serveWaiters(done);
+  return count;
+}
+
+template <typename T, typename Lock>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::removeBulk(
+    T *out, typename RingBuffer<T>::size_type maxItems, Completions &done) {
+  bool wasFull = fifo.full();
+  typename RingBuffer<T>::size_type count = fifo.popBulk(out, maxItems);
+
+  // We signal to potential writers in case
+  // the queue was previously full.
+  if (wasFull && !fifo.full()) {
+    notFull.notify_all();
+  }
+  serveWaiters(done);
+  return count;
+}
+
+// The addBulk method adds as many items as there is room for.
+template <typename T, typename Lock>
+template <typename InputIt>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::addBulk(
+    InputIt first, typename RingBuffer<T>::size_type count,
+    Completions &done) {
+  typename RingBuffer<T>::size_type room = maxSize - fifo.occupancy();
+  typename RingBuffer<T>::size_type added = std::min(count, room);
+  bool wasEmpty = fifo.empty();
+
+  if (added > 0u) {
+    fifo.pushBulk(first, added);
+  }
+  // We signal to potential readers in case
+  // the queue was previously empty.
+  if (wasEmpty && !fifo.empty()) {
+    notEmpty.notify_all();
+  }
+  serveWaiters(done);
+  return added;
+}
+
+// Freeing the slots of the yielded items may make room for writers and
+// pending additions, whose items are then available at once.
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::holdBulk(
+    T *out, typename RingBuffer<T>::size_type maxItems,
+    typename RingBuffer<T>::size_type yielded,
+    typename RingBuffer<T>::size_type &count) {
+  Completions done;
+  std::unique_lock<Lock> lock{mtx};
+  bool wasFull = fifo.full();
+
+  fifo.unhold(yielded);
+  if (wasFull && !fifo.full()) {
+    notFull.notify_all();
+  }
+  serveWaiters(done);
+
+  if (fifo.empty() && inUse && !closed) {
+    notEmpty.wait(lock,
+                  [this] { return !(fifo.empty() && inUse && !closed); });
+  }
+
+  if (!inUse || fifo.empty()) {
+    throw ShutdownException("shutdown");
+  }
+
+  while (count < maxItems && !fifo.empty()) {
+    new (out + count) T(std::move(fifo.front()));
+    fifo.pop();
+    fifo.hold(1u);
+    ++count;
+  }
+}
+
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::restore(
+    T *items, typename RingBuffer<T>::size_type count,
+    typename RingBuffer<T>::size_type held) {
+  Completions done;
+  std::lock_guard<Lock> lock{mtx};
+  bool wasEmpty = fifo.empty();
+  bool wasFull = fifo.full();
+
+  std::exception_ptr error;
+
+  fifo.unhold(held - count);
+  try {
+    fifo.restore(items, count);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // We signal to potential readers and writers
+  // in case the queue was previously empty or full.
+  if (wasEmpty && !fifo.empty()) {
+    notEmpty.notify_all();
+  }
+  if (wasFull && !fifo.full()) {
+    notFull.notify_all();
+  }
+  serveWaiters(done);
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+// The tryAddBulk method returns the number of items added,
+// which is lower than count if the queue gets full.
+template <typename T, typename Lock>
+template <typename InputIt>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::tryAddBulk(
+    InputIt first, typename RingBuffer<T>::size_type count) {
+  Completions done;
+  std::lock_guard<Lock> lock{mtx};
+
+  if (!inUse || closed) {
+    throw ShutdownException("shutdown");
+  }
+
+  return addBulk(first, count, done);
+}
+
+// The waitAddBulk method adds the items as room is made. Items
+// added before a shutdown remain in the queue.
+template <typename T, typename Lock>
+template <typename InputIt>
+void ThreadSafeContainer<T, Lock>::waitAddBulk(
+    InputIt first, typename RingBuffer<T>::size_type count) {
+  Completions done;
+  TSC_USDT(wait_add_bulk_entry, count);
+  std::unique_lock<Lock> lock{mtx};
+
+  while (count > 0u) {
+    if (fifo.full() && inUse && !closed) {
+      TSC_USDT(wait_add_bulk_block, fifo.size());
+      notFull.wait(lock,
+                   [this] { return !(fifo.full() && inUse && !closed); });
+      TSC_USDT(wait_add_bulk_wake, fifo.size());
+    }
+
+    if (!inUse || closed) {
+      TSC_USDT(wait_add_bulk_failure, fifo.size());
+      throw ShutdownException("shutdown");
+    }
+
+    typename RingBuffer<T>::size_type added = addBulk(first, count, done);
+    std::advance(first, added);
+    count -= added;
+  }
+  TSC_USDT(wait_add_bulk_success, fifo.size());
+}
+
+// The tryRemoveBulk method returns 0 if the queue is empty.
+template <typename T, typename Lock>
+template <typename OutputIt>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::tryRemoveBulk(
+    OutputIt out, typename RingBuffer<T>::size_type maxItems) {
+  Completions done;
+  std::lock_guard<Lock> lock{mtx};
+
+  if (!inUse || (closed && fifo.empty())) {
+    throw ShutdownException("shutdown");
+  }
+
+  return removeBulk(out, maxItems, done);
+}
+
+// The waitRemoveBulk method waits until at least one item is available.
+template <typename T, typename Lock>
+template <typename OutputIt>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::waitRemoveBulk(
+    OutputIt out, typename RingBuffer<T>::size_type maxItems) {
+  Completions done;
+  TSC_USDT(wait_remove_bulk_entry, maxItems);
+  std::unique_lock<Lock> lock{mtx};
+
+  if (fifo.empty() && inUse && !closed) {
+    TSC_USDT(wait_remove_bulk_block, fifo.size());
+    notEmpty.wait(lock,
+                  [this] { return !(fifo.empty() && inUse && !closed); });
+    TSC_USDT(wait_remove_bulk_wake, fifo.size());
+  }
+
+  if (!inUse || fifo.empty()) {
+    TSC_USDT(wait_remove_bulk_failure, fifo.size());
+    throw ShutdownException("shutdown");
+  }
+
+  typename RingBuffer<T>::size_type count = removeBulk(out, maxItems, done);
+  TSC_USDT(wait_remove_bulk_success, fifo.size());
+  return count;
+}
+
+template <typename T, typename Lock>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::tryRemoveBulk(
+    T *out, typename RingBuffer<T>::size_type maxItems) {
+  Completions done;
+  std::lock_guard<Lock> lock{mtx};
+
+  if (!inUse || (closed && fifo.empty())) {
+    throw ShutdownException("shutdown");
+  }
+
+  return removeBulk(out, maxItems, done);
+}
+
+template <typename T, typename Lock>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::waitRemoveBulk(
+    T *out, typename RingBuffer<T>::size_type maxItems) {
+  Completions done;
+  TSC_USDT(wait_remove_bulk_entry, maxItems);
+  std::unique_lock<Lock> lock{mtx};
+
+  if (fifo.empty() && inUse && !closed) {
+    TSC_USDT(wait_remove_bulk_block, fifo.size());
+    notEmpty.wait(lock,
+                  [this] { return !(fifo.empty() && inUse && !closed); });
+    TSC_USDT(wait_remove_bulk_wake, fifo.size());
+  }
+
+  if (!inUse || fifo.empty()) {
+    TSC_USDT(wait_remove_bulk_failure, fifo.size());
     throw ShutdownException("shutdown");
   }
 
-  item = fifo.front();
-  fifo.pop();
+  typename RingBuffer<T>::size_type count = removeBulk(out, maxItems, done);
+  TSC_USDT(wait_remove_bulk_success, fifo.size());
+  return count;
+}
+
+template <typename T, typename Lock>
+ThreadSafeContainer<T, Lock>::AddSlot::AddSlot(AddSlot &&src) noexcept
+    : owner{src.owner},
+      position{src.position},
+      constructed{src.constructed} {
+  src.owner = nullptr;
+}
+
+template <typename T, typename Lock>
+typename ThreadSafeContainer<T, Lock>::AddSlot &
+ThreadSafeContainer<T, Lock>::AddSlot::operator=(AddSlot &&rhs) noexcept {
+  std::swap(owner, rhs.owner);
+  std::swap(position, rhs.position);
+  std::swap(constructed, rhs.constructed);
+  return *this;
+}
+
+template <typename T, typename Lock>
+ThreadSafeContainer<T, Lock>::AddSlot::~AddSlot() {
+  if (owner != nullptr) {
+    if (constructed) {
+      get()->~T();
+    }
+    owner->finishAdd(position, false);
+  }
+}
+
+template <typename T, typename Lock>
+template <typename... Args>
+T &ThreadSafeContainer<T, Lock>::AddSlot::emplace(Args &&... args) {
+  if (constructed) {
+    get()->~T();
+    constructed = false;
+  }
+  new (get()) T(std::forward<Args>(args)...);
+  constructed = true;
+  return *get();
+}
+
+template <typename T, typename Lock>
+ThreadSafeContainer<T, Lock>::RemoveSlot::RemoveSlot(RemoveSlot &&src) noexcept
+    : owner{src.owner}, position{src.position} {
+  src.owner = nullptr;
+}
+
+template <typename T, typename Lock>
+typename ThreadSafeContainer<T, Lock>::RemoveSlot &
+ThreadSafeContainer<T, Lock>::RemoveSlot::operator=(RemoveSlot &&rhs) noexcept {
+  std::swap(owner, rhs.owner);
+  std::swap(position, rhs.position);
+  return *this;
+}
+
+template <typename T, typename Lock>
+ThreadSafeContainer<T, Lock>::RemoveSlot::~RemoveSlot() {
+  if (owner != nullptr) {
+    owner->release(*this);
+  }
+}
+
+// The finishAdd method publishes or cancels a reserved slot. Either
+// way, earlier reservations may be published along with it, and
+// cancelled slots at the front may give space back.
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::finishAdd(
+    typename RingBuffer<T>::size_type position, bool commit) {
+  Completions done;
+  std::lock_guard<Lock> lock{mtx};
+  bool wasEmpty = fifo.empty();
+  bool wasFull = fifo.full();
+
+  if (commit) {
+    fifo.commit(position);
+  } else {
+    fifo.cancel(position);
+  }
+  if (wasEmpty && !fifo.empty()) {
+    notEmpty.notify_all();
+  }
+  if (wasFull && !fifo.full()) {
+    notFull.notify_all();
+  }
+  serveWaiters(done);
+}
+
+// The tryReserveAdd method returns an empty slot
+// handle if the queue is full.
+template <typename T, typename Lock>
+typename ThreadSafeContainer<T, Lock>::AddSlot
+ThreadSafeContainer<T, Lock>::tryReserveAdd() {
+  std::lock_guard<Lock> lock{mtx};
+
+  if (!inUse || closed) {
+    throw ShutdownException("shutdown");
+  }
+
+  if (fifo.full()) {
+    return AddSlot{};
+  }
+  return AddSlot{this, fifo.reserve()};
+}
+
+template <typename T, typename Lock>
+typename ThreadSafeContainer<T, Lock>::AddSlot
+ThreadSafeContainer<T, Lock>::reserveAdd() {
+  TSC_USDT(reserve_add_entry, 1u);
+  std::unique_lock<Lock> lock{mtx};
+
+  if (fifo.full() && inUse && !closed) {
+    TSC_USDT(reserve_add_block, fifo.size());
+    notFull.wait(lock,
+                 [this] { return !(fifo.full() && inUse && !closed); });
+    TSC_USDT(reserve_add_wake, fifo.size());
+  }
+
+  if (!inUse || closed) {
+    TSC_USDT(reserve_add_failure, fifo.size());
+    throw ShutdownException("shutdown");
+  }
+
+  AddSlot slot{this, fifo.reserve()};
+  TSC_USDT(reserve_add_success, fifo.size());
+  return slot;
+}
+
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::waitNotFull() {
+  std::unique_lock<Lock> lock{mtx};
+
+  notFull.wait(lock, [this] { return !(fifo.full() && inUse && !closed); });
+  if (!inUse || closed) {
+    throw ShutdownException("shutdown");
+  }
+}
+
+// The commitAdd method publishes the item of the slot, which must
+// have been constructed in place unless T is trivially default
+// constructible. Items reserved earlier are published first.
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::commitAdd(AddSlot &slot) {
+  if (!std::is_trivially_default_constructible<T>::value &&
+      !slot.constructed) {
+    slot.emplace();
+  }
+  finishAdd(slot.position, true);
+  slot.owner = nullptr;
+}
+
+// The tryPeekRemove method returns an empty slot
+// handle if the queue is empty.
+template <typename T, typename Lock>
+typename ThreadSafeContainer<T, Lock>::RemoveSlot
+ThreadSafeContainer<T, Lock>::tryPeekRemove() {
+  std::lock_guard<Lock> lock{mtx};
+
+  if (!inUse || (closed && fifo.empty())) {
+    throw ShutdownException("shutdown");
+  }
+
+  if (fifo.empty()) {
+    return RemoveSlot{};
+  }
+  return RemoveSlot{this, fifo.acquire()};
+}
+
+template <typename T, typename Lock>
+typename ThreadSafeContainer<T, Lock>::RemoveSlot
+ThreadSafeContainer<T, Lock>::peekRemove() {
+  TSC_USDT(peek_remove_entry, 1u);
+  std::unique_lock<Lock> lock{mtx};
+
+  if (fifo.empty() && inUse && !closed) {
+    TSC_USDT(peek_remove_block, fifo.size());
+    notEmpty.wait(lock,
+                  [this] { return !(fifo.empty() && inUse && !closed); });
+    TSC_USDT(peek_remove_wake, fifo.size());
+  }
+
+  if (!inUse || fifo.empty()) {
+    TSC_USDT(peek_remove_failure, fifo.size());
+    throw ShutdownException("shutdown");
+  }
+
+  RemoveSlot slot{this, fifo.acquire()};
+  TSC_USDT(peek_remove_success, fifo.size());
+  return slot;
+}
+
+// The release method destroys the item of the slot
+// and gives the slot back to producers.
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::release(RemoveSlot &slot) {
+  Completions done;
+  std::lock_guard<Lock> lock{mtx};
+  bool wasFull = fifo.full();
+
+  fifo.release(slot.position);
+  slot.owner = nullptr;
   // We signal to potential writers in case
   // the queue was previously full.
-  if (fifo.size() == (maxSize - 1)) {
+  if (wasFull && !fifo.full()) {
     notFull.notify_all();
   }
+  serveWaiters(done);
 }
 
 // The shutdown method prevents producer threads to
 // add data to the queue, and prevents consumer
-// threads to remove data from the queue.
-template <typename T>
-void ThreadSafeContainer<T>::shutdown() {
-  std::lock_guard<std::mutex> lock{mtx};
+// threads to remove data from the queue. Pending
+// asynchronous requests fail.
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::shutdown() {
+  Completions done;
+  TSC_RECORD_SCOPE(TraceOp::Shutdown);
+  std::lock_guard<Lock> lock{mtx};
+  TSC_RECORD_RESULT(TraceOutcome::Success, fifo.size());
+  TSC_TRACE(Shutdown);
+  TSC_USDT(shutdown, fifo.size());
 
   inUse = false;
+  failWaiters(addWaiters, done);
+  failWaiters(removeWaiters, done);
   notEmpty.notify_all();
   notFull.notify_all();
 }
 
+// The close method prevents producer threads to add
+// data to the queue, while consumer threads keep on
+// removing the remaining data. Once the queue is
+// drained, removals throw a ShutdownException.
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::close() {
+  Completions done;
+  std::lock_guard<Lock> lock{mtx};
+
+  closed = true;
+  failWaiters(addWaiters, done);
+  serveWaiters(done);
+  notEmpty.notify_all();
+  notFull.notify_all();
+}
+
+template <typename T, typename Lock>
+template <typename Callback>
+struct ThreadSafeContainer<T, Lock>::AsyncAddCallback : AsyncAdd {
+  Callback callback;
+
+  AsyncAddCallback(const T &item, Callback &&function)
+      : AsyncAdd{item}, callback{std::move(function)} {}
+
+  void complete() override { callback(this->error); }
+};
+
+template <typename T, typename Lock>
+template <typename Callback>
+struct ThreadSafeContainer<T, Lock>::AsyncRemoveCallback : AsyncRemove {
+  Callback callback;
+
+  explicit AsyncRemoveCallback(Callback &&function)
+      : callback{std::move(function)} {}
+
+  void complete() override { callback(this->error, std::move(this->item)); }
+};
+
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::WaiterList::push(AsyncWaiter *waiter) {
+  waiter->next = nullptr;
+  if (tail == nullptr) {
+    head = waiter;
+  } else {
+    tail->next = waiter;
+  }
+  tail = waiter;
+}
+
+template <typename T, typename Lock>
+typename ThreadSafeContainer<T, Lock>::AsyncWaiter *
+ThreadSafeContainer<T, Lock>::WaiterList::pop() {
+  AsyncWaiter *waiter = head;
+
+  head = waiter->next;
+  if (head == nullptr) {
+    tail = nullptr;
+  }
+  return waiter;
+}
+
+template <typename T, typename Lock>
+ThreadSafeContainer<T, Lock>::Completions::~Completions() {
+  while (!this->empty()) {
+    std::unique_ptr<AsyncWaiter> waiter{this->pop()};
+    waiter->complete();
+  }
+}
+
+// The serveWaitersSlow method hands items over to the pending removals
+// and room over to the pending additions, for as long as either makes
+// progress, since serving one kind may allow serving the other.
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::serveWaitersSlow(Completions &done) {
+  bool wasEmpty = fifo.empty();
+  bool wasFull = fifo.full();
+  bool progress{true};
+
+  while (progress) {
+    progress = false;
+    while (!removeWaiters.empty() && !fifo.empty()) {
+      auto waiter = static_cast<AsyncRemove *>(removeWaiters.pop());
+      fifo.popInto(waiter->item);
+      done.push(waiter);
+      progress = true;
+    }
+    while (!addWaiters.empty() && !fifo.full()) {
+      auto waiter = static_cast<AsyncAdd *>(addWaiters.pop());
+      try {
+        fifo.push(std::move(waiter->item));
+        progress = true;
+      } catch (...) {
+        waiter->error = std::current_exception();
+      }
+      done.push(waiter);
+    }
+  }
+  if (closed && fifo.empty()) {
+    failWaiters(removeWaiters, done);
+  }
+
+  if (wasEmpty && !fifo.empty()) {
+    notEmpty.notify_all();
+  }
+  if (wasFull && !fifo.full()) {
+    notFull.notify_all();
+  }
+}
+
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::failWaiters(WaiterList &waiters,
+                                               Completions &done) {
+  while (!waiters.empty()) {
+    AsyncWaiter *waiter = waiters.pop();
+    waiter->error = std::make_exception_ptr(ShutdownException("shutdown"));
+    done.push(waiter);
+  }
+}
+
+template <typename T, typename Lock>
+template <typename Callback>
+void ThreadSafeContainer<T, Lock>::asyncAdd(const T &item, Callback callback) {
+  Completions done;
+  std::exception_ptr error;
+  TSC_USDT(async_add_entry, 1u);
+  {
+    std::lock_guard<Lock> lock{mtx};
+
+    if (!inUse || closed) {
+      TSC_USDT(async_add_failure, fifo.size());
+      error = std::make_exception_ptr(ShutdownException("shutdown"));
+    } else if (fifo.full() || !addWaiters.empty()) {
+      addWaiters.push(
+          new AsyncAddCallback<Callback>{item, std::move(callback)});
+      TSC_USDT(async_add_block, fifo.size());
+      return;
+    } else {
+      fifo.push(item);
+      TSC_USDT(async_add_success, fifo.size());
+      // We signal to potential readers in case
+      // the queue was previously empty.
+      if (fifo.size() == 1) {
+        notEmpty.notify_all();
+      }
+      serveWaiters(done);
+    }
+  }
+  callback(error);
+}
+
+template <typename T, typename Lock>
+Future<void> ThreadSafeContainer<T, Lock>::asyncAdd(const T &item) {
+  Promise<void> promise;
+  Future<void> future = promise.getFuture();
+
+  asyncAdd(item, [promise = std::move(promise)](
+                     std::exception_ptr error) mutable {
+    if (error) {
+      promise.setException(error);
+    } else {
+      promise.setValue();
+    }
+  });
+  return future;
+}
+
+template <typename T, typename Lock>
+template <typename Callback>
+void ThreadSafeContainer<T, Lock>::asyncRemove(Callback callback) {
+  Completions done;
+  std::exception_ptr error;
+  T item{};
+  TSC_USDT(async_remove_entry, 1u);
+  {
+    std::lock_guard<Lock> lock{mtx};
+
+    if (!inUse || (closed && fifo.empty())) {
+      TSC_USDT(async_remove_failure, fifo.size());
+      error = std::make_exception_ptr(ShutdownException("shutdown"));
+    } else if (fifo.empty() || !removeWaiters.empty()) {
+      removeWaiters.push(
+          new AsyncRemoveCallback<Callback>{std::move(callback)});
+      TSC_USDT(async_remove_block, fifo.size());
+      return;
+    } else {
+      bool wasFull = fifo.full();
+      fifo.popInto(item);
+      TSC_USDT(async_remove_success, fifo.size());
+      // We signal to potential writers in case
+      // the queue was previously full.
+      if (wasFull && !fifo.full()) {
+        notFull.notify_all();
+      }
+      serveWaiters(done);
+    }
+  }
+  callback(error, std::move(item));
+}
+
+template <typename T, typename Lock>
+Future<T> ThreadSafeContainer<T, Lock>::asyncRemove() {
+  Promise<T> promise;
+  Future<T> future = promise.getFuture();
+
+  asyncRemove([promise = std::move(promise)](std::exception_ptr error,
+                                             T &&item) mutable {
+    if (error) {
+      promise.setException(error);
+    } else {
+      promise.setValue(std::move(item));
+    }
+  });
+  return future;
+}
+
+template <typename T, typename Lock>
+ConsumeRange<T, Lock> ThreadSafeContainer<T, Lock>::consume(
+    typename RingBuffer<T>::size_type batch) {
+  return ConsumeRange<T, Lock>{*this, batch};
+}
+
 // The clear method removes any elements present
 // within the queue. This method will do nothing
 // when called while the queue is still in use.
-template <typename T>
-void ThreadSafeContainer<T>::clear() {
-  std::lock_guard<std::mutex> lock{mtx};
+template <typename T, typename Lock>
+void ThreadSafeContainer<T, Lock>::clear() {
+  std::lock_guard<Lock> lock{mtx};
 
   if (!inUse) {
     while (!fifo.empty()) {
@@ -142,25 +995,25 @@ void ThreadSafeContainer<T>::clear() {
   }
 }
 
-template <typename T>
-typename std::queue<T>::size_type ThreadSafeContainer<T>::size() const {
-  std::lock_guard<std::mutex> lock{mtx};
-  typename std::queue<T>::size_type size = fifo.size();
+template <typename T, typename Lock>
+typename RingBuffer<T>::size_type ThreadSafeContainer<T, Lock>::size() const {
+  std::lock_guard<Lock> lock{mtx};
+  typename RingBuffer<T>::size_type size = fifo.size();
 
   return size;
 }
 
-template <typename T>
-bool ThreadSafeContainer<T>::empty() const {
-  std::lock_guard<std::mutex> lock{mtx};
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::empty() const {
+  std::lock_guard<Lock> lock{mtx};
 
   return fifo.empty();
 }
 
-template <typename T>
-bool ThreadSafeContainer<T>::full() const {
-  std::lock_guard<std::mutex> lock{mtx};
+template <typename T, typename Lock>
+bool ThreadSafeContainer<T, Lock>::full() const {
+  std::lock_guard<Lock> lock{mtx};
 
-  return (fifo.size() == maxSize);
+  return fifo.full();
 }
 }  // namespace TSC
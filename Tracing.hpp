@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace TSC {
+namespace Tracing {
+enum class Probe : std::uint8_t {
+  WaitAddBegin,
+  WaitAddEnd,
+  WaitRemoveBegin,
+  WaitRemoveEnd,
+  LockAcquire,
+  NotifyNotFull,
+  NotifyNotEmpty,
+  Shutdown
+};
+
+// The ticks function reads the time stamp counter where available and
+// falls back to the steady clock in nanoseconds elsewhere.
+inline std::uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+#endif
+}
+
+struct Record {
+  std::uint64_t ticks;
+  // Lock acquisition events carry their duration in ticks.
+  std::uint64_t duration;
+  const void *queue;
+  Probe probe;
+};
+
+// The Tracer owns one fixed size ring buffer per thread. Recording an event
+// is a counter read, a store into the ring and a release increment, without
+// any lock. When a ring wraps around, the oldest events are overwritten.
+// The flush method must run once the traced threads are quiescent.
+class Tracer {
+ private:
+  static constexpr std::size_t RING_SIZE{1u << 14};
+
+  struct Ring {
+    explicit Ring(std::uint32_t id) : thread{id} {}
+
+    std::uint32_t thread;
+    std::atomic<std::uint64_t> head{0u};
+    Record records[RING_SIZE];
+  };
+
+  std::mutex mtx;
+  std::vector<std::unique_ptr<Ring>> rings;
+  std::uint64_t originTicks{ticks()};
+  std::chrono::steady_clock::time_point originTime{
+      std::chrono::steady_clock::now()};
+
+  Tracer() = default;
+
+  Ring &localRing() {
+    static thread_local Ring *ring{nullptr};
+
+    if (ring == nullptr) {
+      std::lock_guard<std::mutex> lock{mtx};
+      rings.emplace_back(new Ring{static_cast<std::uint32_t>(rings.size())});
+      ring = rings.back().get();
+    }
+    return *ring;
+  }
+
+  static const char *name(Probe probe) {
+    switch (probe) {
+      case Probe::WaitAddBegin:
+      case Probe::WaitAddEnd:
+        return "waitAdd";
+      case Probe::WaitRemoveBegin:
+      case Probe::WaitRemoveEnd:
+        return "waitRemove";
+      case Probe::LockAcquire:
+        return "lock";
+      case Probe::NotifyNotFull:
+        return "notifyNotFull";
+      case Probe::NotifyNotEmpty:
+        return "notifyNotEmpty";
+      case Probe::Shutdown:
+        return "shutdown";
+    }
+    return "unknown";
+  }
+
+  static const char *phase(Probe probe) {
+    switch (probe) {
+      case Probe::WaitAddBegin:
+      case Probe::WaitRemoveBegin:
+        return "B";
+      case Probe::WaitAddEnd:
+      case Probe::WaitRemoveEnd:
+        return "E";
+      case Probe::LockAcquire:
+        return "X";
+      default:
+        return "i";
+    }
+  }
+
+ public:
+  Tracer(const Tracer &src) = delete;
+
+  Tracer &operator=(const Tracer &rhs) = delete;
+
+  static Tracer &instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  void record(Probe probe, const void *queue, std::uint64_t duration = 0u) {
+    Ring &ring = localRing();
+    std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+
+    ring.records[head & (RING_SIZE - 1u)] =
+        Record{ticks(), duration, queue, probe};
+    ring.head.store(head + 1u, std::memory_order_release);
+  }
+
+  // The writeChromeTrace method converts the retained events to the Chrome
+  // trace event JSON format, which chrome://tracing and the Perfetto UI both
+  // load. Tick counts are converted to microseconds using the elapsed steady
+  // clock time since the tracer was created.
+  void writeChromeTrace(const std::string &path) {
+    std::lock_guard<std::mutex> lock{mtx};
+    std::ofstream out{path};
+    if (!out) {
+      throw std::runtime_error("cannot open trace file " + path);
+    }
+
+    double elapsedUs = std::chrono::duration<double, std::micro>(
+                           std::chrono::steady_clock::now() - originTime)
+                           .count();
+    std::uint64_t elapsedTicks = std::max<std::uint64_t>(
+        ticks() - originTicks, static_cast<std::uint64_t>(1u));
+    double usPerTick = elapsedUs / static_cast<double>(elapsedTicks);
+    bool first{true};
+
+    out << "{\"traceEvents\":[\n";
+    for (auto &ring : rings) {
+      std::uint64_t head = ring->head.load(std::memory_order_acquire);
+      std::uint64_t begin = head > RING_SIZE ? head - RING_SIZE : 0u;
+
+      for (std::uint64_t i{begin}; i < head; ++i) {
+        const Record &record = ring->records[i & (RING_SIZE - 1u)];
+        // Complete events are stamped once the lock is obtained, so their
+        // start is recovered from the duration.
+        double ts = static_cast<double>(record.ticks - record.duration -
+                                        originTicks) *
+                    usPerTick;
+
+        out << (first ? "" : ",\n") << "{\"name\":\"" << name(record.probe)
+            << "\",\"ph\":\"" << phase(record.probe) << "\",\"ts\":" << ts
+            << ",\"pid\":1,\"tid\":" << ring->thread;
+        if (record.probe == Probe::LockAcquire) {
+          out << ",\"dur\":"
+              << static_cast<double>(record.duration) * usPerTick;
+        } else if (*phase(record.probe) == 'i') {
+          out << ",\"s\":\"t\"";
+        }
+        out << ",\"args\":{\"queue\":\"" << record.queue << "\"}}";
+        first = false;
+      }
+    }
+    out << "\n]}\n";
+  }
+};
+
+// The LockProbe measures how long a thread waited to obtain the container
+// lock. It is constructed right before locking and stamped right after.
+class LockProbe {
+ private:
+  Tracer &tracer;
+  std::uint64_t start;
+
+ public:
+  LockProbe() : tracer{Tracer::instance()}, start{ticks()} {}
+
+  void acquired(const void *queue) {
+    tracer.record(Probe::LockAcquire, queue, ticks() - start);
+  }
+};
+}  // namespace Tracing
+}  // namespace TSC
+
+// The tracing probes compile to nothing unless TSC_ENABLE_TRACING is
+// defined.
+#ifdef TSC_ENABLE_TRACING
+#define TSC_TRACE(probe) \
+  ::TSC::Tracing::Tracer::instance().record(::TSC::Tracing::Probe::probe, this)
+#define TSC_TRACE_LOCK_BEGIN() ::TSC::Tracing::LockProbe tscLockProbe
+#define TSC_TRACE_LOCK_ACQUIRED() tscLockProbe.acquired(this)
+#else
+#define TSC_TRACE(probe) \
+  do {                   \
+  } while (false)
+#define TSC_TRACE_LOCK_BEGIN() \
+  do {                         \
+  } while (false)
+#define TSC_TRACE_LOCK_ACQUIRED() \
+  do {                            \
+  } while (false)
+#endif
@@ -0,0 +1,78 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "ThreadSafeContainer.hpp"
+
+#ifndef TSC_ENABLE_TRACING
+#error "TracingTest requires TSC_ENABLE_TRACING"
+#endif
+
+constexpr size_t NB_OPERATIONS{1000u};
+constexpr size_t NB_ITEMS{4u};
+
+size_t count(const std::string &text, const std::string &pattern) {
+  size_t occurrences{};
+
+  for (auto pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + pattern.size())) {
+    ++occurrences;
+  }
+  return occurrences;
+}
+
+int main() {
+  {
+    TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+
+    // A reader slow to start forces the writer to block in waitAdd.
+    std::thread reader{[&mtq] {
+      int item;
+      try {
+        for (size_t i{};; ++i) {
+          if (i < NB_ITEMS) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+          }
+          mtq.waitRemove(item);
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    }};
+    for (size_t i{}; i < NB_OPERATIONS; ++i) {
+      mtq.waitAdd(static_cast<int>(i));
+    }
+    while (!mtq.empty()) {
+      std::this_thread::yield();
+    }
+    mtq.shutdown();
+    reader.join();
+  }
+
+  const char *path = "TracingTest.json";
+  TSC::Tracing::Tracer::instance().writeChromeTrace(path);
+
+  std::ifstream in{path};
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  std::string json = buffer.str();
+  std::remove(path);
+
+  assert(json.compare(0, 16, "{\"traceEvents\":[") == 0);
+  assert(count(json, "\"name\":\"waitAdd\",\"ph\":\"B\"") > 0u);
+  assert(count(json, "\"name\":\"waitAdd\",\"ph\":\"B\"") ==
+         count(json, "\"name\":\"waitAdd\",\"ph\":\"E\""));
+  assert(count(json, "\"name\":\"waitRemove\",\"ph\":\"B\"") ==
+         count(json, "\"name\":\"waitRemove\",\"ph\":\"E\""));
+  assert(count(json, "\"name\":\"lock\",\"ph\":\"X\"") >= 2u * NB_OPERATIONS);
+  assert(count(json, "\"name\":\"shutdown\"") == 2u);
+
+  std::cout << "trace holds " << count(json, "\"ph\"") << " events"
+            << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Locks.hpp"
+#include "ThreadSafeContainer.hpp"
+
+namespace TSC {
+// The TwoLockContainer is a bounded FIFO queue with the blocking and
+// non-blocking API of ThreadSafeContainer, where producers and consumers
+// take separate locks, in the spirit of the two-lock queue of Michael and
+// Scott, so that both ends of the preallocated ring proceed in parallel.
+// The producer lock guards the tail and the consumer lock the head, and
+// the occupancy is an atomic count, whose release and acquire order the
+// construction of an item before its removal, and its destruction before
+// its slot is reused.
+//
+// Each side waits on a condition variable tied to its own lock. A side
+// that makes the queue leave the empty or full state takes the lock of
+// the other side to signal it, after releasing its own lock, so that the
+// signal cannot slip in between the check of the count by a waiter and
+// its wait. The other lock is only taken when a waiter announced itself
+// before checking the count, sequentially consistent operations on both
+// counters ensuring that either the waiter sees the new count or the
+// signaling side sees the waiter. Waiters are woken up one at a time, and
+// cascade the signal to the next waiter while the queue is neither empty
+// nor full.
+template <typename T, typename Lock = std::mutex>
+class TwoLockContainer {
+ public:
+  using size_type = std::size_t;
+
+ private:
+  using Condition = typename detail::ConditionFor<Lock>::type;
+  using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  size_type maxSize;
+  std::unique_ptr<Storage[]> storage;
+  std::atomic<bool> inUse{true};
+  std::atomic<bool> closed{false};
+
+  alignas(64) std::atomic<size_type> count{0u};
+  std::atomic<size_type> sleepingWriters{0u};
+  std::atomic<size_type> sleepingReaders{0u};
+
+  alignas(64) Lock tailMtx;
+  Condition notFull;
+  size_type tail{0u};
+
+  alignas(64) Lock headMtx;
+  Condition notEmpty;
+  size_type head{0u};
+
+  T *slot(size_type position) {
+    return reinterpret_cast<T *>(&storage[position]);
+  }
+
+  size_type next(size_type position) const {
+    return position + 1u < maxSize ? position + 1u : 0u;
+  }
+
+  template <typename U>
+  bool tryPush(U &&item);
+
+  template <typename U>
+  void waitPush(U &&item);
+
+  // The push and pop methods are called under the producer and consumer
+  // locks, on a queue that is not full and not empty.
+  template <typename U>
+  void push(U &&item, std::unique_lock<Lock> &lock);
+
+  void pop(T &item, std::unique_lock<Lock> &lock);
+
+  void signalNotEmpty();
+
+  void signalNotFull();
+
+ public:
+  explicit TwoLockContainer(size_type capacity);
+
+  ~TwoLockContainer();
+
+  TwoLockContainer(const TwoLockContainer<T, Lock> &src) = delete;
+
+  TwoLockContainer<T, Lock> &operator=(
+      const TwoLockContainer<T, Lock> &rhs) = delete;
+
+  bool tryAdd(const T &item);
+
+  bool tryAdd(T &&item);
+
+  void waitAdd(const T &item);
+
+  void waitAdd(T &&item);
+
+  bool tryRemove(T &item);
+
+  void waitRemove(T &item);
+
+  void shutdown();
+
+  void close();
+
+  void clear();
+
+  size_type size() const;
+
+  bool empty() const;
+
+  bool full() const;
+};
+}  // namespace TSC
+
+#include "TwoLockContainerPrivate.hpp"
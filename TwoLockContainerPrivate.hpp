@@ -0,0 +1,233 @@
+#pragma once
+
+namespace TSC {
+template <typename T, typename Lock>
+TwoLockContainer<T, Lock>::TwoLockContainer(size_type capacity)
+    : maxSize{capacity}, storage{new Storage[capacity > 0u ? capacity : 1u]} {}
+
+template <typename T, typename Lock>
+TwoLockContainer<T, Lock>::~TwoLockContainer() {
+  size_type position{head};
+
+  for (size_type n = count.load(std::memory_order_acquire); n > 0u; --n) {
+    slot(position)->~T();
+    position = next(position);
+  }
+}
+
+template <typename T, typename Lock>
+template <typename U>
+void TwoLockContainer<T, Lock>::push(U &&item, std::unique_lock<Lock> &lock) {
+  try {
+    new (slot(tail)) T(std::forward<U>(item));
+  } catch (...) {
+    // A writer woken up for a free slot hands it over to the next one
+    // when its item cannot be built.
+    if (count.load() < maxSize) {
+      notFull.notify_one();
+    }
+    throw;
+  }
+  tail = next(tail);
+
+  size_type previous = count.fetch_add(1u);
+  // We cascade the signal to the next writer
+  // while the queue is not full.
+  if (previous + 1u < maxSize) {
+    notFull.notify_one();
+  }
+  lock.unlock();
+  // We signal to potential readers in case
+  // the queue was previously empty.
+  if (previous == 0u && sleepingReaders.load() > 0u) {
+    signalNotEmpty();
+  }
+}
+
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::pop(T &item, std::unique_lock<Lock> &lock) {
+  T *source = slot(head);
+  item = std::move(*source);
+  source->~T();
+  head = next(head);
+
+  size_type previous = count.fetch_sub(1u);
+  if (previous > 1u) {
+    notEmpty.notify_one();
+  }
+  lock.unlock();
+  // We signal to potential writers in case
+  // the queue was previously full.
+  if (previous == maxSize && sleepingWriters.load() > 0u) {
+    signalNotFull();
+  }
+}
+
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::signalNotEmpty() {
+  std::lock_guard<Lock> lock{headMtx};
+
+  notEmpty.notify_one();
+}
+
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::signalNotFull() {
+  std::lock_guard<Lock> lock{tailMtx};
+
+  notFull.notify_one();
+}
+
+template <typename T, typename Lock>
+template <typename U>
+bool TwoLockContainer<T, Lock>::tryPush(U &&item) {
+  std::unique_lock<Lock> lock{tailMtx};
+
+  if (!inUse.load(std::memory_order_relaxed) ||
+      closed.load(std::memory_order_relaxed)) {
+    throw ShutdownException("shutdown");
+  }
+
+  if (count.load(std::memory_order_acquire) == maxSize) {
+    return false;
+  }
+  push(std::forward<U>(item), lock);
+  return true;
+}
+
+template <typename T, typename Lock>
+template <typename U>
+void TwoLockContainer<T, Lock>::waitPush(U &&item) {
+  std::unique_lock<Lock> lock{tailMtx};
+
+  sleepingWriters.fetch_add(1u);
+  notFull.wait(lock, [this] {
+    return count.load() < maxSize || !inUse.load(std::memory_order_relaxed) ||
+           closed.load(std::memory_order_relaxed);
+  });
+  sleepingWriters.fetch_sub(1u, std::memory_order_relaxed);
+
+  if (!inUse.load(std::memory_order_relaxed) ||
+      closed.load(std::memory_order_relaxed)) {
+    throw ShutdownException("shutdown");
+  }
+
+  push(std::forward<U>(item), lock);
+}
+
+template <typename T, typename Lock>
+bool TwoLockContainer<T, Lock>::tryAdd(const T &item) {
+  return tryPush(item);
+}
+
+// The item is only moved from if tryAdd succeeds.
+template <typename T, typename Lock>
+bool TwoLockContainer<T, Lock>::tryAdd(T &&item) {
+  return tryPush(std::move(item));
+}
+
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::waitAdd(const T &item) {
+  waitPush(item);
+}
+
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::waitAdd(T &&item) {
+  waitPush(std::move(item));
+}
+
+template <typename T, typename Lock>
+bool TwoLockContainer<T, Lock>::tryRemove(T &item) {
+  std::unique_lock<Lock> lock{headMtx};
+  size_type items = count.load(std::memory_order_acquire);
+
+  if (!inUse.load(std::memory_order_relaxed) ||
+      (closed.load(std::memory_order_relaxed) && items == 0u)) {
+    throw ShutdownException("shutdown");
+  }
+
+  if (items == 0u) {
+    return false;
+  }
+  pop(item, lock);
+  return true;
+}
+
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::waitRemove(T &item) {
+  std::unique_lock<Lock> lock{headMtx};
+
+  sleepingReaders.fetch_add(1u);
+  notEmpty.wait(lock, [this] {
+    return count.load() > 0u || !inUse.load(std::memory_order_relaxed) ||
+           closed.load(std::memory_order_relaxed);
+  });
+  sleepingReaders.fetch_sub(1u, std::memory_order_relaxed);
+
+  if (!inUse.load(std::memory_order_relaxed) ||
+      count.load(std::memory_order_acquire) == 0u) {
+    throw ShutdownException("shutdown");
+  }
+
+  pop(item, lock);
+}
+
+// The flags are set before each lock is taken in turn to wake the
+// waiters up, so that a waiter either sees them or is already waiting.
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::shutdown() {
+  inUse.store(false, std::memory_order_relaxed);
+  {
+    std::lock_guard<Lock> lock{headMtx};
+    notEmpty.notify_all();
+  }
+  std::lock_guard<Lock> lock{tailMtx};
+  notFull.notify_all();
+}
+
+// After close, additions fail while removals drain the queue.
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::close() {
+  closed.store(true, std::memory_order_relaxed);
+  {
+    std::lock_guard<Lock> lock{headMtx};
+    notEmpty.notify_all();
+  }
+  std::lock_guard<Lock> lock{tailMtx};
+  notFull.notify_all();
+}
+
+// The clear method removes any elements present within the queue. This
+// method will do nothing when called while the queue is still in use.
+// It is the only method holding both locks, and takes them in a fixed
+// order, which needs no try_lock from the lock type.
+template <typename T, typename Lock>
+void TwoLockContainer<T, Lock>::clear() {
+  std::lock_guard<Lock> consumer{headMtx};
+  std::lock_guard<Lock> producer{tailMtx};
+
+  if (inUse.load(std::memory_order_relaxed)) {
+    return;
+  }
+  for (size_type n = count.load(std::memory_order_acquire); n > 0u; --n) {
+    slot(head)->~T();
+    head = next(head);
+  }
+  count.store(0u, std::memory_order_release);
+}
+
+template <typename T, typename Lock>
+typename TwoLockContainer<T, Lock>::size_type TwoLockContainer<T, Lock>::size()
+    const {
+  return count.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Lock>
+bool TwoLockContainer<T, Lock>::empty() const {
+  return size() == 0u;
+}
+
+template <typename T, typename Lock>
+bool TwoLockContainer<T, Lock>::full() const {
+  return size() == maxSize;
+}
+}  // namespace TSC
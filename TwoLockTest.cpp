@@ -0,0 +1,209 @@
+#include <cassert>
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "TwoLockContainer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{4u};
+constexpr size_t NB_READER_THREADS{4u};
+constexpr size_t NB_MESSAGES{5000u};
+
+void sequential() {
+  TSC::TwoLockContainer<int> mtq{2u};
+  int item;
+
+  assert(mtq.empty() && !mtq.tryRemove(item));
+  assert(mtq.tryAdd(1) && mtq.tryAdd(2) && !mtq.tryAdd(3));
+  assert(mtq.full() && mtq.size() == 2u);
+  assert(mtq.tryRemove(item) && item == 1);
+  assert(mtq.tryAdd(3));
+  mtq.waitRemove(item);
+  assert(item == 2);
+  mtq.waitRemove(item);
+  assert(item == 3 && mtq.empty());
+
+  TSC::TwoLockContainer<std::unique_ptr<int>> pointers{1u};
+  std::unique_ptr<int> first{new int{1}}, second{new int{2}};
+  assert(pointers.tryAdd(std::move(first)) && !first);
+  assert(!pointers.tryAdd(std::move(second)) && second);
+}
+
+// Items left in the ring are destroyed with it, or by clear after a
+// shutdown.
+void lifetime() {
+  auto tracked = std::make_shared<int>(0);
+  {
+    TSC::TwoLockContainer<std::shared_ptr<int>> mtq{4u};
+    mtq.waitAdd(tracked);
+    mtq.waitAdd(tracked);
+    assert(tracked.use_count() == 3);
+    mtq.clear();
+    assert(tracked.use_count() == 3);
+    mtq.shutdown();
+    mtq.clear();
+    assert(tracked.use_count() == 1 && mtq.empty());
+  }
+  {
+    TSC::TwoLockContainer<std::shared_ptr<int>> mtq{2u};
+    std::shared_ptr<int> item;
+    mtq.waitAdd(tracked);
+    mtq.waitRemove(item);
+    mtq.waitAdd(tracked);
+    mtq.waitAdd(tracked);
+    assert(tracked.use_count() == 4);
+  }
+  assert(tracked.use_count() == 1);
+}
+
+void closeAndShutdown() {
+  TSC::TwoLockContainer<int> mtq{1u};
+  int item;
+
+  mtq.waitAdd(1);
+  std::thread writer{[&mtq] {
+    bool failed{false};
+    try {
+      mtq.waitAdd(2);
+    } catch (const TSC::ShutdownException &e) {
+      failed = true;
+    }
+    assert(failed);
+    (void)failed;
+  }};
+  mtq.close();
+  writer.join();
+  mtq.waitRemove(item);
+  assert(item == 1);
+  bool failed{false};
+  try {
+    mtq.waitRemove(item);
+  } catch (const TSC::ShutdownException &e) {
+    failed = true;
+  }
+  assert(failed);
+
+  TSC::TwoLockContainer<int> open{1u};
+  std::thread reader{[&open] {
+    int item;
+    bool failed{false};
+    try {
+      open.waitRemove(item);
+    } catch (const TSC::ShutdownException &e) {
+      failed = true;
+    }
+    assert(failed);
+    (void)failed;
+  }};
+  open.shutdown();
+  reader.join();
+}
+
+// An item whose copy throws when its value is negative.
+struct Fragile {
+  int value;
+
+  explicit Fragile(int value) : value{value} {}
+
+  Fragile(const Fragile &src) : value{src.value} {
+    if (value < 0) {
+      throw std::runtime_error("copy");
+    }
+  }
+
+  Fragile &operator=(const Fragile &rhs) = default;
+};
+
+// A woken writer whose item fails to be built passes the free slot on to
+// the next sleeping writer. The writers sleep in turn, so that the failing
+// one is woken first.
+void failedConstruction() {
+  TSC::TwoLockContainer<Fragile> mtq{1u};
+  Fragile item{0};
+
+  mtq.waitAdd(Fragile{1});
+  std::thread failing{[&mtq] {
+    try {
+      mtq.waitAdd(Fragile{-1});
+      assert(false);
+    } catch (const std::runtime_error &e) {
+    } catch (const TSC::ShutdownException &e) {
+    }
+  }};
+  std::this_thread::sleep_for(std::chrono::milliseconds{50});
+  std::thread writer{[&mtq] { mtq.waitAdd(Fragile{2}); }};
+  std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+  mtq.waitRemove(item);
+  assert(item.value == 1);
+  writer.join();
+  mtq.waitRemove(item);
+  assert(item.value == 2);
+  mtq.shutdown();
+  failing.join();
+}
+
+// A small capacity keeps the queue switching between empty and full,
+// where the signals cross the two locks.
+template <typename Lock>
+void concurrent(size_t capacity) {
+  TSC::TwoLockContainer<size_t, Lock> mtq{capacity};
+  std::vector<std::thread> writers, readers;
+  std::vector<size_t> sums(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      for (size_t n{1}; n <= NB_MESSAGES; ++n) {
+        mtq.waitAdd(n);
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &sums, r] {
+      size_t item;
+      try {
+        for (;;) {
+          mtq.waitRemove(item);
+          sums[r] += item;
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+  // clear takes both locks, which must not need try_lock.
+  mtq.shutdown();
+  mtq.clear();
+  assert(mtq.empty());
+
+  size_t total{};
+  for (auto sum : sums) {
+    total += sum;
+  }
+  assert(total == NB_WRITER_THREADS * NB_MESSAGES * (NB_MESSAGES + 1u) / 2u);
+}
+
+int main() {
+  sequential();
+  lifetime();
+  closeAndShutdown();
+  failedConstruction();
+  concurrent<std::mutex>(1u);
+  concurrent<std::mutex>(64u);
+  concurrent<TSC::AdaptiveMutex>(3u);
+  concurrent<TSC::ClhLock>(3u);
+
+  std::cout << "two lock passed" << std::endl;
+
+  return 0;
+}
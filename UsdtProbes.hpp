@@ -0,0 +1,31 @@
+#pragma once
+
+// USDT probes let bpftrace, perf or SystemTap attach to the container in a
+// running process without rebuilding it. Each probe site compiles to a single
+// nop plus an ELF note describing its arguments, which are the queue address
+// and its occupancy. The entry probes fire before the lock is taken, so that
+// the time spent blocked on it shows between entry and success, and receive
+// the number of items requested instead, which needs no lock. For instance:
+//
+//   bpftrace -e 'usdt:./TSCTest:tsc:wait_remove_block { @[tid] = nsecs; }
+//                usdt:./TSCTest:tsc:wait_remove_wake /@[tid]/ {
+//                  @wait = hist(nsecs - @[tid]); delete(@[tid]); }'
+//
+// The probes are emitted when TSC_ENABLE_USDT is defined and <sys/sdt.h> is
+// available, which on Debian based systems is part of systemtap-sdt-dev.
+#if defined(TSC_ENABLE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define TSC_USDT_AVAILABLE 1
+#endif
+#endif
+
+#ifdef TSC_USDT_AVAILABLE
+#define TSC_USDT(name, value)                               \
+  DTRACE_PROBE2(tsc, name, static_cast<const void *>(this), \
+                static_cast<unsigned long>(value))
+#else
+#define TSC_USDT(name, value) \
+  do {                        \
+  } while (false)
+#endif
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace TSC {
+enum class TraceOp : std::uint8_t {
+  TryAdd,
+  WaitAdd,
+  TryRemove,
+  WaitRemove,
+  Shutdown
+};
+
+enum class TraceOutcome : std::uint8_t { Success, Failure, Shutdown };
+
+// A compact binary record describing one container call. The timestamp is
+// the call entry time in nanoseconds relative to the recorder start, the
+// duration covers the whole call including any blocking, and the occupancy
+// is the number of queued elements observed under the container lock.
+struct TraceEvent {
+  std::uint64_t timestamp;
+  std::uint32_t duration;
+  std::uint32_t occupancy;
+  std::uint16_t thread;
+  TraceOp op;
+  TraceOutcome outcome;
+};
+
+using Trace = std::vector<TraceEvent>;
+
+// The Recorder collects TraceEvents from every thread calling into a
+// ThreadSafeContainer. Each thread appends to its own chunked buffer, so
+// recording never takes a lock once a thread is registered. Buffers outlive
+// their threads and are only released by reset(), which must not run
+// concurrently with recording.
+class Recorder {
+ private:
+  static constexpr std::uint32_t CHUNK_EVENTS{4096u};
+
+  struct Chunk {
+    TraceEvent events[CHUNK_EVENTS];
+    std::atomic<std::uint32_t> count{0u};
+    std::atomic<Chunk *> next{nullptr};
+  };
+
+  struct ThreadBuffer {
+    explicit ThreadBuffer(std::uint16_t id)
+        : thread{id}, head{new Chunk}, tail{head} {}
+
+    ~ThreadBuffer() {
+      Chunk *chunk = head;
+      while (chunk != nullptr) {
+        Chunk *next = chunk->next.load(std::memory_order_relaxed);
+        delete chunk;
+        chunk = next;
+      }
+    }
+
+    // Only the owning thread appends, readers follow the published counts.
+    void append(const TraceEvent &event) {
+      std::uint32_t count = tail->count.load(std::memory_order_relaxed);
+      if (count == CHUNK_EVENTS) {
+        Chunk *chunk = new Chunk;
+        tail->next.store(chunk, std::memory_order_release);
+        tail = chunk;
+        count = 0u;
+      }
+      tail->events[count] = event;
+      tail->count.store(count + 1u, std::memory_order_release);
+    }
+
+    std::uint16_t thread;
+    Chunk *head;
+    Chunk *tail;
+  };
+
+  std::atomic<bool> enabled{false};
+  std::atomic<std::uint64_t> generation{0u};
+  // The time origin in steady clock nanoseconds, atomic as start may run
+  // while other threads are recording.
+  std::atomic<std::int64_t> epoch{ticks()};
+  std::mutex mtx;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+  Recorder() = default;
+
+  static std::int64_t ticks() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  ThreadBuffer &localBuffer() {
+    struct Cache {
+      std::uint64_t generation;
+      ThreadBuffer *buffer;
+    };
+    static thread_local Cache cache{~std::uint64_t{0u}, nullptr};
+
+    std::uint64_t current = generation.load(std::memory_order_acquire);
+    if (cache.generation != current) {
+      std::lock_guard<std::mutex> lock{mtx};
+      buffers.emplace_back(
+          new ThreadBuffer{static_cast<std::uint16_t>(buffers.size())});
+      cache.buffer = buffers.back().get();
+      cache.generation = current;
+    }
+    return *cache.buffer;
+  }
+
+ public:
+  Recorder(const Recorder &src) = delete;
+
+  Recorder &operator=(const Recorder &rhs) = delete;
+
+  static Recorder &instance() {
+    static Recorder recorder;
+    return recorder;
+  }
+
+  bool active() const { return enabled.load(std::memory_order_relaxed); }
+
+  // The start method resets the time origin and enables recording.
+  void start() {
+    epoch.store(ticks(), std::memory_order_relaxed);
+    enabled.store(true, std::memory_order_release);
+  }
+
+  void stop() { enabled.store(false, std::memory_order_release); }
+
+  // The reset method drops every recorded event. Threads register a fresh
+  // buffer on their next recorded call.
+  void reset() {
+    std::lock_guard<std::mutex> lock{mtx};
+    buffers.clear();
+    generation.fetch_add(1u, std::memory_order_acq_rel);
+  }
+
+  // The now method reads the clock before the origin, and reports zero
+  // rather than wrapping around when start moved the origin in between.
+  std::uint64_t now() const {
+    std::int64_t current = ticks();
+    std::int64_t origin = epoch.load(std::memory_order_relaxed);
+    return current > origin ? static_cast<std::uint64_t>(current - origin)
+                            : 0u;
+  }
+
+  void record(TraceOp op, TraceOutcome outcome, std::uint64_t start,
+              std::size_t occupancy) {
+    ThreadBuffer &buffer = localBuffer();
+    std::uint64_t end = now();
+    std::uint64_t elapsed =
+        std::min<std::uint64_t>(end > start ? end - start : 0u, UINT32_MAX);
+
+    buffer.append(TraceEvent{start, static_cast<std::uint32_t>(elapsed),
+                             static_cast<std::uint32_t>(occupancy),
+                             buffer.thread, op, outcome});
+  }
+
+  // The snapshot method returns every event published so far, grouped by
+  // thread and ordered by entry time within each thread.
+  Trace snapshot() {
+    std::lock_guard<std::mutex> lock{mtx};
+    Trace trace;
+
+    for (auto &buffer : buffers) {
+      const Chunk *chunk = buffer->head;
+      while (chunk != nullptr) {
+        std::uint32_t count = chunk->count.load(std::memory_order_acquire);
+        trace.insert(trace.end(), chunk->events, chunk->events + count);
+        chunk = chunk->next.load(std::memory_order_acquire);
+      }
+    }
+    return trace;
+  }
+};
+
+// The RecordScope captures the entry time of a container call and records
+// the event when the call returns or throws. Calls leaving through an
+// exception are recorded with a Shutdown outcome.
+class RecordScope {
+ private:
+  TraceOp op;
+  TraceOutcome outcome;
+  std::size_t occupancy;
+  std::uint64_t start;
+  bool active;
+
+ public:
+  explicit RecordScope(TraceOp operation)
+      : op{operation},
+        outcome{TraceOutcome::Shutdown},
+        occupancy{0u},
+        start{0u},
+        active{Recorder::instance().active()} {
+    if (active) {
+      start = Recorder::instance().now();
+    }
+  }
+
+  ~RecordScope() {
+    if (active) {
+      Recorder::instance().record(op, outcome, start, occupancy);
+    }
+  }
+
+  RecordScope(const RecordScope &src) = delete;
+
+  RecordScope &operator=(const RecordScope &rhs) = delete;
+
+  void set(TraceOutcome result, std::size_t size) {
+    outcome = result;
+    occupancy = size;
+  }
+};
+
+namespace TraceFile {
+constexpr char MAGIC[4]{'T', 'S', 'C', 'T'};
+constexpr std::uint32_t VERSION{1u};
+
+inline void save(const std::string &path, const Trace &trace) {
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> file{
+      std::fopen(path.c_str(), "wb"), &std::fclose};
+  if (!file) {
+    throw std::runtime_error("cannot open trace file " + path);
+  }
+
+  std::uint64_t count = trace.size();
+  bool ok = std::fwrite(MAGIC, sizeof(MAGIC), 1, file.get()) == 1 &&
+            std::fwrite(&VERSION, sizeof(VERSION), 1, file.get()) == 1 &&
+            std::fwrite(&count, sizeof(count), 1, file.get()) == 1 &&
+            std::fwrite(trace.data(), sizeof(TraceEvent), trace.size(),
+                        file.get()) == trace.size();
+  if (!ok) {
+    throw std::runtime_error("cannot write trace file " + path);
+  }
+}
+
+inline Trace load(const std::string &path) {
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> file{
+      std::fopen(path.c_str(), "rb"), &std::fclose};
+  if (!file) {
+    throw std::runtime_error("cannot open trace file " + path);
+  }
+
+  char magic[4];
+  std::uint32_t version{};
+  std::uint64_t count{};
+  if (std::fread(magic, sizeof(magic), 1, file.get()) != 1 ||
+      std::fread(&version, sizeof(version), 1, file.get()) != 1 ||
+      std::fread(&count, sizeof(count), 1, file.get()) != 1 ||
+      !std::equal(magic, magic + sizeof(magic), MAGIC) || version != VERSION) {
+    throw std::runtime_error("invalid trace file " + path);
+  }
+
+  Trace trace(count);
+  if (std::fread(trace.data(), sizeof(TraceEvent), trace.size(), file.get()) !=
+      trace.size()) {
+    throw std::runtime_error("truncated trace file " + path);
+  }
+  return trace;
+}
+}  // namespace TraceFile
+}  // namespace TSC
+
+// The recording probes compile to nothing unless TSC_ENABLE_RECORDER is
+// defined, in which case they still cost a single relaxed load per call
+// until Recorder::instance().start() is invoked.
+#ifdef TSC_ENABLE_RECORDER
+#define TSC_RECORD_SCOPE(op) ::TSC::RecordScope tscRecordScope{op}
+#define TSC_RECORD_RESULT(outcome, size) tscRecordScope.set(outcome, size)
+#else
+#define TSC_RECORD_SCOPE(op) \
+  do {                       \
+  } while (false)
+#define TSC_RECORD_RESULT(outcome, size) \
+  do {                                   \
+  } while (false)
+#endif
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+#include "WorkloadRecorder.hpp"
+
+namespace TSC {
+struct ReplayStats {
+  std::size_t threads{};
+  std::size_t operations{};
+  std::size_t successes{};
+  std::size_t failures{};
+  std::size_t shutdowns{};
+  // Accumulated time spent inside waitAdd and waitRemove calls.
+  std::chrono::nanoseconds blocked{};
+  std::chrono::nanoseconds elapsed{};
+};
+
+// The replay function drives a container with the calls of a recorded
+// trace. One thread is spawned per recorded thread, and every call is
+// issued at its recorded offset from the start of the replay, scaled by
+// the speed factor. Any container exposing tryAdd, waitAdd, tryRemove,
+// waitRemove and shutdown over T can be replayed against, so queue
+// variants can be compared on the same traffic shape.
+template <typename Container, typename T>
+ReplayStats replay(const Trace &trace, Container &container, const T &item,
+                   double speed = 1.0) {
+  std::map<std::uint16_t, std::vector<TraceEvent>> perThread;
+  for (const auto &event : trace) {
+    perThread[event.thread].push_back(event);
+  }
+
+  std::atomic<std::size_t> successes{0u}, failures{0u}, shutdowns{0u};
+  std::atomic<std::int64_t> blocked{0};
+  auto start = std::chrono::steady_clock::now();
+
+  auto play = [&](std::vector<TraceEvent> &events) {
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TraceEvent &lhs, const TraceEvent &rhs) {
+                       return lhs.timestamp < rhs.timestamp;
+                     });
+    T value{item};
+
+    try {
+      for (const auto &event : events) {
+        std::this_thread::sleep_until(
+            start + std::chrono::nanoseconds{static_cast<std::int64_t>(
+                        static_cast<double>(event.timestamp) / speed)});
+
+        bool status{true};
+        auto begin = std::chrono::steady_clock::now();
+        switch (event.op) {
+          case TraceOp::TryAdd:
+            status = container.tryAdd(value);
+            break;
+          case TraceOp::WaitAdd:
+            container.waitAdd(value);
+            break;
+          case TraceOp::TryRemove:
+            status = container.tryRemove(value);
+            break;
+          case TraceOp::WaitRemove:
+            container.waitRemove(value);
+            break;
+          case TraceOp::Shutdown:
+            container.shutdown();
+            break;
+        }
+        if (event.op == TraceOp::WaitAdd || event.op == TraceOp::WaitRemove) {
+          blocked += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - begin)
+                         .count();
+        }
+        ++(status ? successes : failures);
+      }
+    } catch (const ShutdownException &e) {
+      ++shutdowns;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (auto &entry : perThread) {
+    threads.emplace_back(play, std::ref(entry.second));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  ReplayStats stats;
+  stats.threads = perThread.size();
+  stats.successes = successes;
+  stats.failures = failures;
+  stats.shutdowns = shutdowns;
+  stats.operations = stats.successes + stats.failures + stats.shutdowns;
+  stats.blocked = std::chrono::nanoseconds{blocked.load()};
+  stats.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  return stats;
+}
+}  // namespace TSC
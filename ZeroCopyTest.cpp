@@ -0,0 +1,143 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ThreadSafeContainer.hpp"
+
+constexpr size_t NB_WRITER_THREADS{3u};
+constexpr size_t NB_READER_THREADS{3u};
+constexpr size_t NB_MESSAGES{3000u};
+constexpr size_t NB_ITEMS{8u};
+constexpr size_t PAYLOAD{1024u};
+
+struct Message {
+  unsigned id;
+  char payload[PAYLOAD];
+};
+
+// Reservations are published in reservation order, whatever
+// the order of the commits.
+void commitOrder() {
+  TSC::ThreadSafeContainer<int> mtq{NB_ITEMS};
+  int item;
+
+  auto first = mtq.reserveAdd();
+  auto second = mtq.reserveAdd();
+  *second.get() = 2;
+  mtq.commitAdd(second);
+  assert(mtq.empty());
+  bool removed = mtq.tryRemove(item);
+  assert(!removed);
+
+  *first.get() = 1;
+  mtq.commitAdd(first);
+  assert(mtq.size() == 2u);
+  removed = mtq.tryRemove(item);
+  assert(removed && item == 1);
+  removed = mtq.tryRemove(item);
+  assert(removed && item == 2);
+}
+
+void cancellation() {
+  TSC::ThreadSafeContainer<std::string> mtq{3u};
+  std::string item;
+
+  auto first = mtq.reserveAdd();
+  {
+    auto abandoned = mtq.reserveAdd();
+    abandoned.emplace("abandoned");
+  }
+  auto third = mtq.reserveAdd();
+  assert(mtq.full());
+  third.emplace("third");
+  mtq.commitAdd(third);
+  first.emplace("first");
+  mtq.commitAdd(first);
+
+  bool removed = mtq.tryRemove(item);
+  assert(removed && item == "first");
+  removed = mtq.tryRemove(item);
+  assert(removed && item == "third");
+  assert(mtq.empty() && !mtq.full());
+}
+
+// Slots processed in place keep their capacity until released.
+void peekRelease() {
+  TSC::ThreadSafeContainer<int> mtq{2u};
+  int item;
+
+  mtq.waitAdd(1);
+  mtq.waitAdd(2);
+  auto peeked = mtq.peekRemove();
+  assert(*peeked == 1);
+  bool removed = mtq.tryRemove(item);
+  assert(removed && item == 2);
+  assert(mtq.full());
+  bool added = mtq.tryAdd(3);
+  assert(!added);
+  assert(!mtq.tryReserveAdd());
+
+  mtq.release(peeked);
+  assert(!peeked);
+  added = mtq.tryAdd(3);
+  assert(added);
+}
+
+void concurrent() {
+  TSC::ThreadSafeContainer<Message> mtq{NB_ITEMS};
+  std::vector<std::thread> writers, readers;
+  std::vector<unsigned long> sums(NB_READER_THREADS, 0u);
+
+  for (size_t w{}; w < NB_WRITER_THREADS; ++w) {
+    writers.emplace_back([&mtq] {
+      for (unsigned n{1}; n <= NB_MESSAGES; ++n) {
+        auto slot = mtq.reserveAdd();
+        Message *message = slot.get();
+        message->id = n;
+        std::memset(message->payload, static_cast<int>(n & 0xff), PAYLOAD);
+        mtq.commitAdd(slot);
+      }
+    });
+  }
+  for (size_t r{}; r < NB_READER_THREADS; ++r) {
+    readers.emplace_back([&mtq, &sums, r] {
+      try {
+        for (;;) {
+          auto slot = mtq.peekRemove();
+          assert(slot->payload[PAYLOAD - 1u] ==
+                 static_cast<char>(slot->id & 0xff));
+          sums[r] += slot->id;
+        }
+      } catch (const TSC::ShutdownException &e) {
+      }
+    });
+  }
+
+  for (auto &t : writers) {
+    t.join();
+  }
+  mtq.close();
+  for (auto &t : readers) {
+    t.join();
+  }
+
+  unsigned long total{};
+  for (auto sum : sums) {
+    total += sum;
+  }
+  assert(total == NB_WRITER_THREADS * NB_MESSAGES * (NB_MESSAGES + 1u) / 2u);
+}
+
+int main() {
+  commitOrder();
+  cancellation();
+  peekRelease();
+  concurrent();
+
+  std::cout << "zero copy passed" << std::endl;
+
+  return 0;
+}